@@ -0,0 +1,57 @@
+#ifndef BENCH_HH
+#define BENCH_HH
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * @brief Keep the compiler from optimizing away a computed value.
+ */
+template <typename T>
+inline void do_not_optimize(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @brief Stream the benchmarks print their results to, stdout by default.
+ */
+inline std::FILE *&benchmark_output()
+{
+    static std::FILE *output = stdout;
+    return output;
+}
+
+/**
+ * @brief Run a function repeatedly and print the average time per call to benchmark_output().
+ * @param name Name of the benchmark.
+ * @param fn Function to measure.
+ * @param min_seconds Minimum time to run the function for.
+ * @return Average time per call in nanoseconds.
+ */
+template <typename F>
+double run_benchmark(const char *name, F &&fn, double min_seconds = 0.5)
+{
+    using clock = std::chrono::steady_clock;
+    uint64_t iterations = 1;
+    while (true)
+    {
+        auto start = clock::now();
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            fn();
+        }
+        double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        if (elapsed >= min_seconds)
+        {
+            double ns = elapsed * 1e9 / iterations;
+            std::fprintf(benchmark_output(), "%-40s %14.2f ns %12llu iterations\n", name, ns, static_cast<unsigned long long>(iterations));
+            return ns;
+        }
+        iterations = static_cast<uint64_t>(iterations * (elapsed > 0.01 ? std::max(2.0, min_seconds / elapsed * 1.2) : 10.0));
+    }
+}
+
+#endif
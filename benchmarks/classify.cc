@@ -0,0 +1,52 @@
+#include <string>
+#include <vector>
+#include <definitions.hh>
+#include "bench.hh"
+
+// The classification the lexer did before the perfect hash, kept as a baseline.
+static WordClass linear_classify(std::string_view x)
+{
+    if (std::find(DATA_TYPES.begin(), DATA_TYPES.end(), x) != DATA_TYPES.end())
+    {
+        return WordClass::DATATYPE;
+    }
+    if (std::find(KEYWORDS.begin(), KEYWORDS.end(), x) != KEYWORDS.end())
+    {
+        return WordClass::KEYWORD;
+    }
+    if (std::find(ARCH_SPECIFIC_TYPES.begin(), ARCH_SPECIFIC_TYPES.end(), x) != ARCH_SPECIFIC_TYPES.end())
+    {
+        return WordClass::ARCH_DATATYPE;
+    }
+    return WordClass::IDENTIFIER;
+}
+
+int main()
+{
+    // Roughly the mix found in source code, mostly identifiers and a fair share of keywords and types.
+    static const char *identifiers[] = {"i", "x", "count", "buffer", "index", "length", "result", "node_count",
+                                        "parse_expression", "value", "tmp", "elf", "returns", "structure", "u", "matcher"};
+    std::vector<std::string> words;
+    for (int i = 0; i < 256; i++)
+    {
+        words.emplace_back(identifiers[i % std::size(identifiers)]);
+        words.emplace_back(KEYWORDS[i % KEYWORDS.size()]);
+        words.emplace_back(identifiers[(i * 7) % std::size(identifiers)]);
+        words.emplace_back(DATA_TYPES[i % DATA_TYPES.size()]);
+    }
+
+    std::printf("Classifying %zu words per iteration.\n", words.size());
+    run_benchmark("classify/linear", [&]()
+                  {
+        for (const auto &word : words)
+        {
+            do_not_optimize(linear_classify(word));
+        } });
+    run_benchmark("classify/perfect_hash", [&]()
+                  {
+        for (const auto &word : words)
+        {
+            do_not_optimize(classify_word(word).word_class);
+        } });
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include <string>
+#include <incremental.hh>
+#include "bench.hh"
+
+int main()
+{
+    for (int functions : {1000, 10000})
+    {
+        std::string source;
+        for (int i = 0; i < functions; i++)
+        {
+            std::string n = std::to_string(i);
+            source += "fn function" + n + "(i32 a, i32 b) {\n    i32 x = a + b * " + n + ";\n    loop { break; }\n}\n\n";
+        }
+
+        SourceManager sources;
+        FileID file = sources.addBuffer(source, "bench.zx");
+        PrintGlobalState print(sources);
+        StringInterner names;
+        IncrementalSession session(sources, file, names, print);
+
+        std::printf("%zu bytes, %d functions.\n", source.size(), functions);
+        std::string suffix = "/" + std::to_string(functions);
+        run_benchmark(("incremental/full_parse" + suffix).c_str(), [&]()
+                      { do_not_optimize(session.parse()); });
+
+        // Type a character into a function in the middle of the file and delete it again.
+        int_t offset = source.find("i32 x = a + b * " + std::to_string(functions / 2) + ";") + 5;
+        run_benchmark(("incremental/edit" + suffix).c_str(), [&]()
+                      {
+            do_not_optimize(session.applyEdit(TextEdit{offset, 0, "y"}));
+            do_not_optimize(session.applyEdit(TextEdit{offset, 1, ""})); });
+    }
+    return 0;
+}
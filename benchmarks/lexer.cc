@@ -0,0 +1,38 @@
+#include <string>
+#include <lexer.hh>
+#include <scan.hh>
+#include "bench.hh"
+
+int main()
+{
+    std::string source;
+    while (source.size() < 16 * 1024 * 1024)
+    {
+        source += "/* Compute the sum of the\n   first values. */\n"
+                  "fn accumulate_values(i32 count, i64 initial_value) -> i64 {\n"
+                  "    i64 result = initial_value;\n"
+                  "    loop {\n"
+                  "        // Stop once everything was added.\n"
+                  "        if (count == 0) {\n"
+                  "            break;\n"
+                  "        }\n"
+                  "        result = result + count * 3;\n"
+                  "        count -= 1;\n"
+                  "    }\n"
+                  "    ret result;\n"
+                  "}\n\n";
+    }
+
+    SourceManager sources;
+    FileID file = sources.addBuffer(source, "bench.zx");
+    PrintGlobalState print(sources);
+    StringInterner names;
+
+    std::printf("Lexing %zu bytes per iteration with %s kernels.\n", source.size(), get_scan_kernels().name);
+    double ns = run_benchmark("lexer/lex", [&]()
+                              {
+        Lexer lexer(sources, file, names, print);
+        do_not_optimize(lexer.lex().size()); }, 2.0);
+    std::printf("%-40s %14.2f MB/s\n", "lexer/lex", source.size() / ns * 1e3);
+    return 0;
+}
@@ -0,0 +1,295 @@
+#include <random>
+#include "corpus.hh"
+
+const std::vector<CorpusShape> &default_corpora()
+{
+    static const std::vector<CorpusShape> corpora = {
+        {"mixed", 6, 3, 4, 0},
+        {"many-functions", 2, 0, 2, 0},
+        {"deep-nesting", 2, 48, 3, 0},
+        {"long-expressions", 2, 1, 256, 0},
+        {"big-strings", 2, 1, 2, 8192},
+    };
+    return corpora;
+}
+
+namespace
+{
+    constexpr const char *TYPES[] = {"i8", "i16", "i32", "i64", "u8", "u16", "u32", "u64", "f32", "f64", "bool", "char"};
+    // The bitwise operators come last, they are the only ones not taking floating point operands.
+    constexpr const char *OPERATORS[] = {"+", "-", "*", "/", "%", "^", "<", ">=", "==", "!=", "&&", "||", "<<", ">>", "&", "|"};
+    constexpr size_t FLOAT_OPERATORS = 12;
+
+    bool is_float(const char *type)
+    {
+        return type[0] == 'f';
+    }
+
+    class Generator
+    {
+    public:
+        Generator(const CorpusShape &shape, uint32_t seed) : shape(shape), random(seed), next_name(0), loops(0) {}
+
+        void declaration(std::string &out)
+        {
+            // function_declaration | enum_declaration | struct_declaration, mostly functions.
+            switch (pick(8))
+            {
+            case 0:
+                enumeration(out);
+                break;
+            case 1:
+                structure(out);
+                break;
+            default:
+                function(out);
+                break;
+            }
+            out += '\n';
+        }
+
+    private:
+        struct Variable
+        {
+            std::string name;
+            bool is_float;
+        };
+
+        const CorpusShape &shape;
+        std::mt19937 random;
+        size_t next_name;
+        size_t loops;                    ///< Number of loops around the statements, break and continue need one.
+        std::vector<Variable> variables; ///< Variables in scope, innermost last.
+        std::string indent;
+
+        size_t pick(size_t n)
+        {
+            return std::uniform_int_distribution<size_t>(0, n - 1)(random);
+        }
+
+        std::string name(const char *prefix)
+        {
+            return prefix + std::to_string(next_name++);
+        }
+
+        void comment(std::string &out)
+        {
+            if (pick(4) == 0)
+            {
+                out += indent + "// " + name("note_") + " explains what happens next\n";
+            }
+            else if (pick(8) == 0)
+            {
+                out += indent + "/* " + name("block_") + "\n" + indent + "   spans two lines */\n";
+            }
+        }
+
+        void enumeration(std::string &out)
+        {
+            out += "enum " + name("Kind_") + " { ";
+            size_t fields = 2 + pick(6);
+            for (size_t i = 0; i < fields; i++)
+            {
+                out += (i ? ", " : "") + name("KIND_");
+            }
+            out += " }\n";
+        }
+
+        void structure(std::string &out)
+        {
+            out += "struct " + name("Record_") + " { ";
+            size_t fields = 1 + pick(6);
+            for (size_t i = 0; i < fields; i++)
+            {
+                out += std::string(i ? ", " : "") + TYPES[pick(std::size(TYPES))] + " " + name("field_");
+            }
+            out += " }\n";
+        }
+
+        void function(std::string &out)
+        {
+            comment(out);
+            out += "fn " + name("compute_") + "(";
+            size_t parameters = pick(4);
+            for (size_t i = 0; i < parameters; i++)
+            {
+                const char *type = TYPES[pick(std::size(TYPES))];
+                variables.push_back({name("arg_"), is_float(type)});
+                out += std::string(i ? ", " : "") + type + " " + variables.back().name;
+            }
+            out += ") -> i64 ";
+            block(out, shape.nesting, true);
+            variables.clear();
+        }
+
+        void block(std::string &out, size_t depth, bool returns)
+        {
+            size_t scope = variables.size();
+            out += "{\n";
+            indent += "    ";
+            if (shape.string_bytes && returns)
+            {
+                // A string literal has an array type, it is not assigned to a scalar.
+                out += indent + "\"";
+                for (size_t i = 0; i < shape.string_bytes; i++)
+                {
+                    out += static_cast<char>(i % 64 == 63 ? ' ' : 'a' + i % 26);
+                }
+                out += "\";\n";
+            }
+            for (size_t i = 0; i < shape.statements; i++)
+            {
+                comment(out);
+                statement(out);
+            }
+            if (depth > 0)
+            {
+                nested(out, depth - 1);
+            }
+            if (returns)
+            {
+                out += indent + "ret ";
+                expression(out, shape.expression_terms);
+                out += ";\n";
+            }
+            indent.resize(indent.size() - 4);
+            out += indent + "}";
+            variables.resize(scope);
+        }
+
+        void nested(std::string &out, size_t depth)
+        {
+            out += indent;
+            if (pick(2))
+            {
+                out += "if (";
+                expression(out, shape.expression_terms);
+                out += ") ";
+                block(out, depth, false);
+                if (pick(2))
+                {
+                    out += " elif (";
+                    expression(out, 2);
+                    out += ") ";
+                    block(out, 0, false);
+                }
+                if (pick(2))
+                {
+                    out += " else ";
+                    block(out, 0, false);
+                }
+            }
+            else
+            {
+                out += "loop ";
+                loops++;
+                block(out, depth, false);
+                loops--;
+            }
+            out += '\n';
+        }
+
+        void statement(std::string &out)
+        {
+            switch (pick(6))
+            {
+            case 0:
+                out += indent;
+                expression(out, shape.expression_terms);
+                out += ";\n";
+                break;
+            case 1:
+                if (loops)
+                {
+                    out += indent + (pick(2) ? "break;\n" : "continue;\n");
+                    break;
+                }
+                [[fallthrough]];
+            default:
+            {
+                // Declared after its initializer, which must not refer to it.
+                const char *type = TYPES[pick(std::size(TYPES))];
+                Variable variable = {name("value_"), is_float(type)};
+                out += indent + type + " " + variable.name + " = ";
+                expression(out, shape.expression_terms, variable.is_float);
+                out += ";\n";
+                variables.push_back(std::move(variable));
+                break;
+            }
+            }
+        }
+
+        // Initializing a floating point variable, every operand is floating point.
+        void expression(std::string &out, size_t terms, bool floating = false)
+        {
+            // The operands are picked first, once one is floating point no bitwise operator may join them.
+            std::vector<std::string> operands(terms);
+            for (std::string &text : operands)
+            {
+                floating |= operand(text);
+            }
+            size_t operators = floating ? FLOAT_OPERATORS : std::size(OPERATORS);
+            for (size_t i = 0; i < terms; i++)
+            {
+                if (i)
+                {
+                    out += std::string(" ") + OPERATORS[pick(operators)] + " ";
+                }
+                out += operands[i];
+            }
+        }
+
+        // Whether the operand is floating point.
+        bool operand(std::string &out)
+        {
+            switch (pick(8))
+            {
+            case 0:
+                out += std::to_string(pick(1000)) + "." + std::to_string(pick(100));
+                return true;
+            case 1:
+            {
+                // Parenthesized, "--" would be lexed as a decrement.
+                out += "-(";
+                bool floating = operand(out);
+                out += ")";
+                return floating;
+            }
+            case 2:
+            {
+                out += "(";
+                bool floating = operand(out);
+                out += " * ";
+                floating |= operand(out);
+                out += ")";
+                return floating;
+            }
+            case 3:
+            case 4:
+                out += std::to_string(pick(100000));
+                return false;
+            default:
+                if (variables.empty())
+                {
+                    out += std::to_string(pick(100));
+                    return false;
+                }
+                const Variable &variable = variables[pick(variables.size())];
+                out += variable.name;
+                return variable.is_float;
+            }
+        }
+    };
+}
+
+std::string generate_corpus(const CorpusShape &shape, size_t bytes, uint32_t seed)
+{
+    Generator generator(shape, seed);
+    std::string out;
+    out.reserve(bytes + bytes / 8);
+    while (out.size() < bytes)
+    {
+        generator.declaration(out);
+    }
+    return out;
+}
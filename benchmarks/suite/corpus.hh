@@ -0,0 +1,37 @@
+#ifndef CORPUS_HH
+#define CORPUS_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Shape of a generated Zurox source, every knob stresses another part of the frontend.
+ */
+struct CorpusShape
+{
+    const char *name;
+    size_t statements;       ///< Statements per block.
+    size_t nesting;          ///< Depth of the nested if and loop blocks of every function.
+    size_t expression_terms; ///< Operands of every expression.
+    size_t string_bytes;     ///< Size of the string literal every function contains, 0 for none.
+};
+
+/**
+ * @brief The corpora measured by default.
+ */
+const std::vector<CorpusShape> &default_corpora();
+
+/**
+ * @brief Generate a source of at least `bytes` bytes following the productions of grammar/zurox.ebnf.
+ *
+ * Only the productions the parser implements are generated, so every corpus
+ * parses without errors, and passes semantic analysis: break and continue only
+ * appear in loops and no operator is given operands it rejects. The literals
+ * are random, constant folding may still find them out of range. The same
+ * shape, size and seed always give the same source.
+ */
+std::string generate_corpus(const CorpusShape &shape, size_t bytes, uint32_t seed);
+
+#endif
@@ -0,0 +1,364 @@
+#include <fstream>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <ast_cache.hh>
+#include <ast_visitor.hh>
+#include <lexer.hh>
+#include <parser.hh>
+#include <scan.hh>
+#include <sema.hh>
+#include <table.hh>
+#include <threadpool.hh>
+#include "bench.hh"
+#include "corpus.hh"
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+
+static llvm::cl::opt<unsigned> SizeKB("size", llvm::cl::desc("Size of every generated corpus in KB."), llvm::cl::init(4096));
+static llvm::cl::opt<unsigned> Seed("seed", llvm::cl::desc("Seed of the corpus generator."), llvm::cl::init(1));
+static llvm::cl::opt<double> MinTime("min-time", llvm::cl::desc("Minimum time to run every benchmark for, in seconds."), llvm::cl::init(1.0));
+static llvm::cl::list<std::string> Corpora("corpus", llvm::cl::desc("Only measure the named corpus, may be repeated."), llvm::cl::value_desc("name"));
+static llvm::cl::opt<std::string> JSONOutput("json", llvm::cl::desc("Write the results as JSON to the file, - for stdout and the text report to stderr."), llvm::cl::value_desc("filename"));
+static llvm::cl::opt<std::string> DumpDirectory("dump", llvm::cl::desc("Write every generated corpus to the directory."), llvm::cl::value_desc("directory"));
+
+struct Result
+{
+    std::string benchmark;
+    std::string corpus;
+    double ns;
+    double bytes;   ///< Bytes processed per iteration, 0 if not measured in MB/s.
+    double items;   ///< Items processed per iteration.
+    const char *unit; ///< What the items are.
+};
+
+static std::vector<Result> results;
+
+static void report(const std::string &benchmark, const CorpusShape &shape, double ns, double bytes, double items, const char *unit)
+{
+    std::string name = benchmark + "/" + shape.name;
+    if (bytes)
+    {
+        std::fprintf(benchmark_output(), "%-40s %14.2f MB/s\n", name.c_str(), bytes / ns * 1e3);
+    }
+    std::fprintf(benchmark_output(), "%-40s %14.0f %s/s\n", name.c_str(), items / ns * 1e9, unit);
+    results.push_back({benchmark, shape.name, ns, bytes, items, unit});
+}
+
+// Discards everything written to it, so printing is measured without the cost of a terminal.
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override
+    {
+        return c;
+    }
+
+    std::streamsize xsputn(const char *, std::streamsize count) override
+    {
+        return count;
+    }
+};
+
+// Resolve the names of a tree like a semantic pass would, counting every table operation.
+class Resolver : public ConstASTVisitor<Resolver>
+{
+public:
+    Resolver(SymbolTable &table) : table(table), operations(0) {}
+
+    size_t run(const ProgramNode *program)
+    {
+        scope(true);
+        for (const DeclarationNode *declaration : program->declarations)
+        {
+            visit(declaration);
+        }
+        scope(false);
+        return operations;
+    }
+
+    void visitFunctionDeclarationNode(const FunctionDeclarationNode *function)
+    {
+        declare(function->name, SymbolType::FUNCTION);
+        scope(true);
+        for (const ParameterNode *parameter : function->parameters)
+        {
+            declare(parameter->name, SymbolType::VARIABLE);
+        }
+        visit(function->body);
+        scope(false);
+    }
+
+    void visitEnumDeclarationNode(const EnumDeclarationNode *enumeration)
+    {
+        declare(enumeration->name, SymbolType::ENUM);
+    }
+
+    void visitStructDeclarationNode(const StructDeclarationNode *structure)
+    {
+        declare(structure->name, SymbolType::STRUCT);
+    }
+
+    void visitBlockNode(const BlockNode *block)
+    {
+        scope(true);
+        for (const StatementNode *statement : block->statements)
+        {
+            visit(statement);
+        }
+        scope(false);
+    }
+
+    void visitVarDeclarationNode(const VarDeclarationNode *declaration)
+    {
+        expression(declaration->initializer);
+        declare(declaration->name, SymbolType::VARIABLE);
+    }
+
+    void visitExpressionStatementNode(const ExpressionStatementNode *statement)
+    {
+        expression(statement->expression);
+    }
+
+    void visitRetStatementNode(const RetStatementNode *ret)
+    {
+        expression(ret->value);
+    }
+
+    void visitLoopStatementNode(const LoopStatementNode *loop)
+    {
+        visit(loop->body);
+    }
+
+    void visitIfStatementNode(const IfStatementNode *branch)
+    {
+        expression(branch->condition);
+        visit(branch->then_block);
+        for (const IfStatementNode *elif : branch->elif_statements)
+        {
+            expression(elif->condition);
+            visit(elif->then_block);
+        }
+        if (branch->else_block)
+        {
+            visit(branch->else_block);
+        }
+    }
+
+    void visitIdentifierNode(const IdentifierNode *identifier)
+    {
+        Symbol symbol;
+        do_not_optimize(table.lookup(identifier->name, symbol));
+        operations++;
+    }
+
+    void visitBinaryExprNode(const BinaryExprNode *binary)
+    {
+        expression(binary->left);
+        expression(binary->right);
+    }
+
+    void visitUnaryExprNode(const UnaryExprNode *unary)
+    {
+        expression(unary->operand);
+    }
+
+private:
+    SymbolTable &table;
+    size_t operations;
+
+    void declare(NameID name, SymbolType type)
+    {
+        table.insert(name, Symbol{name, type, 0, 0});
+        operations++;
+    }
+
+    void scope(bool enter)
+    {
+        enter ? table.enterScope() : table.exitScope();
+        operations++;
+    }
+
+    // Initializers and returned values are optional.
+    void expression(const ExpressionNode *expression)
+    {
+        if (expression)
+        {
+            visit(expression);
+        }
+    }
+};
+
+static void measure(const CorpusShape &shape)
+{
+    std::string source = generate_corpus(shape, static_cast<size_t>(SizeKB) * 1024, Seed);
+    if (!DumpDirectory.empty())
+    {
+        std::ofstream(DumpDirectory + "/" + shape.name + ".zx") << source;
+    }
+
+    SourceManager sources;
+    FileID file = sources.addBuffer(source, std::string(shape.name) + ".zx");
+    NullBuffer null_buffer;
+    std::ostream null_stream(&null_buffer);
+    PrintGlobalState print(sources);
+    print.setOutput(null_stream);
+    StringInterner names;
+    std::fprintf(benchmark_output(), "\n%s: %zu bytes\n", shape.name, source.size());
+
+    std::vector<Token> tokens;
+    double ns = run_benchmark(("lex/" + std::string(shape.name)).c_str(), [&]()
+                              {
+        Lexer lexer(sources, file, names, print);
+        tokens = lexer.lex(); }, MinTime);
+    report("lex", shape, ns, source.size(), tokens.size(), "tokens");
+
+    size_t nodes = 0;
+    ns = run_benchmark(("parse/" + std::string(shape.name)).c_str(), [&]()
+                       {
+        ASTContext context;
+        Parser parser(tokens, context, file, print);
+        do_not_optimize(parser.parse());
+        nodes = context.getNodeCount(); }, MinTime);
+    report("parse", shape, ns, source.size(), nodes, "nodes");
+
+    // The same tokens, split at top-level declarations and parsed on every hardware thread.
+    ThreadPool pool;
+    ns = run_benchmark(("parallel_parse/" + std::string(shape.name)).c_str(), [&]()
+                       {
+        ASTContext context;
+        Parser parser(tokens, context, file, print);
+        do_not_optimize(parser.parse(pool)); }, MinTime);
+    report("parallel_parse", shape, ns, source.size(), nodes, "nodes");
+
+    // Lexing and parsing together, with the parser pulling tokens from the lexer.
+    ns = run_benchmark(("stream/" + std::string(shape.name)).c_str(), [&]()
+                       {
+        Lexer lexer(sources, file, names, print);
+        ASTContext context;
+        Parser parser(lexer, context, file, print);
+        do_not_optimize(parser.parse()); }, MinTime);
+    report("stream", shape, ns, source.size(), tokens.size(), "tokens");
+    if (print.hasEncounteredError())
+    {
+        std::fprintf(benchmark_output(), "warning: the %s corpus does not parse cleanly\n", shape.name);
+    }
+
+    ASTContext context;
+    Parser parser(tokens, context, file, print);
+    ProgramNode *program = parser.parse();
+    // Loading the tree from the AST cache instead of lexing and parsing the file.
+    std::string cached = ASTCache::serialize(source, program, names);
+    ns = run_benchmark(("cache_load/" + std::string(shape.name)).c_str(), [&]()
+                       {
+        ASTContext context;
+        StringInterner loaded_names;
+        do_not_optimize(ASTCache::deserialize(cached, source, context, loaded_names)); }, MinTime);
+    report("cache_load", shape, ns, source.size(), nodes, "nodes");
+
+    size_t operations = 0;
+    ns = run_benchmark(("symbols/" + std::string(shape.name)).c_str(), [&]()
+                       {
+        PrintGlobalState quiet;
+        quiet.setOutput(null_stream);
+        SymbolTable table(quiet, names);
+        operations = Resolver(table).run(program); }, MinTime);
+    report("symbols", shape, ns, 0, operations, "ops");
+
+    // Resolving every name and typing every expression.
+    bool analyzed = true;
+    ns = run_benchmark(("analysis/" + std::string(shape.name)).c_str(), [&]()
+                       {
+        PrintGlobalState quiet(sources);
+        quiet.setOutput(null_stream);
+        TypeContext types;
+        SemanticAnalyzer analyzer(types, names, quiet);
+        do_not_optimize(analyzer.analyze(program, file));
+        analyzed = !quiet.hasEncounteredError(); }, MinTime);
+    report("analysis", shape, ns, 0, nodes, "nodes");
+    if (!analyzed)
+    {
+        std::fprintf(benchmark_output(), "warning: the %s corpus is not type correct\n", shape.name);
+    }
+
+    // Diagnostics at offsets spread over the whole file, as a broken file would report them.
+    constexpr size_t DIAGNOSTICS = 1024;
+    std::vector<int_t> offsets;
+    std::mt19937 random(Seed);
+    for (size_t i = 0; i < DIAGNOSTICS; i++)
+    {
+        offsets.push_back(tokens[random() % tokens.size()].col);
+    }
+    ns = run_benchmark(("print_file/" + std::string(shape.name)).c_str(), [&]()
+                       {
+        for (int_t offset : offsets)
+        {
+            print.printFile(offset, file);
+        } }, MinTime);
+    report("print_file", shape, ns, 0, DIAGNOSTICS, "diagnostics");
+}
+
+static void write_json(llvm::raw_ostream &out)
+{
+    llvm::json::OStream json(out, 2);
+    json.object([&]()
+                {
+        json.attribute("scan_kernels", get_scan_kernels().name);
+        json.attribute("corpus_kb", static_cast<int64_t>(SizeKB));
+        json.attribute("seed", static_cast<int64_t>(Seed));
+        json.attributeArray("results", [&]()
+                            {
+            for (const Result &result : results)
+            {
+                json.object([&]()
+                            {
+                    json.attribute("benchmark", result.benchmark);
+                    json.attribute("corpus", result.corpus);
+                    json.attribute("ns_per_iteration", result.ns);
+                    if (result.bytes)
+                    {
+                        json.attribute("mb_per_second", result.bytes / result.ns * 1e3);
+                    }
+                    json.attribute("items_per_second", result.items / result.ns * 1e9);
+                    json.attribute("items", result.unit); });
+            } }); });
+    out << '\n';
+}
+
+int main(int argc, char **argv)
+{
+    llvm::cl::ParseCommandLineOptions(argc, argv, "Zurox frontend benchmarks over generated corpora\n");
+    if (JSONOutput == "-")
+    {
+        // Only the JSON goes to stdout, so it can be piped as is.
+        benchmark_output() = stderr;
+    }
+    std::fprintf(benchmark_output(), "Scanning with %s kernels.\n", get_scan_kernels().name);
+    for (const CorpusShape &shape : default_corpora())
+    {
+        if (Corpora.empty() || llvm::is_contained(Corpora, shape.name))
+        {
+            measure(shape);
+        }
+    }
+
+    if (JSONOutput == "-")
+    {
+        write_json(llvm::outs());
+    }
+    else if (!JSONOutput.empty())
+    {
+        std::error_code code;
+        llvm::raw_fd_ostream out(JSONOutput, code, llvm::sys::fs::OF_Text);
+        if (code)
+        {
+            std::fprintf(stderr, "Unable to open '%s': %s\n", JSONOutput.c_str(), code.message().c_str());
+            return 1;
+        }
+        write_json(out);
+    }
+    return 0;
+}
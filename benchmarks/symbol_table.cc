@@ -0,0 +1,97 @@
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <table.hh>
+#include "bench.hh"
+
+// The table before it was flattened, one hash map per scope, kept as a baseline.
+class NestedMapTable
+{
+public:
+    void insert(NameID name, const Symbol &symbol)
+    {
+        scopes.back().emplace(name, symbol);
+    }
+
+    bool lookup(NameID name, Symbol &symbol) const
+    {
+        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+        {
+            auto found = it->find(name);
+            if (found != it->end())
+            {
+                symbol = found->second;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void enterScope()
+    {
+        scopes.emplace_back();
+    }
+
+    void exitScope()
+    {
+        scopes.pop_back();
+    }
+
+private:
+    std::vector<std::unordered_map<NameID, Symbol>> scopes;
+};
+
+static constexpr int LOCALS_PER_SCOPE = 16;
+static constexpr int LOOKUPS = 1024;
+
+// Open `depth` nested blocks declaring locals, resolve names from every level
+// in the innermost block, then close all blocks again.
+template <typename Table>
+static void nested_blocks(Table &table, const std::vector<NameID> &ids, int depth)
+{
+    for (int d = 0; d < depth; d++)
+    {
+        table.enterScope();
+        for (int i = 0; i < LOCALS_PER_SCOPE; i++)
+        {
+            NameID name = ids[d * LOCALS_PER_SCOPE + i];
+            table.insert(name, Symbol{name, SymbolType::VARIABLE, static_cast<int_t>(d), 0});
+        }
+    }
+    size_t declared = depth * LOCALS_PER_SCOPE;
+    for (int i = 0; i < LOOKUPS; i++)
+    {
+        Symbol symbol;
+        do_not_optimize(table.lookup(ids[(i * 7919) % declared], symbol));
+    }
+    for (int d = 0; d < depth; d++)
+    {
+        table.exitScope();
+    }
+}
+
+int main()
+{
+    SourceManager sources;
+    PrintGlobalState print(sources);
+    StringInterner names;
+    std::vector<NameID> ids;
+    for (int i = 0; i < 256 * LOCALS_PER_SCOPE; i++)
+    {
+        ids.push_back(names.intern("local" + std::to_string(i)));
+    }
+
+    std::printf("%d locals per block, %d lookups in the innermost block.\n", LOCALS_PER_SCOPE, LOOKUPS);
+    for (int depth : {1, 8, 64, 256})
+    {
+        std::string nested = "symbol_table/nested_maps/depth_" + std::to_string(depth);
+        std::string flat = "symbol_table/flat/depth_" + std::to_string(depth);
+        NestedMapTable nested_table;
+        SymbolTable flat_table(print, names);
+        run_benchmark(nested.c_str(), [&]()
+                      { nested_blocks(nested_table, ids, depth); });
+        run_benchmark(flat.c_str(), [&]()
+                      { nested_blocks(flat_table, ids, depth); });
+    }
+    return 0;
+}
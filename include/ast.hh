@@ -2,9 +2,15 @@
 #define AST_HH
 
 #include <memory>
+#include <new>
+#include <utility>
 #include <vector>
-#include <string>
+#include "operators.hh"
 #include "token.hh"
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Allocator.h>
+#include <llvm/Support/Casting.h>
 
 // Forward declaration of AST classes
 class ASTNode;
@@ -24,6 +30,7 @@ class MatchStatementNode;
 class CaseClauseNode;
 class BreakStatementNode;
 class ContinueStatementNode;
+class RetStatementNode;
 class EnumFieldsNode;
 class StructFieldsNode;
 class ExpressionNode;
@@ -33,220 +40,434 @@ class PrimaryExprNode;
 class LiteralNode;
 class TypeNode;
 class IdentifierNode;
+class Type;
+
+/**
+ * @brief Owns every node of the AST of a translation unit.
+ *
+ * Nodes are bump allocated and never destroyed, the whole tree is released at
+ * once with the context. Nodes therefore must not own memory: children are
+ * plain pointers and lists of children are arrays allocated in the context.
+ * Names are interned and all other strings are copied into the context, so
+ * the tree does not refer to the tokens or the source it was parsed from.
+ */
+class ASTContext
+{
+public:
+    ASTContext() = default;
+    ASTContext(const ASTContext &) = delete;
+    ASTContext &operator=(const ASTContext &) = delete;
+
+    template <typename T, typename... Args>
+    T *create(Args &&...args)
+    {
+        nodes++;
+        return new (allocator.Allocate<T>()) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    llvm::ArrayRef<T> copy(llvm::ArrayRef<T> items)
+    {
+        if (items.empty())
+        {
+            return {};
+        }
+        T *data = allocator.Allocate<T>(items.size());
+        std::uninitialized_copy(items.begin(), items.end(), data);
+        return llvm::ArrayRef<T>(data, items.size());
+    }
+
+    llvm::StringRef save(llvm::StringRef str)
+    {
+        char *data = allocator.Allocate<char>(str.size());
+        std::uninitialized_copy(str.begin(), str.end(), data);
+        return llvm::StringRef(data, str.size());
+    }
+
+    // Keep the nodes of another context alive as long as this one, so they may be linked into its tree.
+    void adopt(std::unique_ptr<ASTContext> other)
+    {
+        adopted.push_back(std::move(other));
+    }
+
+    size_t getBytesAllocated() const
+    {
+        size_t bytes = allocator.getBytesAllocated();
+        for (const auto &other : adopted)
+        {
+            bytes += other->getBytesAllocated();
+        }
+        return bytes;
+    }
+
+    size_t getNodeCount() const
+    {
+        size_t count = nodes;
+        for (const auto &other : adopted)
+        {
+            count += other->getNodeCount();
+        }
+        return count;
+    }
+
+private:
+    llvm::BumpPtrAllocator allocator;
+    size_t nodes = 0;
+    std::vector<std::unique_ptr<ASTContext>> adopted;
+};
 
 // Base AST
+//
+// Nodes have no virtual functions. Every node carries the kind of its class,
+// which llvm::isa, llvm::cast and llvm::dyn_cast check through classof(), and
+// ASTVisitor dispatches on with a switch.
 class ASTNode {
 public:
-    virtual ~ASTNode() = default;
+    // Kinds of the classes derived from one base are consecutive, so the base
+    // checks for a range.
+    enum Kind : uint8_t {
+        NODE_PROGRAM,
+        NODE_FUNCTION_DECLARATION,
+        NODE_ENUM_DECLARATION,
+        NODE_STRUCT_DECLARATION,
+        NODE_PARAMETER,
+        NODE_BLOCK,
+        NODE_IF_STATEMENT,
+        NODE_LOOP_STATEMENT,
+        NODE_VAR_DECLARATION,
+        NODE_EXPRESSION_STATEMENT,
+        NODE_MATCH_STATEMENT,
+        NODE_BREAK_STATEMENT,
+        NODE_CONTINUE_STATEMENT,
+        NODE_RET_STATEMENT,
+        NODE_CASE_CLAUSE,
+        NODE_BINARY_EXPR,
+        NODE_UNARY_EXPR,
+        NODE_PRIMARY_EXPR,
+        NODE_LITERAL,
+        NODE_IDENTIFIER,
+        NODE_TYPE,
+
+        FIRST_DECLARATION = NODE_FUNCTION_DECLARATION,
+        LAST_DECLARATION = NODE_STRUCT_DECLARATION,
+        FIRST_STATEMENT = NODE_BLOCK,
+        LAST_STATEMENT = NODE_RET_STATEMENT,
+        FIRST_EXPRESSION = NODE_BINARY_EXPR,
+        LAST_EXPRESSION = NODE_IDENTIFIER,
+    };
+
+    Kind getKind() const { return kind; }
+
+    // Offset in the file of the first token of the node, of the operator for
+    // unary and binary expressions. Set by the parser, diagnostics point there.
+    uint32_t offset = 0;
+
+protected:
+    explicit ASTNode(Kind kind) : kind(kind) {}
+
+private:
+    const Kind kind;
 };
 
 // Program node representing the entire program
 class ProgramNode : public ASTNode {
 public:
-    ProgramNode(std::vector<std::shared_ptr<DeclarationNode>> declarations)
-        : declarations(std::move(declarations)) {}
-    std::vector<std::shared_ptr<DeclarationNode>> declarations;
+    ProgramNode(llvm::ArrayRef<DeclarationNode *> declarations)
+        : ASTNode(NODE_PROGRAM), declarations(declarations) {}
+    llvm::ArrayRef<DeclarationNode *> declarations;
+
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_PROGRAM; }
 };
 
 // Base class for declarations
-class DeclarationNode : public ASTNode {};
+class DeclarationNode : public ASTNode {
+public:
+    static bool classof(const ASTNode *node)
+    {
+        return node->getKind() >= FIRST_DECLARATION && node->getKind() <= LAST_DECLARATION;
+    }
+
+protected:
+    explicit DeclarationNode(Kind kind) : ASTNode(kind) {}
+};
 
 // Function declaration node
 class FunctionDeclarationNode : public DeclarationNode {
 public:
-    FunctionDeclarationNode(std::string name, std::vector<std::shared_ptr<ParameterNode>> parameters,
-                            std::shared_ptr<TypeNode> return_type, std::shared_ptr<BlockNode> body)
-        : name(std::move(name)), parameters(std::move(parameters)), return_type(std::move(return_type)), body(std::move(body)) {}
-    std::string name;
-    std::vector<std::shared_ptr<ParameterNode>> parameters;
-    std::shared_ptr<TypeNode> return_type;
-    std::shared_ptr<BlockNode> body;
+    FunctionDeclarationNode(NameID name, llvm::ArrayRef<ParameterNode *> parameters,
+                            TypeNode *return_type, BlockNode *body)
+        : DeclarationNode(NODE_FUNCTION_DECLARATION), name(name), parameters(parameters), return_type(return_type), body(body) {}
+    NameID name;
+    llvm::ArrayRef<ParameterNode *> parameters;
+    TypeNode *return_type;
+    BlockNode *body;
+
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_FUNCTION_DECLARATION; }
 };
 
 
 // Parameter node
 class ParameterNode : public ASTNode {
 public:
-    ParameterNode(std::shared_ptr<TypeNode> type, std::string name)
-        : type(std::move(type)), name(std::move(name)) {}
+    ParameterNode(TypeNode *type, NameID name)
+        : ASTNode(NODE_PARAMETER), type(type), name(name) {}
+
+    TypeNode *type;
+    NameID name;
 
-    std::shared_ptr<TypeNode> type;
-    std::string name;
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_PARAMETER; }
 };
 
 // Base class for statements
-class StatementNode : public ASTNode {};
+class StatementNode : public ASTNode {
+public:
+    static bool classof(const ASTNode *node)
+    {
+        return node->getKind() >= FIRST_STATEMENT && node->getKind() <= LAST_STATEMENT;
+    }
+
+protected:
+    explicit StatementNode(Kind kind) : ASTNode(kind) {}
+};
 
 // Block node
 class BlockNode : public StatementNode {
 public:
-    BlockNode(std::vector<std::shared_ptr<StatementNode>> statements)
-        : statements(std::move(statements)) {}
+    BlockNode(llvm::ArrayRef<StatementNode *> statements)
+        : StatementNode(NODE_BLOCK), statements(statements) {}
 
-    std::vector<std::shared_ptr<StatementNode>> statements;
+    llvm::ArrayRef<StatementNode *> statements;
+
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_BLOCK; }
 };
 
 // If statement node
 class IfStatementNode : public StatementNode {
 public:
-    IfStatementNode(std::shared_ptr<ExpressionNode> condition, std::shared_ptr<BlockNode> then_block,
-                    std::vector<std::shared_ptr<IfStatementNode>> elif_statements,
-                    std::shared_ptr<BlockNode> else_block)
-        : condition(std::move(condition)), then_block(std::move(then_block)),
-          elif_statements(std::move(elif_statements)), else_block(std::move(else_block)) {}
-
-    std::shared_ptr<ExpressionNode> condition;
-    std::shared_ptr<BlockNode> then_block;
-    std::vector<std::shared_ptr<IfStatementNode>> elif_statements;
-    std::shared_ptr<BlockNode> else_block;
+    IfStatementNode(ExpressionNode *condition, BlockNode *then_block,
+                    llvm::ArrayRef<IfStatementNode *> elif_statements,
+                    BlockNode *else_block)
+        : StatementNode(NODE_IF_STATEMENT), condition(condition), then_block(then_block),
+          elif_statements(elif_statements), else_block(else_block) {}
+
+    ExpressionNode *condition;
+    BlockNode *then_block;
+    llvm::ArrayRef<IfStatementNode *> elif_statements;
+    BlockNode *else_block;
+
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_IF_STATEMENT; }
 };
 
 // Loop statement node
 class LoopStatementNode : public StatementNode {
 public:
-    LoopStatementNode(std::shared_ptr<BlockNode> body)
-        : body(std::move(body)) {}
+    LoopStatementNode(BlockNode *body)
+        : StatementNode(NODE_LOOP_STATEMENT), body(body) {}
+
 
+    BlockNode *body;
 
-    std::shared_ptr<BlockNode> body;
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_LOOP_STATEMENT; }
 };
 
 // Variable declaration node
 class VarDeclarationNode : public StatementNode {
 public:
-    VarDeclarationNode(std::shared_ptr<TypeNode> type, std::string name, std::shared_ptr<ExpressionNode> initializer)
-        : type(std::move(type)), name(std::move(name)), initializer(std::move(initializer)) {}
+    VarDeclarationNode(TypeNode *type, NameID name, ExpressionNode *initializer)
+        : StatementNode(NODE_VAR_DECLARATION), type(type), name(name), initializer(initializer) {}
 
 
-    std::shared_ptr<TypeNode> type;
-    std::string name;
-    std::shared_ptr<ExpressionNode> initializer;
+    TypeNode *type;
+    NameID name;
+    ExpressionNode *initializer;
+
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_VAR_DECLARATION; }
 };
 
 // Expression statement node
 class ExpressionStatementNode : public StatementNode {
 public:
-    ExpressionStatementNode(std::shared_ptr<ExpressionNode> expression)
-        : expression(std::move(expression)) {}
+    ExpressionStatementNode(ExpressionNode *expression)
+        : StatementNode(NODE_EXPRESSION_STATEMENT), expression(expression) {}
+
 
+    ExpressionNode *expression;
 
-    std::shared_ptr<ExpressionNode> expression;
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_EXPRESSION_STATEMENT; }
 };
 
 // Match statement node
 class MatchStatementNode : public StatementNode {
 public:
-    MatchStatementNode(std::vector<std::shared_ptr<CaseClauseNode>> cases, std::shared_ptr<BlockNode> default_block)
-        : cases(std::move(cases)), default_block(std::move(default_block)) {}
+    MatchStatementNode(ExpressionNode *subject, llvm::ArrayRef<CaseClauseNode *> cases, BlockNode *default_block)
+        : StatementNode(NODE_MATCH_STATEMENT), subject(subject), cases(cases), default_block(default_block) {}
 
 
-    std::vector<std::shared_ptr<CaseClauseNode>> cases;
-    std::shared_ptr<BlockNode> default_block;
+    ExpressionNode *subject;
+    llvm::ArrayRef<CaseClauseNode *> cases;
+    BlockNode *default_block;
+
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_MATCH_STATEMENT; }
 };
 
 // Case clause node
 class CaseClauseNode : public ASTNode {
 public:
-    CaseClauseNode(std::shared_ptr<LiteralNode> literal, std::shared_ptr<BlockNode> block)
-        : literal(std::move(literal)), block(std::move(block)) {}
+    CaseClauseNode(LiteralNode *literal, BlockNode *block)
+        : ASTNode(NODE_CASE_CLAUSE), literal(literal), block(block) {}
+
 
+    LiteralNode *literal;
+    BlockNode *block;
 
-    std::shared_ptr<LiteralNode> literal;
-    std::shared_ptr<BlockNode> block;
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_CASE_CLAUSE; }
 };
 
 // Break statement node
-class BreakStatementNode : public StatementNode {};
+class BreakStatementNode : public StatementNode {
+public:
+    BreakStatementNode() : StatementNode(NODE_BREAK_STATEMENT) {}
+
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_BREAK_STATEMENT; }
+};
 
 // Continue statement node
-class ContinueStatementNode : public StatementNode {};
+class ContinueStatementNode : public StatementNode {
+public:
+    ContinueStatementNode() : StatementNode(NODE_CONTINUE_STATEMENT) {}
+
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_CONTINUE_STATEMENT; }
+};
+
+// Ret statement node
+class RetStatementNode : public StatementNode {
+public:
+    RetStatementNode(ExpressionNode *value)
+        : StatementNode(NODE_RET_STATEMENT), value(value) {}
+
+    ExpressionNode *value;
+
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_RET_STATEMENT; }
+};
 
 // Enum declaration node
 class EnumDeclarationNode : public DeclarationNode {
 public:
-    EnumDeclarationNode(std::string name, std::vector<std::string> fields)
-        : name(std::move(name)), fields(std::move(fields)) {}
+    EnumDeclarationNode(NameID name, llvm::ArrayRef<NameID> fields)
+        : DeclarationNode(NODE_ENUM_DECLARATION), name(name), fields(fields) {}
 
 
-    std::string name;
-    std::vector<std::string> fields;
+    NameID name;
+    llvm::ArrayRef<NameID> fields;
+
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_ENUM_DECLARATION; }
 };
 
 // Struct declaration node
 class StructDeclarationNode : public DeclarationNode {
 public:
-    StructDeclarationNode(std::string name, std::vector<std::pair<std::shared_ptr<TypeNode>, std::string>> fields)
-        : name(std::move(name)), fields(std::move(fields)) {}
+    StructDeclarationNode(NameID name, llvm::ArrayRef<ParameterNode *> fields)
+        : DeclarationNode(NODE_STRUCT_DECLARATION), name(name), fields(fields) {}
+
 
+    NameID name;
+    llvm::ArrayRef<ParameterNode *> fields;
 
-    std::string name;
-    std::vector<std::pair<std::shared_ptr<TypeNode>, std::string>> fields;
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_STRUCT_DECLARATION; }
 };
 
 // Expression node base class
-class ExpressionNode : public ASTNode {};
+class ExpressionNode : public ASTNode {
+public:
+    // Type of the value, set by semantic analysis.
+    const Type *value_type = nullptr;
+
+    static bool classof(const ASTNode *node)
+    {
+        return node->getKind() >= FIRST_EXPRESSION && node->getKind() <= LAST_EXPRESSION;
+    }
+
+protected:
+    explicit ExpressionNode(Kind kind) : ASTNode(kind) {}
+};
 
 // Binary expression node
 class BinaryExprNode : public ExpressionNode {
 public:
-    BinaryExprNode(std::shared_ptr<ExpressionNode> left, std::string op, std::shared_ptr<ExpressionNode> right)
-        : left(std::move(left)), op(std::move(op)), right(std::move(right)) {}
+    BinaryExprNode(ExpressionNode *left, Operator op, ExpressionNode *right)
+        : ExpressionNode(NODE_BINARY_EXPR), left(left), op(op), right(right) {}
+
 
+    ExpressionNode *left;
+    Operator op;
+    ExpressionNode *right;
 
-    std::shared_ptr<ExpressionNode> left;
-    std::string op;
-    std::shared_ptr<ExpressionNode> right;
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_BINARY_EXPR; }
 };
 
 // Unary expression node
 class UnaryExprNode : public ExpressionNode {
 public:
-    UnaryExprNode(std::string op, std::shared_ptr<ExpressionNode> operand)
-        : op(std::move(op)), operand(std::move(operand)) {}
+    UnaryExprNode(Operator op, ExpressionNode *operand)
+        : ExpressionNode(NODE_UNARY_EXPR), op(op), operand(operand) {}
 
 
-    std::string op;
-    std::shared_ptr<ExpressionNode> operand;
+    Operator op;
+    ExpressionNode *operand;
+
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_UNARY_EXPR; }
 };
 
 // Primary expression node
 class PrimaryExprNode : public ExpressionNode {
 public:
-    PrimaryExprNode(std::string value)
-        : value(std::move(value)) {}
+    PrimaryExprNode(llvm::StringRef value)
+        : ExpressionNode(NODE_PRIMARY_EXPR), value(value) {}
+
 
+    llvm::StringRef value;
 
-    std::string value;
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_PRIMARY_EXPR; }
 };
 
 // Literal node
 class LiteralNode : public ExpressionNode {
 public:
-    LiteralNode(const std::string &value, TokenType type)
-        : value(value), type(type) {}
+    LiteralNode(llvm::StringRef value, TokenType type)
+        : ExpressionNode(NODE_LITERAL), value(value), type(type) {}
 
-    std::string value;
+    llvm::StringRef value;
     TokenType type;
+
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_LITERAL; }
 };
 
 // Type node
 class TypeNode : public ASTNode {
 public:
-    TypeNode(std::string name)
-        : name(std::move(name)) {}
+    TypeNode(llvm::StringRef name, NameID reference = 0)
+        : ASTNode(NODE_TYPE), name(name), reference(reference) {}
 
 
-    std::string name;
+    llvm::StringRef name;
+    // Name of the struct or enum after the keyword in name, 0 for data types.
+    NameID reference;
+    // Type the name resolves to, set by semantic analysis.
+    const Type *resolved_type = nullptr;
+
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_TYPE; }
 };
 
 // Identifier node
-class IdentifierNode : public ASTNode {
+class IdentifierNode : public ExpressionNode {
 public:
-    IdentifierNode(std::string name)
-        : name(std::move(name)) {}
+    IdentifierNode(NameID name)
+        : ExpressionNode(NODE_IDENTIFIER), name(name) {}
+
 
+    NameID name;
 
-    std::string name;
+    static bool classof(const ASTNode *node) { return node->getKind() == NODE_IDENTIFIER; }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,65 @@
+#ifndef AST_CACHE_HH
+#define AST_CACHE_HH
+
+#include <cstdint>
+#include <string>
+#include "ast.hh"
+#include "interner.hh"
+#include <llvm/ADT/StringRef.h>
+
+/**
+ * @brief Caches the ASTs of source files on disk, so unchanged files are loaded instead of parsed.
+ *
+ * A cached AST is one file in the cache directory, named after the hash of
+ * the source it was parsed from. It starts with a header holding the format
+ * and compiler version, the hash and the size of the source, followed by the
+ * names and type names of the tree and then its nodes in preorder. Nodes
+ * refer to names and types by their index in the file and to their children
+ * only by position, so the file holds no pointers and is read in one pass
+ * straight from the mapped file. Integers are LEB128 encoded, which keeps a
+ * file at about half the size of its source.
+ *
+ * Files are written to a temporary file and renamed, so several compilers
+ * sharing a cache directory never read a partly written file.
+ */
+class ASTCache
+{
+public:
+    /**
+     * @brief Use a cache directory, created when the first AST is stored.
+     */
+    explicit ASTCache(std::string directory);
+
+    /**
+     * @brief Load the AST cached for a source.
+     * @param source Content of the source file.
+     * @param context Context the nodes are created in.
+     * @param names Interner the names of the tree are interned into.
+     * @return The program, or nullptr if none is cached or the cached file is unusable.
+     */
+    ProgramNode *load(llvm::StringRef source, ASTContext &context, StringInterner &names) const;
+
+    /**
+     * @brief Cache the AST parsed from a source, replacing any AST cached for it.
+     * @return Whether it was stored, otherwise `error` describes why not.
+     */
+    bool store(llvm::StringRef source, const ProgramNode *program, const StringInterner &names, std::string &error) const;
+
+    /**
+     * @brief Encode an AST in the format of the cache files.
+     */
+    static std::string serialize(llvm::StringRef source, const ProgramNode *program, const StringInterner &names);
+
+    /**
+     * @brief Decode a cached AST.
+     * @return The program, or nullptr if the data was not encoded from this source by this compiler.
+     */
+    static ProgramNode *deserialize(llvm::StringRef data, llvm::StringRef source, ASTContext &context, StringInterner &names);
+
+private:
+    std::string directory;
+
+    std::string getPath(uint64_t hash) const;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef AST_VISITOR_HH
+#define AST_VISITOR_HH
+
+#include "ast.hh"
+#include <llvm/Support/ErrorHandling.h>
+
+namespace detail
+{
+    template <typename T>
+    using NodePointer = T *;
+
+    template <typename T>
+    using ConstNodePointer = const T *;
+}
+
+/**
+ * @brief Calls the function of a pass for the class of a node, with a switch on its kind instead of RTTI.
+ *
+ * A pass derives from ASTVisitor or ConstASTVisitor with itself as `Derived`,
+ * and declares a function for every class it handles, such as
+ * `Result visitBinaryExprNode(const BinaryExprNode *node)`. The functions are
+ * found at compile time, so nothing is virtual. A class the pass does not
+ * handle falls back to the function of its base class, like
+ * visitExpressionNode, and then to visitNode, which returns `Result()`.
+ * visit() does not walk into children, the functions of the pass decide
+ * which children to visit.
+ */
+template <template <typename> class Ptr, typename Derived, typename Result>
+class ASTVisitorBase
+{
+public:
+    Result visit(Ptr<ASTNode> node)
+    {
+        switch (node->getKind())
+        {
+        case ASTNode::NODE_PROGRAM:
+            return derived().visitProgramNode(static_cast<Ptr<ProgramNode>>(node));
+        case ASTNode::NODE_FUNCTION_DECLARATION:
+            return derived().visitFunctionDeclarationNode(static_cast<Ptr<FunctionDeclarationNode>>(node));
+        case ASTNode::NODE_ENUM_DECLARATION:
+            return derived().visitEnumDeclarationNode(static_cast<Ptr<EnumDeclarationNode>>(node));
+        case ASTNode::NODE_STRUCT_DECLARATION:
+            return derived().visitStructDeclarationNode(static_cast<Ptr<StructDeclarationNode>>(node));
+        case ASTNode::NODE_PARAMETER:
+            return derived().visitParameterNode(static_cast<Ptr<ParameterNode>>(node));
+        case ASTNode::NODE_BLOCK:
+            return derived().visitBlockNode(static_cast<Ptr<BlockNode>>(node));
+        case ASTNode::NODE_IF_STATEMENT:
+            return derived().visitIfStatementNode(static_cast<Ptr<IfStatementNode>>(node));
+        case ASTNode::NODE_LOOP_STATEMENT:
+            return derived().visitLoopStatementNode(static_cast<Ptr<LoopStatementNode>>(node));
+        case ASTNode::NODE_VAR_DECLARATION:
+            return derived().visitVarDeclarationNode(static_cast<Ptr<VarDeclarationNode>>(node));
+        case ASTNode::NODE_EXPRESSION_STATEMENT:
+            return derived().visitExpressionStatementNode(static_cast<Ptr<ExpressionStatementNode>>(node));
+        case ASTNode::NODE_MATCH_STATEMENT:
+            return derived().visitMatchStatementNode(static_cast<Ptr<MatchStatementNode>>(node));
+        case ASTNode::NODE_BREAK_STATEMENT:
+            return derived().visitBreakStatementNode(static_cast<Ptr<BreakStatementNode>>(node));
+        case ASTNode::NODE_CONTINUE_STATEMENT:
+            return derived().visitContinueStatementNode(static_cast<Ptr<ContinueStatementNode>>(node));
+        case ASTNode::NODE_RET_STATEMENT:
+            return derived().visitRetStatementNode(static_cast<Ptr<RetStatementNode>>(node));
+        case ASTNode::NODE_CASE_CLAUSE:
+            return derived().visitCaseClauseNode(static_cast<Ptr<CaseClauseNode>>(node));
+        case ASTNode::NODE_BINARY_EXPR:
+            return derived().visitBinaryExprNode(static_cast<Ptr<BinaryExprNode>>(node));
+        case ASTNode::NODE_UNARY_EXPR:
+            return derived().visitUnaryExprNode(static_cast<Ptr<UnaryExprNode>>(node));
+        case ASTNode::NODE_PRIMARY_EXPR:
+            return derived().visitPrimaryExprNode(static_cast<Ptr<PrimaryExprNode>>(node));
+        case ASTNode::NODE_LITERAL:
+            return derived().visitLiteralNode(static_cast<Ptr<LiteralNode>>(node));
+        case ASTNode::NODE_IDENTIFIER:
+            return derived().visitIdentifierNode(static_cast<Ptr<IdentifierNode>>(node));
+        case ASTNode::NODE_TYPE:
+            return derived().visitTypeNode(static_cast<Ptr<TypeNode>>(node));
+        }
+        llvm_unreachable("Unknown AST node kind");
+    }
+
+    Result visitProgramNode(Ptr<ProgramNode> node) { return derived().visitNode(node); }
+    Result visitFunctionDeclarationNode(Ptr<FunctionDeclarationNode> node) { return derived().visitDeclarationNode(node); }
+    Result visitEnumDeclarationNode(Ptr<EnumDeclarationNode> node) { return derived().visitDeclarationNode(node); }
+    Result visitStructDeclarationNode(Ptr<StructDeclarationNode> node) { return derived().visitDeclarationNode(node); }
+    Result visitParameterNode(Ptr<ParameterNode> node) { return derived().visitNode(node); }
+    Result visitBlockNode(Ptr<BlockNode> node) { return derived().visitStatementNode(node); }
+    Result visitIfStatementNode(Ptr<IfStatementNode> node) { return derived().visitStatementNode(node); }
+    Result visitLoopStatementNode(Ptr<LoopStatementNode> node) { return derived().visitStatementNode(node); }
+    Result visitVarDeclarationNode(Ptr<VarDeclarationNode> node) { return derived().visitStatementNode(node); }
+    Result visitExpressionStatementNode(Ptr<ExpressionStatementNode> node) { return derived().visitStatementNode(node); }
+    Result visitMatchStatementNode(Ptr<MatchStatementNode> node) { return derived().visitStatementNode(node); }
+    Result visitBreakStatementNode(Ptr<BreakStatementNode> node) { return derived().visitStatementNode(node); }
+    Result visitContinueStatementNode(Ptr<ContinueStatementNode> node) { return derived().visitStatementNode(node); }
+    Result visitRetStatementNode(Ptr<RetStatementNode> node) { return derived().visitStatementNode(node); }
+    Result visitCaseClauseNode(Ptr<CaseClauseNode> node) { return derived().visitNode(node); }
+    Result visitBinaryExprNode(Ptr<BinaryExprNode> node) { return derived().visitExpressionNode(node); }
+    Result visitUnaryExprNode(Ptr<UnaryExprNode> node) { return derived().visitExpressionNode(node); }
+    Result visitPrimaryExprNode(Ptr<PrimaryExprNode> node) { return derived().visitExpressionNode(node); }
+    Result visitLiteralNode(Ptr<LiteralNode> node) { return derived().visitExpressionNode(node); }
+    Result visitIdentifierNode(Ptr<IdentifierNode> node) { return derived().visitExpressionNode(node); }
+    Result visitTypeNode(Ptr<TypeNode> node) { return derived().visitNode(node); }
+
+    Result visitDeclarationNode(Ptr<DeclarationNode> node) { return derived().visitNode(node); }
+    Result visitStatementNode(Ptr<StatementNode> node) { return derived().visitNode(node); }
+    Result visitExpressionNode(Ptr<ExpressionNode> node) { return derived().visitNode(node); }
+    Result visitNode(Ptr<ASTNode>) { return Result(); }
+
+private:
+    Derived &derived()
+    {
+        return *static_cast<Derived *>(this);
+    }
+};
+
+// Visitor of mutable nodes, for passes which rewrite the tree.
+template <typename Derived, typename Result = void>
+using ASTVisitor = ASTVisitorBase<detail::NodePointer, Derived, Result>;
+
+// Visitor of const nodes, for passes which only read the tree.
+template <typename Derived, typename Result = void>
+using ConstASTVisitor = ASTVisitorBase<detail::ConstNodePointer, Derived, Result>;
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef BACKEND_HH
+#define BACKEND_HH
+
+#include <memory>
+#include <string>
+#include "driver.hh"
+#include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+
+/**
+ * @brief Create the machine code generator for the host, or for another architecture.
+ * @param march LLVM name of the architecture, empty for the host.
+ * @param error Set to the reason when nullptr is returned.
+ */
+std::unique_ptr<llvm::TargetMachine> create_target_machine(const std::string &march, OptimizationLevel level, std::string &error);
+
+/**
+ * @brief Run the LLVM pass pipeline matching the optimization level on the module.
+ */
+void optimize_module(llvm::Module &module, llvm::TargetMachine &target, OptimizationLevel level);
+
+/**
+ * @brief Write the module as LLVM IR, assembly or an object file depending on the stage.
+ * @return False with error set if the file could not be written.
+ */
+bool emit_module(llvm::Module &module, llvm::TargetMachine &target, StageType stage, const std::string &path, std::string &error);
+
+/**
+ * @brief Extension of the file emit_module writes for the stage.
+ */
+const char *output_extension(StageType stage);
+
+#endif
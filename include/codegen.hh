@@ -0,0 +1,118 @@
+#ifndef CODEGEN_HH
+#define CODEGEN_HH
+
+#include <memory>
+#include <vector>
+#include "ast.hh"
+#include "interner.hh"
+#include "print.hh"
+#include "types.hh"
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/ScopedHashTable.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+
+/**
+ * @brief Lowers the AST of an analyzed translation unit to an LLVM module.
+ *
+ * Declared types are the ones semantic analysis resolved, structs become
+ * LLVM structs of their fields. Expressions are typed bottom up: a variable
+ * has its declared type, and a literal takes the type semantic analysis gave
+ * it, otherwise the type its context expects, defaulting to i32 and f64.
+ * Operands of different types are converted to the wider one, and values are
+ * converted to the type of the variable or return value they end up in.
+ *
+ * A match dispatches on the sorted values of its cases. Runs of cases dense
+ * enough for a jump table become a switch, and a balanced tree of compares
+ * selects between the runs and the remaining sparse cases.
+ */
+class CodeGenerator
+{
+public:
+    CodeGenerator(llvm::LLVMContext &llvm_context, const StringInterner &names, PrintGlobalState &print);
+
+    /**
+     * @brief Generate the module of a program for the target.
+     * @param file File the program was parsed from, errors are reported at the offsets of its nodes.
+     * @return The module, or nullptr if an error was reported.
+     */
+    std::unique_ptr<llvm::Module> generate(const ProgramNode *program, FileID file, llvm::StringRef module_name, const llvm::TargetMachine &target);
+
+private:
+    struct TypedValue
+    {
+        llvm::Value *value;
+        bool is_signed;
+    };
+
+    struct Variable
+    {
+        llvm::AllocaInst *address;
+        bool is_signed;
+    };
+
+    struct Loop
+    {
+        llvm::BasicBlock *header;
+        llvm::BasicBlock *exit;
+    };
+
+    struct Case
+    {
+        llvm::ConstantInt *value;
+        llvm::BasicBlock *block;
+    };
+
+    struct CaseCluster
+    {
+        size_t first; ///< Index of the first case of the cluster in the sorted cases.
+        size_t last;  ///< Index one past the last case.
+    };
+
+    llvm::LLVMContext &llvm_context;
+    const StringInterner &names;
+    PrintGlobalState &print;
+    FileID file;
+    std::unique_ptr<llvm::Module> module;
+    llvm::IRBuilder<> builder;
+    llvm::ScopedHashTable<NameID, Variable> variables;
+    llvm::DenseMap<const StructType *, llvm::StructType *> structs; ///< Lowered once per module.
+    std::vector<Loop> loops;
+    llvm::Function *function;
+    bool returns_signed; ///< Whether the return type of the function is signed.
+    bool failed;
+
+    llvm::Type *getType(const Type *type);
+    llvm::Type *getType(const PrimitiveType *type);
+    static bool isSigned(const Type *type);
+    void error(const std::string &message, const ASTNode *node);
+
+    void generateFunction(const FunctionDeclarationNode *declaration);
+    void generateStatement(const StatementNode *statement);
+    void generateBlock(const BlockNode *block);
+    void generateIf(const IfStatementNode *statement);
+    void generateLoop(const LoopStatementNode *statement);
+    void generateVarDeclaration(const VarDeclarationNode *declaration);
+    void generateMatch(const MatchStatementNode *statement);
+    void generateStringMatch(const MatchStatementNode *statement);
+    static llvm::SmallVector<CaseCluster, 16> clusterCases(llvm::ArrayRef<Case> cases);
+    void generateCaseTree(llvm::Value *subject, bool is_signed, llvm::ArrayRef<Case> cases, llvm::ArrayRef<CaseCluster> clusters, llvm::BasicBlock *otherwise);
+    void generateRet(const RetStatementNode *statement);
+
+    TypedValue generateExpression(const ExpressionNode *expression, llvm::Type *expected);
+    TypedValue generateLiteral(const LiteralNode *literal, llvm::Type *expected);
+    TypedValue generateUnary(const UnaryExprNode *expression, llvm::Type *expected);
+    TypedValue generateBinary(const BinaryExprNode *expression, llvm::Type *expected);
+    TypedValue generateAssignment(const BinaryExprNode *expression);
+    TypedValue generateLogical(const BinaryExprNode *expression);
+    TypedValue generateOperation(Operator op, TypedValue left, TypedValue right, const ExpressionNode *expression);
+    llvm::Value *generateIntegerPower(llvm::Value *base, llvm::Value *exponent, bool is_signed);
+    Variable lookupVariable(const ExpressionNode *expression, Operator op);
+    llvm::Value *convert(TypedValue value, llvm::Type *type, bool is_signed, const ExpressionNode *expression);
+    llvm::Value *toCondition(TypedValue value, const ExpressionNode *expression);
+    llvm::AllocaInst *createEntryAlloca(llvm::Type *type, llvm::StringRef name);
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef CONSTANT_HH
+#define CONSTANT_HH
+
+#include <optional>
+#include <string>
+#include "ast_visitor.hh"
+#include "print.hh"
+#include "types.hh"
+#include <llvm/ADT/APFloat.h>
+#include <llvm/ADT/APSInt.h>
+
+/**
+ * @brief Value of an expression known at compile time.
+ */
+struct ConstantValue
+{
+    ConstantValue(const PrimitiveType *type, llvm::APSInt integer)
+        : type(type), integer(std::move(integer)), real(0.0) {}
+    ConstantValue(const PrimitiveType *type, llvm::APFloat real)
+        : type(type), real(std::move(real)) {}
+
+    const PrimitiveType *type;
+    llvm::APSInt integer; ///< Value of an integer, char or bool, exactly as wide and signed as its type.
+    llvm::APFloat real;   ///< Value of a float, in the semantics of its type.
+};
+
+/**
+ * @brief Evaluates expressions at compile time and folds constant subtrees of a program.
+ *
+ * Runs on a tree semantic analysis typed without errors. Literals are
+ * evaluated in the type semantic analysis gave them, operations in the type
+ * code generation computes them in, with the integer widths of DATA_TYPES, so
+ * folding never changes what a program computes. Results which code
+ * generation would leave undefined or wrap are errors instead: literals and
+ * results out of the range of their type, division by zero and shifts by at
+ * least the width of their type, and cases of a match statement with the
+ * value of an earlier case. The right operand of && and || is only evaluated
+ * when the left one does not decide the result, like at run time.
+ *
+ * Folding replaces every constant subtree, which is not a literal already, by
+ * a literal of its value and type, so code generation emits a single constant
+ * for it.
+ */
+class ConstantEvaluator : public ASTVisitor<ConstantEvaluator>
+{
+public:
+    ConstantEvaluator(ASTContext &context, TypeContext &types, PrintGlobalState &print, FileID file);
+
+    /**
+     * @brief Evaluate an expression.
+     * @return The value, or nothing if the expression is not constant or an error was reported.
+     */
+    std::optional<ConstantValue> evaluate(const ExpressionNode *expression);
+
+    /**
+     * @brief Fold the constant subtrees of every expression of a program.
+     * @return Whether no error was reported.
+     */
+    bool fold(ProgramNode *program);
+
+    void visitFunctionDeclarationNode(FunctionDeclarationNode *function);
+    void visitBlockNode(BlockNode *block);
+    void visitIfStatementNode(IfStatementNode *statement);
+    void visitLoopStatementNode(LoopStatementNode *statement);
+    void visitVarDeclarationNode(VarDeclarationNode *declaration);
+    void visitExpressionStatementNode(ExpressionStatementNode *statement);
+    void visitMatchStatementNode(MatchStatementNode *statement);
+    void visitRetStatementNode(RetStatementNode *statement);
+
+private:
+    ASTContext &context;
+    TypeContext &types;
+    PrintGlobalState &print;
+    FileID file; ///< File errors are reported in, at the offsets of their nodes.
+    bool failed;
+
+    void error(const std::string &message, const ASTNode *node);
+    void foldExpression(ExpressionNode *&expression);
+    std::optional<ConstantValue> compute(ExpressionNode *expression, bool fold);
+    void materialize(ExpressionNode *&expression, std::optional<ConstantValue> &value);
+    std::optional<ConstantValue> computeLiteral(const LiteralNode *literal, bool negated);
+    std::optional<ConstantValue> computeUnary(const UnaryExprNode *expression, const ConstantValue &operand, const PrimitiveType *type);
+    std::optional<ConstantValue> computeBinary(const BinaryExprNode *expression, const ConstantValue &left, const ConstantValue &right, const PrimitiveType *type);
+    std::optional<ConstantValue> computeIntegerPower(const llvm::APSInt &base, const llvm::APSInt &exponent, const PrimitiveType *type, const ASTNode *node);
+    std::optional<ConstantValue> convert(const ConstantValue &value, const PrimitiveType *type, const ASTNode *node);
+    bool isTrue(const ConstantValue &value) const;
+    std::optional<ConstantValue> overflow(const PrimitiveType *type, const ASTNode *node);
+};
+
+#endif
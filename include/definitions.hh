@@ -4,10 +4,12 @@
 #include <string>
 #include <array>
 #include <algorithm>
+#include <cstdint>
 #include <optional>
+#include <string_view>
 #include <token.hh>
 
-constexpr std::array<std::string_view, 17> DATA_TYPES = {
+constexpr std::array<std::string_view, 16> DATA_TYPES = {
     "u8", "u16", "u32", "u64", "i8", "i16", "i32", "i64",
     "f32", "f64", "u128", "i128", "f80", "f128", "char", "bool"};
 
@@ -18,32 +20,167 @@ constexpr std::array<std::string_view, 21> KEYWORDS = {
     "asm", "if", "elif", "else", "loop", "fn", "ret", "true", "false", "ref", "deref",
     "struct", "sync", "enum", "void", "volatile", "null", "import", "break", "continue", "match"};
 
-std::optional<int_t> find_dt(const std::string_view &x)
+static_assert(KW_COUNT == KEYWORDS.size() + 1 && KEYWORDS[KW_ASM - 1] == "asm" && KEYWORDS[KW_FN - 1] == "fn" &&
+                  KEYWORDS[KW_STRUCT - 1] == "struct" && KEYWORDS[KW_MATCH - 1] == "match",
+              "Keyword must list the keywords in the order of KEYWORDS");
+
+/**
+ * Classification of a word, data types take precedence over keywords
+ * which take precedence over architecture specific data types.
+ */
+enum class WordClass : uint8_t
+{
+    IDENTIFIER,
+    DATATYPE,
+    KEYWORD,
+    ARCH_DATATYPE,
+};
+
+struct WordInfo
+{
+    std::string_view word;
+    WordClass word_class;
+    uint8_t index;      ///< Index into the list of the class.
+    int8_t arch_index;  ///< Index into ARCH_SPECIFIC_TYPES, or -1.
+};
+
+namespace detail
+{
+    constexpr size_t WORD_TABLE_SIZE = 128;
+    constexpr size_t MIN_WORD_LENGTH = 2;
+    constexpr size_t MAX_WORD_LENGTH = 8;
+
+    // Only looks at the length, the first two and the last character, which
+    // already tells every word apart. The seed spreads them without collisions.
+    constexpr size_t word_slot(std::string_view word, uint32_t seed)
+    {
+        uint32_t key = static_cast<uint32_t>(word.size()) |
+                       static_cast<uint32_t>(static_cast<unsigned char>(word[0])) << 8 |
+                       static_cast<uint32_t>(static_cast<unsigned char>(word[1])) << 16 |
+                       static_cast<uint32_t>(static_cast<unsigned char>(word[word.size() - 1])) << 24;
+        return (key * seed) >> (32 - 7);
+    }
+
+    constexpr size_t WORD_COUNT = DATA_TYPES.size() + KEYWORDS.size() + ARCH_SPECIFIC_TYPES.size();
+
+    // Every word in order of precedence.
+    constexpr std::array<WordInfo, WORD_COUNT> build_word_list()
+    {
+        std::array<WordInfo, WORD_COUNT> words = {};
+        size_t n = 0;
+        for (size_t i = 0; i < DATA_TYPES.size(); i++)
+        {
+            words[n++] = {DATA_TYPES[i], WordClass::DATATYPE, static_cast<uint8_t>(i), -1};
+        }
+        for (size_t i = 0; i < KEYWORDS.size(); i++)
+        {
+            words[n++] = {KEYWORDS[i], WordClass::KEYWORD, static_cast<uint8_t>(i), -1};
+        }
+        for (size_t i = 0; i < ARCH_SPECIFIC_TYPES.size(); i++)
+        {
+            words[n++] = {ARCH_SPECIFIC_TYPES[i], WordClass::ARCH_DATATYPE, static_cast<uint8_t>(i), static_cast<int8_t>(i)};
+        }
+        return words;
+    }
+
+    constexpr std::array<WordInfo, WORD_COUNT> WORD_LIST = build_word_list();
+
+    constexpr bool is_perfect_seed(uint32_t seed)
+    {
+        size_t used[WORD_TABLE_SIZE] = {};
+        for (size_t i = 0; i < WORD_COUNT; i++)
+        {
+            size_t slot = word_slot(WORD_LIST[i].word, seed);
+            if (used[slot] != 0 && WORD_LIST[used[slot] - 1].word != WORD_LIST[i].word)
+            {
+                return false;
+            }
+            used[slot] = i + 1;
+        }
+        return true;
+    }
+
+    constexpr uint32_t find_perfect_seed()
+    {
+        uint32_t seed = 0x9e3779b1;
+        while (!is_perfect_seed(seed))
+        {
+            seed += 2;
+        }
+        return seed;
+    }
+
+    constexpr uint32_t WORD_SEED = find_perfect_seed();
+
+    constexpr std::array<WordInfo, WORD_TABLE_SIZE> build_word_table()
+    {
+        std::array<WordInfo, WORD_TABLE_SIZE> table = {};
+        for (size_t i = 0; i < WORD_TABLE_SIZE; i++)
+        {
+            table[i] = {std::string_view(), WordClass::IDENTIFIER, 0, -1};
+        }
+        for (size_t i = 0; i < WORD_COUNT; i++)
+        {
+            const WordInfo &word = WORD_LIST[i];
+            WordInfo &entry = table[word_slot(word.word, WORD_SEED)];
+            if (entry.word.empty())
+            {
+                entry = word;
+            }
+            else if (word.word_class == WordClass::ARCH_DATATYPE)
+            {
+                entry.arch_index = word.arch_index;
+            }
+        }
+        return table;
+    }
+
+    constexpr std::array<WordInfo, WORD_TABLE_SIZE> WORD_TABLE = build_word_table();
+}
+
+/**
+ * Classify a word as keyword, data type, architecture specific data type or
+ * identifier with a single probe into a perfect hash table.
+ */
+constexpr WordInfo classify_word(std::string_view x)
+{
+    if (x.size() >= detail::MIN_WORD_LENGTH && x.size() <= detail::MAX_WORD_LENGTH)
+    {
+        const WordInfo &entry = detail::WORD_TABLE[detail::word_slot(x, detail::WORD_SEED)];
+        if (entry.word == x)
+        {
+            return entry;
+        }
+    }
+    return {x, WordClass::IDENTIFIER, 0, -1};
+}
+
+inline std::optional<int_t> find_dt(const std::string_view &x)
 {
-    auto it = std::find(DATA_TYPES.begin(), DATA_TYPES.end(), x);
-    if (it != DATA_TYPES.end())
+    WordInfo info = classify_word(x);
+    if (info.word_class == WordClass::DATATYPE)
     {
-        return std::distance(DATA_TYPES.begin(), it);
+        return info.index;
     }
     return std::nullopt;
 }
 
-std::optional<int_t> find_archdt(const std::string_view &x)
+inline std::optional<int_t> find_archdt(const std::string_view &x)
 {
-    auto it = std::find(ARCH_SPECIFIC_TYPES.begin(), ARCH_SPECIFIC_TYPES.end(), x);
-    if (it != ARCH_SPECIFIC_TYPES.end())
+    WordInfo info = classify_word(x);
+    if (info.arch_index >= 0)
     {
-        return std::distance(ARCH_SPECIFIC_TYPES.begin(), it);
+        return info.arch_index;
     }
     return std::nullopt;
 }
 
-std::optional<int_t> find_keyword(const std::string_view &x)
+inline std::optional<int_t> find_keyword(const std::string_view &x)
 {
-    auto it = std::find(KEYWORDS.begin(), KEYWORDS.end(), x);
-    if (it != KEYWORDS.end())
+    WordInfo info = classify_word(x);
+    if (info.word_class == WordClass::KEYWORD)
     {
-        return std::distance(KEYWORDS.begin(), it);
+        return info.index;
     }
     return std::nullopt;
 }
@@ -0,0 +1,94 @@
+#ifndef DRIVER_HH
+#define DRIVER_HH
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ast_cache.hh"
+#include "print.hh"
+#include "source.hh"
+#include "threadpool.hh"
+#include "timing.hh"
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+
+enum OptimizationLevel
+{
+    g,
+    O0,
+    O1,
+    O2,
+    O3
+};
+
+enum StageType
+{
+    c,
+    S,
+    B,
+    C,
+    R
+};
+
+struct DriverOptions
+{
+    StageType stage = c;
+    OptimizationLevel optimization = g;
+    std::string output;   ///< Output file, by default the input file with the extension of the stage.
+    std::string march;    ///< LLVM name of the target architecture, empty for the host.
+    unsigned jobs = 0; ///< Threads compiling files, 0 for one per hardware thread. Threads beyond one per file parse large files.
+    bool time_report = false;
+    std::string time_trace; ///< File to write Chrome trace events of the timed phases to.
+    std::string ast_cache;  ///< Directory the ASTs of files are cached in, empty for no cache.
+    DiagnosticFormat diagnostics_format = DiagnosticFormat::TEXT;
+};
+
+/**
+ * @brief Compiles every input file, several at once.
+ *
+ * Files are loaded up front on the calling thread, then every file is compiled
+ * as an independent job of a ThreadPool, from lexing to emitting its output. A file only shares the read only
+ * SourceManager with the others, it has its own names, AST and diagnostics.
+ * Large files split their parsing into jobs of the same pool, which workers
+ * left without a file of their own take.
+ * Diagnostics are buffered per file without locking and handed to a
+ * DiagnosticsWriter, which writes them in the order of the input files, so the
+ * output does not depend on the number of jobs. Diagnostics of the driver
+ * itself follow those of the files.
+ */
+class Driver
+{
+public:
+    Driver(const DriverOptions &options, std::ostream &diagnostics = std::cerr);
+
+    /**
+     * @brief Compile the files, and run them for the R stage.
+     * @return The exit code of the compiler, or of the program when it was run.
+     */
+    int run(const std::vector<std::string> &files);
+
+private:
+    struct CompilationUnit
+    {
+        FileID file;
+        std::string output;
+        llvm::orc::ThreadSafeModule module; ///< Kept to be run once every file is compiled.
+        std::ostringstream diagnostics;
+        bool failed = false;
+    };
+
+    DriverOptions options;
+    std::ostream &diagnostics;
+    SourceManager sources;
+    std::unique_ptr<TimeReport> report; ///< Only set when timing was requested.
+    std::unique_ptr<ASTCache> cache;    ///< Only set when a cache directory was given.
+    ThreadPool *pool = nullptr;         ///< Pool the files are compiled on, while they are.
+
+    int compileFiles(const std::vector<std::string> &files, PrintGlobalState &print, DiagnosticsWriter &writer);
+    void compile(CompilationUnit &unit);
+    ProgramNode *parse(CompilationUnit &unit, ASTContext &context, StringInterner &names, PrintGlobalState &print);
+    int execute(std::vector<std::unique_ptr<CompilationUnit>> &units, PrintGlobalState &print, DiagnosticsWriter &writer);
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef INCREMENTAL_HH
+#define INCREMENTAL_HH
+
+#include <memory>
+#include <vector>
+#include "ast.hh"
+#include "interner.hh"
+#include "print.hh"
+#include "source.hh"
+#include "token.hh"
+#include <llvm/Support/Allocator.h>
+#include <llvm/Support/StringSaver.h>
+
+/**
+ * @brief Keeps the tokens and AST of a file up to date while it is edited.
+ *
+ * An edit is relexed from the token before it until the new tokens line up
+ * with the previous ones again, only the top-level declarations containing
+ * changed tokens are parsed again and every other declaration is reused.
+ * Adjusting the positions of the reused tokens is the only work done for the
+ * rest of the file.
+ *
+ * The list of declarations of the returned ProgramNode is owned by the session.
+ */
+class IncrementalSession
+{
+public:
+    struct EditStats
+    {
+        size_t relexed_tokens;        ///< Tokens produced by relexing.
+        size_t reparsed_declarations; ///< Top-level declarations parsed again.
+    };
+
+    IncrementalSession(SourceManager &sources, FileID file, StringInterner &names, PrintGlobalState &print);
+
+    IncrementalSession(const IncrementalSession &) = delete;
+    IncrementalSession &operator=(const IncrementalSession &) = delete;
+
+    /**
+     * @brief Lex and parse the whole file.
+     * @return AST of the file, valid until the next call to parse() or applyEdit().
+     */
+    ProgramNode *parse();
+
+    /**
+     * @brief Apply an edit to the file and update the tokens and the AST.
+     * @param edit Edit to apply, its range must lie within the file.
+     * @return AST of the edited file, valid until the next call to parse() or applyEdit().
+     */
+    ProgramNode *applyEdit(const TextEdit &edit);
+
+    const std::vector<Token> &getTokens() const;
+
+    ProgramNode *getProgram() const;
+
+    const EditStats &getLastEditStats() const;
+
+private:
+    /// Top-level declaration and its range of tokens, the ranges cover every token.
+    struct TopLevel
+    {
+        DeclarationNode *declaration; ///< Null if the tokens could not be parsed.
+        int_t first, last;
+    };
+
+    SourceManager &sources;
+    FileID file;
+    StringInterner &names;
+    PrintGlobalState &print;
+    std::vector<Token> tokens;
+    std::vector<TopLevel> top_levels;
+    std::vector<DeclarationNode *> declarations; ///< Parsed declarations of `top_levels`.
+    std::unique_ptr<ASTContext> context;
+    size_t parsed_bytes;                    ///< Size of the AST after the last full parse.
+    ProgramNode *program;
+    llvm::BumpPtrAllocator literal_storage; ///< Decoded literals of the tokens.
+    llvm::StringSaver literals;
+    EditStats stats;
+
+    void relex(const TextEdit &edit, int_t &begin, int_t &old_end, int_t &new_end);
+    size_t reparse(int_t begin, int_t old_end, int_t new_end);
+    void keepLiterals(std::vector<Token>::iterator first, std::vector<Token>::iterator last);
+};
+
+#endif
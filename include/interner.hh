@@ -0,0 +1,50 @@
+#ifndef INTERNER_HH
+#define INTERNER_HH
+
+#include <cstdint>
+#include <vector>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Allocator.h>
+#include "token.hh"
+
+/**
+ * @brief Interns the identifiers of a compilation.
+ *
+ * Equal strings get equal IDs of type NameID, ID 0 is the empty string and
+ * is used for nameless nodes.
+ * Every distinct string is stored once, names can then be compared and hashed
+ * as integers. The interner outlives every Lexer, AST and SymbolTable using its
+ * IDs. It is not thread safe.
+ */
+class StringInterner
+{
+public:
+    StringInterner();
+    StringInterner(const StringInterner &) = delete;
+    StringInterner &operator=(const StringInterner &) = delete;
+
+    /**
+     * @brief Get the ID of a string, adding it if it was not interned before.
+     */
+    NameID intern(llvm::StringRef str);
+
+    /**
+     * @brief Get the string of an ID, valid as long as the interner.
+     */
+    llvm::StringRef get(NameID id) const
+    {
+        return names[id];
+    }
+
+    size_t size() const
+    {
+        return names.size();
+    }
+
+private:
+    llvm::StringMap<NameID, llvm::BumpPtrAllocator> ids;
+    std::vector<llvm::StringRef> names; ///< String of every ID, pointing into `ids`.
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef JIT_HH
+#define JIT_HH
+
+#include <string>
+#include <vector>
+#include "driver.hh"
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+
+/**
+ * @brief Run the main function of a program in process.
+ *
+ * The modules are handed to an ORC LLLazyJIT, which compiles a function to
+ * machine code the first time it is called. Functions never reached are never
+ * compiled, so the startup cost follows what the program uses instead of how
+ * large it is.
+ *
+ * @param modules Modules of every file of the program, generated for the host.
+ * @param exit_code Set to the value returned by main, 0 if it returns nothing.
+ * @param error Set to the reason when the program could not be run.
+ * @return False if the program could not be run.
+ */
+bool run_main(std::vector<llvm::orc::ThreadSafeModule> modules, OptimizationLevel level, int &exit_code, std::string &error);
+
+#endif
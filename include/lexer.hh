@@ -5,7 +5,12 @@
 #include <vector>
 #include "token.hh"
 #include "print.hh"
+#include "source.hh"
+#include "scan.hh"
+#include "interner.hh"
 #include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Allocator.h>
+#include <llvm/Support/StringSaver.h>
 
 /**
  * @brief Lexer class for lexical analysis of a source file.
@@ -15,30 +20,69 @@ class Lexer
 public:
     /**
      * @brief Constructor for Lexer.
-     * @param file Content of the file to lex.
-     * @param file_name Name of the file being lexed.
+     * @param sources SourceManager owning the file.
+     * @param file ID of the file to lex.
+     * @param names Interner for the identifiers of the file.
      * @param print PrintGlobalState object for printing.
      */
-    Lexer(const std::string &file, const std::string &file_name, PrintGlobalState &print);
+    Lexer(const SourceManager &sources, FileID file, StringInterner &names, PrintGlobalState &print);
+
+    Lexer(const Lexer &) = delete;
+    Lexer &operator=(const Lexer &) = delete;
 
     /**
      * @brief Lexical analysis of the file.
-     * @return Vector of tokens generated from the lexing process.
+     * @return Reference to the tokens generated from the lexing process.
+     *         The tokens reference the file content and are only valid while
+     *         this Lexer and the SourceManager are alive.
+     */
+    const std::vector<Token> &lex();
+
+    /**
+     * @brief Lex the next token of the file, instead of the whole file with lex().
+     * @return The token, or the end of file token once the end is reached.
+     *         Tokens are not kept, the vector returned by getTokens() only
+     *         ever holds the last one.
+     */
+    Token next();
+
+    /**
+     * @brief Move the lexer to an offset, to lex only part of the file.
+     * @param offset Offset to continue lexing at, must be the start of a token
+     *               or lie between tokens, comments and literals.
+     * @param line Line number of the offset.
+     */
+    void seek(size_t offset, size_t line);
+
+    /**
+     * @brief Lex tokens until the lexer reaches an offset, used for incremental lexing.
+     * @param until Offset to stop at, lexing stops at the first token boundary at or after it.
+     * @return Offset lexing stopped at. The end of file token is added once the end is reached.
+     */
+    size_t lexUntil(size_t until);
+
+    /**
+     * @brief Get the tokens lexed so far.
+     * @return Reference to the tokens.
      */
-    std::vector<Token> lex();
+    const std::vector<Token> &getTokens() const;
 
     /**
      * @brief Get the content of the file being lexed.
-     * @return Reference to the file content.
+     * @return View of the file content.
      */
     llvm::StringRef getFile();
 
 private:
     size_t line, col;                ///< Current line and column in the file.
     std::vector<Token> tokens;       ///< Tokens generated during lexing.
-    std::string file;                ///< Content of the file to lex.
-    std::string file_name;           ///< Name of the file being lexed.
+    llvm::StringRef file;            ///< Content of the file to lex.
+    FileID file_id;                  ///< ID of the file being lexed.
+    StringInterner &names;           ///< Interner for identifiers.
     PrintGlobalState &print;         ///< Reference to PrintGlobalState for printing.
+    const ScanKernels &scan;         ///< Kernels skipping runs of characters.
+    llvm::BumpPtrAllocator literal_storage; ///< Backing storage for decoded literals.
+    llvm::StringSaver literals;      ///< Interns literals which contain escape sequences.
 
     /**
      * @brief Get the current character in the file.
@@ -63,6 +107,25 @@ private:
      */
     inline void advance();
 
+    /**
+     * @brief Get the end of the file content.
+     * @return Pointer past the last character.
+     */
+    inline const char *end() const;
+
+    /**
+     * @brief Get a view of the file content without copying it.
+     * @param start Offset of the first character.
+     * @param length Number of characters.
+     * @return View into the file content.
+     */
+    inline std::string_view slice(size_t start, size_t length) const;
+
+    /**
+     * @brief Lex the token, whitespace or comment at the current offset.
+     */
+    inline void lexToken();
+
     /**
      * @brief Handle keywords, datatypes, or identifiers.
      */
@@ -102,6 +165,12 @@ private:
      */
     void handleCharLiteral();
 
+    /**
+     * @brief Decode the up to 4 hex digits of a \\u escape sequence.
+     * @return Decoded character.
+     */
+    char unicodeEscape();
+
     /**
      * @brief Handle comments.
      */
@@ -0,0 +1,199 @@
+#ifndef OPERATORS_HH
+#define OPERATORS_HH
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Every operator the lexer produces, in the order of OPERATOR_INFO.
+ */
+enum class Operator : uint8_t
+{
+    NONE,
+    ASSIGN,
+    ADD_ASSIGN,
+    SUB_ASSIGN,
+    MUL_ASSIGN,
+    DIV_ASSIGN,
+    MOD_ASSIGN,
+    POW_ASSIGN,
+    AND_ASSIGN,
+    OR_ASSIGN,
+    LOGICAL_OR,
+    LOGICAL_AND,
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    GREATER,
+    LESS_EQUAL,
+    GREATER_EQUAL,
+    BIT_OR,
+    BIT_AND,
+    SHIFT_LEFT,
+    SHIFT_RIGHT,
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    MOD,
+    POW,
+    NOT,
+    BIT_NOT,
+    INCREMENT,
+    DECREMENT,
+    ARROW,
+    COUNT
+};
+
+/**
+ * Binding strength of binary operators, from loosest to tightest.
+ */
+enum Precedence : uint8_t
+{
+    PREC_NONE, ///< Not a binary operator.
+    PREC_ASSIGN,
+    PREC_LOGICAL_OR,
+    PREC_LOGICAL_AND,
+    PREC_EQUALITY,
+    PREC_RELATIONAL,
+    PREC_BIT_OR,
+    PREC_BIT_AND,
+    PREC_SHIFT,
+    PREC_ADDITIVE,
+    PREC_MULTIPLICATIVE,
+    PREC_POWER,
+};
+
+struct OperatorInfo
+{
+    std::string_view spelling;
+    Precedence precedence;  ///< Precedence as a binary operator.
+    bool right_associative;
+    bool prefix;            ///< May be used as a prefix operator.
+    Operator compound;      ///< Operator an assignment like `+=` applies, NONE for others.
+};
+
+constexpr std::array<OperatorInfo, static_cast<size_t>(Operator::COUNT)> OPERATOR_INFO = {{
+    {"", PREC_NONE, false, false, Operator::NONE},
+    {"=", PREC_ASSIGN, true, false, Operator::NONE},
+    {"+=", PREC_ASSIGN, true, false, Operator::ADD},
+    {"-=", PREC_ASSIGN, true, false, Operator::SUB},
+    {"*=", PREC_ASSIGN, true, false, Operator::MUL},
+    {"/=", PREC_ASSIGN, true, false, Operator::DIV},
+    {"%=", PREC_ASSIGN, true, false, Operator::MOD},
+    {"^=", PREC_ASSIGN, true, false, Operator::POW},
+    {"&=", PREC_ASSIGN, true, false, Operator::BIT_AND},
+    {"|=", PREC_ASSIGN, true, false, Operator::BIT_OR},
+    {"||", PREC_LOGICAL_OR, false, false, Operator::NONE},
+    {"&&", PREC_LOGICAL_AND, false, false, Operator::NONE},
+    {"==", PREC_EQUALITY, false, false, Operator::NONE},
+    {"!=", PREC_EQUALITY, false, false, Operator::NONE},
+    {"<", PREC_RELATIONAL, false, false, Operator::NONE},
+    {">", PREC_RELATIONAL, false, false, Operator::NONE},
+    {"<=", PREC_RELATIONAL, false, false, Operator::NONE},
+    {">=", PREC_RELATIONAL, false, false, Operator::NONE},
+    {"|", PREC_BIT_OR, false, false, Operator::NONE},
+    {"&", PREC_BIT_AND, false, false, Operator::NONE},
+    {"<<", PREC_SHIFT, false, false, Operator::NONE},
+    {">>", PREC_SHIFT, false, false, Operator::NONE},
+    {"+", PREC_ADDITIVE, false, true, Operator::NONE},
+    {"-", PREC_ADDITIVE, false, true, Operator::NONE},
+    {"*", PREC_MULTIPLICATIVE, false, false, Operator::NONE},
+    {"/", PREC_MULTIPLICATIVE, false, false, Operator::NONE},
+    {"%", PREC_MULTIPLICATIVE, false, false, Operator::NONE},
+    {"^", PREC_POWER, true, false, Operator::NONE},
+    {"!", PREC_NONE, false, true, Operator::NONE},
+    {"~", PREC_NONE, false, true, Operator::NONE},
+    {"++", PREC_NONE, false, true, Operator::NONE},
+    {"--", PREC_NONE, false, true, Operator::NONE},
+    {"->", PREC_NONE, false, false, Operator::NONE},
+}};
+
+inline const OperatorInfo &operator_info(Operator op)
+{
+    return OPERATOR_INFO[static_cast<size_t>(op)];
+}
+
+namespace detail
+{
+    // Picks the operator by `second`, the character after the first one or '\0' if there is none.
+    constexpr Operator pick_operator(char second, Operator alone, Operator with_equal, char other = '\0', Operator with_other = Operator::NONE)
+    {
+        if (second == '\0')
+        {
+            return alone;
+        }
+        if (second == '=')
+        {
+            return with_equal;
+        }
+        return second == other ? with_other : Operator::NONE;
+    }
+}
+
+/**
+ * @brief Get the operator of a lexeme the lexer classified as operator, NONE if it is none.
+ */
+constexpr Operator classify_operator(std::string_view lexeme)
+{
+    if (lexeme.empty() || lexeme.size() > 2)
+    {
+        return Operator::NONE;
+    }
+    char second = lexeme.size() == 2 ? lexeme[1] : '\0';
+    switch (lexeme[0])
+    {
+    case '=':
+        return detail::pick_operator(second, Operator::ASSIGN, Operator::EQUAL);
+    case '!':
+        return detail::pick_operator(second, Operator::NOT, Operator::NOT_EQUAL);
+    case '<':
+        return detail::pick_operator(second, Operator::LESS, Operator::LESS_EQUAL, '<', Operator::SHIFT_LEFT);
+    case '>':
+        return detail::pick_operator(second, Operator::GREATER, Operator::GREATER_EQUAL, '>', Operator::SHIFT_RIGHT);
+    case '+':
+        return detail::pick_operator(second, Operator::ADD, Operator::ADD_ASSIGN, '+', Operator::INCREMENT);
+    case '-':
+        if (second == '>')
+        {
+            return Operator::ARROW;
+        }
+        return detail::pick_operator(second, Operator::SUB, Operator::SUB_ASSIGN, '-', Operator::DECREMENT);
+    case '*':
+        return detail::pick_operator(second, Operator::MUL, Operator::MUL_ASSIGN);
+    case '/':
+        return detail::pick_operator(second, Operator::DIV, Operator::DIV_ASSIGN);
+    case '%':
+        return detail::pick_operator(second, Operator::MOD, Operator::MOD_ASSIGN);
+    case '^':
+        return detail::pick_operator(second, Operator::POW, Operator::POW_ASSIGN);
+    case '&':
+        return detail::pick_operator(second, Operator::BIT_AND, Operator::AND_ASSIGN, '&', Operator::LOGICAL_AND);
+    case '|':
+        return detail::pick_operator(second, Operator::BIT_OR, Operator::OR_ASSIGN, '|', Operator::LOGICAL_OR);
+    case '~':
+        return detail::pick_operator(second, Operator::BIT_NOT, Operator::NONE);
+    default:
+        return Operator::NONE;
+    }
+}
+
+namespace detail
+{
+    constexpr bool classifies_every_operator()
+    {
+        for (size_t i = 1; i < OPERATOR_INFO.size(); i++)
+        {
+            if (classify_operator(OPERATOR_INFO[i].spelling) != static_cast<Operator>(i))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+static_assert(detail::classifies_every_operator(), "classify_operator and OPERATOR_INFO disagree");
+
+#endif
@@ -2,57 +2,103 @@
 #define PARSER_HH
 
 #include <vector>
-#include <memory>
 #include <string>
+#include <string_view>
 #include "token.hh"
 #include "ast.hh"
 #include "print.hh"
+#include "source.hh"
+#include "threadpool.hh"
+#include "token_stream.hh"
 
 class Parser
 {
 public:
-    Parser(const std::vector<Token> &tokens, const std::string &file, PrintGlobalState &print);
+    Parser(const std::vector<Token> &tokens, ASTContext &context, FileID file, PrintGlobalState &print);
+    // The parser keeps referring to the tokens, they must outlive it.
+    Parser(std::vector<Token> &&tokens, ASTContext &context, FileID file, PrintGlobalState &print) = delete;
 
-    std::shared_ptr<ProgramNode> parse();
+    // Parse tokens as they are pulled from the lexer, without ever holding all of them.
+    // parse_declaration_at() can not be used, the tokens can not be revisited.
+    Parser(Lexer &lexer, ASTContext &context, FileID file, PrintGlobalState &print);
+
+    ProgramNode *parse();
+
+    // Split the tokens at the top-level declarations and parse the parts on the pool,
+    // each into its own context which `context` adopts. Gives the same tree as parse().
+    // Parses on the calling thread when pulling from a lexer, and parses again there
+    // when a part does not parse cleanly, so errors are reported in order. May be
+    // called from a job of the pool.
+    ProgramNode *parse(ThreadPool &pool);
+
+    // Parse the top-level declaration starting at the token at `position` and
+    // move `position` past it, used to reparse only part of a file.
+    DeclarationNode *parse_declaration_at(int_t &position);
+
+    // Number of tokens parsed so far, including the end of file token.
+    int_t token_count() const;
+
+    // Whether a top-level declaration starts at the token: 'fn', 'struct' or 'enum'.
+    static bool is_declaration_start(const Token &token);
 
 private:
-    const std::vector<Token> &tokens;
-    const std::string &file;
-    PrintGlobalState print;
-    int_t index;
+    TokenStream tokens;
+    ASTContext &context;
+    FileID file;
+    PrintGlobalState &print;
+    bool panicking; ///< An error was reported and the parser has not synchronized since.
 
-    Token current_token() const;
-    Token next_token() const;
+    const Token &current_token();
+    const Token &next_token();
     void advance();
-    Token match(TokenType expected_type);
-    Token match(TokenType expected_type, const std::string &expected_lexeme);
-
-    std::shared_ptr<DeclarationNode> parse_declaration();
-    std::shared_ptr<FunctionDeclarationNode> parse_function_declaration();
-    std::vector<std::shared_ptr<ParameterNode>> parse_parameters();
-    std::shared_ptr<ParameterNode> parse_parameter();
-    std::shared_ptr<TypeNode> parse_type();
-    std::shared_ptr<BlockNode> parse_block();
-    std::shared_ptr<StatementNode> parse_statement();
-    std::shared_ptr<IfStatementNode> parse_if_statement();
-    std::shared_ptr<LoopStatementNode> parse_loop_statement();
-    std::shared_ptr<VarDeclarationNode> parse_var_declaration();
-    std::shared_ptr<ExpressionStatementNode> parse_expression_statement();
-    std::shared_ptr<MatchStatementNode> parse_match_statement();
-    std::shared_ptr<CaseClauseNode> parse_case_clause();
-    std::shared_ptr<BreakStatementNode> parse_break_statement();
-    std::shared_ptr<ContinueStatementNode> parse_continue_statement();
-    std::shared_ptr<EnumDeclarationNode> parse_enum_declaration();
-    std::shared_ptr<StructDeclarationNode> parse_struct_declaration();
-
-    std::shared_ptr<ExpressionNode> parse_expression();
-    std::shared_ptr<ExpressionNode> parse_term();
-    std::shared_ptr<ExpressionNode> parse_factor();
-    std::shared_ptr<ExpressionNode> parse_unary_expr();
-    std::shared_ptr<ExpressionNode> parse_primary();
-    std::shared_ptr<LiteralNode> parse_literal();
+    const Token &match(TokenType expected_type);
+    // Report that `expected` was expected at the current token and start panicking.
+    void error(const std::string &expected);
+    // Skip past the next ';', or up to the next '}', 'fn', 'struct' or 'enum', and stop panicking.
+    void synchronize();
+    // Create a node in the context, located at `offset`.
+    template <typename T, typename... Args>
+    T *create(int_t offset, Args &&...args)
+    {
+        T *node = context.create<T>(std::forward<Args>(args)...);
+        node->offset = static_cast<uint32_t>(offset);
+        return node;
+    }
+
+    const Token &match(Keyword expected);
+    const Token &match(Separator expected);
+
+    DeclarationNode * parse_declaration();
+    FunctionDeclarationNode * parse_function_declaration();
+    llvm::ArrayRef<ParameterNode *> parse_parameters();
+    ParameterNode * parse_parameter();
+    TypeNode * parse_type();
+    BlockNode * parse_block();
+    StatementNode * parse_statement();
+    IfStatementNode * parse_if_statement();
+    LoopStatementNode * parse_loop_statement();
+    VarDeclarationNode * parse_var_declaration();
+    ExpressionStatementNode * parse_expression_statement();
+    MatchStatementNode * parse_match_statement();
+    CaseClauseNode * parse_case_clause();
+    BreakStatementNode * parse_break_statement();
+    ContinueStatementNode * parse_continue_statement();
+    RetStatementNode * parse_ret_statement();
+    EnumDeclarationNode * parse_enum_declaration();
+    StructDeclarationNode * parse_struct_declaration();
+
+    ExpressionNode * parse_expression(Precedence min_precedence = PREC_ASSIGN);
+    ExpressionNode * parse_unary_expr();
+    ExpressionNode * parse_primary();
+    LiteralNode * parse_literal();
+
+    DeclarationNode *parse_top_level();
+    // Parse the declarations from `begin` to `end`, false if they did not end exactly there.
+    bool parse_range(int_t begin, int_t end, std::vector<DeclarationNode *> &declarations);
 
     bool is_literal(TokenType type);
+    // 'true', 'false' and 'null' are keywords parsed as literals.
+    bool is_keyword_literal(Keyword keyword);
 };
 
 #endif // PARSER_HH
\ No newline at end of file
@@ -2,25 +2,120 @@
 #define PRINT_HH
 
 #include "token.hh"
+#include "source.hh"
+#include <array>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <unordered_set>
 
+/**
+ * @brief How diagnostics are written.
+ */
+enum class DiagnosticFormat
+{
+    TEXT,  ///< Colored messages followed by the source line, for people.
+    JSON,  ///< One JSON object per line and diagnostic.
+    SARIF, ///< The results of a SARIF 2.1.0 log, enclosed by a DiagnosticsWriter.
+};
+
+enum class Severity
+{
+    ERROR,
+    WARNING,
+    INFO,
+};
+
+/**
+ * @brief Reports the diagnostics of one compilation to a stream.
+ *
+ * Not thread safe, every thread compiling reports through one of its own, into
+ * a buffer of its own. A DiagnosticsWriter merges the buffers. Every diagnostic
+ * is written to the stream at once and the stream is never flushed, so
+ * reporting costs no system call per line.
+ */
 class PrintGlobalState
 {
 public:
     PrintGlobalState();
+    PrintGlobalState(const SourceManager &sources);
     void reset();
     bool hasEncounteredError() const;
+    void setErrorLimit(int_t limit);
+    bool errorLimitReached() const;
+    void setOutput(std::ostream &output);
+    void setFormat(DiagnosticFormat format);
+
+    /**
+     * @brief Number of diagnostics of a severity reported so far, including errors dropped beyond the limit.
+     */
+    int_t getCount(Severity severity) const;
+
     void error(const std::string &message) const;
-    void error(const std::string &message, int_t line, int_t col, const std::string &file);
+    void error(const std::string &message, int_t offset, FileID file);
     void warn(const std::string &message) const;
-    void warn(const std::string &message, int_t line, int_t col, const std::string &file);
+    void warn(const std::string &message, int_t offset, FileID file);
     void info(const std::string &message) const;
-    void info(const std::string &message, int_t line, int_t col, const std::string &file);
-    void printFile(int_t line, int_t col, const std::string &file) const;
+    void info(const std::string &message, int_t offset, FileID file);
+    void printFile(int_t offset, FileID file) const;
 
 private:
+    const SourceManager *sources;
+    std::ostream *output;                     ///< Stream diagnostics are written to, std::cerr by default.
+    DiagnosticFormat format;
     mutable bool erroneous;
     bool file_name_printed;
+    mutable std::array<int_t, 3> counts;      ///< Number of diagnostics reported so far, indexed by Severity.
+    int_t error_limit;                        ///< Errors after this many are dropped, 0 for no limit.
+    std::unordered_set<uint64_t> error_locations; ///< Locations an error was already reported at.
+
+    bool countError() const;
+    void report(Severity severity, const std::string &message, int_t offset, FileID file, bool located) const;
+    void appendExcerpt(std::string &text, int_t offset, FileID file) const;
+};
+
+/**
+ * @brief Writes the diagnostics buffered by the threads of a compilation to one stream.
+ *
+ * Thread safe. Buffers handed over with an index are written in the order of
+ * their indices, each once every buffer before it is written, so the output
+ * does not depend on which thread finishes first. For SARIF the writer
+ * encloses the diagnostics in the log of a single run, which is complete once
+ * the writer is finished.
+ */
+class DiagnosticsWriter
+{
+public:
+    DiagnosticsWriter(std::ostream &output, DiagnosticFormat format);
+    ~DiagnosticsWriter();
+    DiagnosticsWriter(const DiagnosticsWriter &) = delete;
+    DiagnosticsWriter &operator=(const DiagnosticsWriter &) = delete;
+
+    /**
+     * @brief Write diagnostics belonging to no buffer in order, right away.
+     */
+    void write(const std::string &diagnostics);
+
+    /**
+     * @brief Hand over the buffer of the index, indices start at 0.
+     */
+    void write(size_t index, std::string diagnostics);
+
+    /**
+     * @brief Close the SARIF log and flush the stream, nothing is written after.
+     */
+    void finish();
+
+private:
+    std::mutex mutex;
+    std::ostream &output;
+    DiagnosticFormat format;
+    std::map<size_t, std::string> pending; ///< Buffers waiting for one with a lower index.
+    size_t next;                           ///< Index of the next buffer to write.
+    bool empty;                            ///< Whether no SARIF result was written yet.
+    bool finished;
+
+    void append(const std::string &diagnostics);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,104 @@
+#ifndef SCAN_HH
+#define SCAN_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Character classes used by the lexer, a character may be part of several.
+ */
+enum CharClass : uint8_t
+{
+    CC_SPACE = 1 << 0,       ///< Whitespace including newlines.
+    CC_IDENT_START = 1 << 1, ///< May start an identifier.
+    CC_IDENT = 1 << 2,       ///< May continue an identifier.
+    CC_DIGIT = 1 << 3,       ///< May start a number.
+    CC_NUMBER = 1 << 4,      ///< May continue a number.
+    CC_SEPARATOR = 1 << 5,
+    CC_OPERATOR = 1 << 6,
+};
+
+constexpr std::array<uint8_t, 256> build_char_classes()
+{
+    std::array<uint8_t, 256> classes = {};
+    for (unsigned c = 0; c < 256; c++)
+    {
+        uint8_t cls = 0;
+        if (c == ' ' || (c >= '\t' && c <= '\r'))
+        {
+            cls |= CC_SPACE;
+        }
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_')
+        {
+            cls |= CC_IDENT_START | CC_IDENT;
+        }
+        if (c >= '0' && c <= '9')
+        {
+            cls |= CC_IDENT | CC_DIGIT | CC_NUMBER;
+        }
+        if (c == '.' || c == 'x' || c == 'e' || c == 'E' || c == '+' || c == '-')
+        {
+            cls |= CC_NUMBER;
+        }
+        for (char s : {';', ',', ':', '{', '}', '[', ']', '(', ')'})
+        {
+            if (c == static_cast<unsigned char>(s))
+            {
+                cls |= CC_SEPARATOR;
+            }
+        }
+        for (char o : {'>', '<', '=', '!', '^', '|', '&', '+', '-', '*', '/', '%', '~'})
+        {
+            if (c == static_cast<unsigned char>(o))
+            {
+                cls |= CC_OPERATOR;
+            }
+        }
+        classes[c] = cls;
+    }
+    return classes;
+}
+
+constexpr std::array<uint8_t, 256> CHAR_CLASSES = build_char_classes();
+
+inline bool has_char_class(char c, uint8_t cls)
+{
+    return CHAR_CLASSES[static_cast<unsigned char>(c)] & cls;
+}
+
+/**
+ * Kernels scanning runs of characters for the lexer. Every kernel reads at most
+ * up to `end` and returns `end` if the run does not stop before it.
+ */
+struct ScanKernels
+{
+    const char *name;
+
+    /// Skip whitespace, counting the newlines skipped.
+    const char *(*skip_whitespace)(const char *p, const char *end, size_t &newlines);
+
+    /// Skip characters which may continue an identifier.
+    const char *(*scan_identifier)(const char *p, const char *end);
+
+    /// Skip characters which may continue a number.
+    const char *(*scan_number)(const char *p, const char *end);
+
+    /// Find the next '"' or '\\'.
+    const char *(*find_string_end)(const char *p, const char *end);
+
+    /// Find the '*' of the next "*\/", counting the newlines skipped.
+    const char *(*find_comment_end)(const char *p, const char *end, size_t &newlines);
+};
+
+/**
+ * @brief Get the fastest kernels supported by the CPU, selected once at runtime.
+ */
+const ScanKernels &get_scan_kernels();
+
+/**
+ * @brief Get the portable kernels working one character at a time.
+ */
+const ScanKernels &get_scalar_scan_kernels();
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef SCAN_KERNELS_HH
+#define SCAN_KERNELS_HH
+
+#include "scan.hh"
+
+/*
+ * Generic implementation of the ScanKernels, included by every file which
+ * implements them for one instruction set. An `Ops` type provides the vector
+ * operations, each of its class tests returns a mask with `BITS` bits set per
+ * matching byte.
+ *
+ * Everything here has internal linkage, so code compiled for one instruction
+ * set can never be picked by the linker for another one.
+ */
+namespace
+{
+    inline const char *scalar_skip_whitespace(const char *p, const char *end, size_t &newlines)
+    {
+        for (; p < end && has_char_class(*p, CC_SPACE); p++)
+        {
+            newlines += *p == '\n';
+        }
+        return p;
+    }
+
+    template <uint8_t Class>
+    const char *scalar_skip(const char *p, const char *end)
+    {
+        while (p < end && has_char_class(*p, Class))
+        {
+            p++;
+        }
+        return p;
+    }
+
+    inline const char *scalar_find_string_end(const char *p, const char *end)
+    {
+        while (p < end && *p != '"' && *p != '\\')
+        {
+            p++;
+        }
+        return p;
+    }
+
+    inline const char *scalar_find_comment_end(const char *p, const char *end, size_t &newlines)
+    {
+        for (; p < end; p++)
+        {
+            if (*p == '*' && p + 1 < end && p[1] == '/')
+            {
+                return p;
+            }
+            newlines += *p == '\n';
+        }
+        return end;
+    }
+
+    template <typename Ops>
+    unsigned first_byte(uint64_t mask)
+    {
+        return __builtin_ctzll(mask) / Ops::BITS;
+    }
+
+    template <typename Ops>
+    size_t count_bytes(uint64_t mask)
+    {
+        return __builtin_popcountll(mask) / Ops::BITS;
+    }
+
+    // Mask of the bits belonging to the bytes before `byte`.
+    template <typename Ops>
+    uint64_t bytes_before(unsigned byte)
+    {
+        return byte * Ops::BITS == 64 ? ~0ULL : (1ULL << (byte * Ops::BITS)) - 1;
+    }
+
+    template <typename Ops>
+    const char *vector_skip_whitespace(const char *p, const char *end, size_t &newlines)
+    {
+        for (; p + Ops::WIDTH <= end; p += Ops::WIDTH)
+        {
+            auto chunk = Ops::load(p);
+            uint64_t stop = ~Ops::whitespace(chunk) & Ops::ALL;
+            uint64_t lines = Ops::equal(chunk, '\n');
+            if (stop)
+            {
+                unsigned byte = first_byte<Ops>(stop);
+                newlines += count_bytes<Ops>(lines & bytes_before<Ops>(byte));
+                return p + byte;
+            }
+            newlines += count_bytes<Ops>(lines);
+        }
+        return scalar_skip_whitespace(p, end, newlines);
+    }
+
+    template <typename Ops, uint64_t (*InClass)(typename Ops::Vector), uint8_t Class>
+    const char *vector_skip(const char *p, const char *end)
+    {
+        for (; p + Ops::WIDTH <= end; p += Ops::WIDTH)
+        {
+            uint64_t stop = ~InClass(Ops::load(p)) & Ops::ALL;
+            if (stop)
+            {
+                return p + first_byte<Ops>(stop);
+            }
+        }
+        return scalar_skip<Class>(p, end);
+    }
+
+    template <typename Ops>
+    const char *vector_find_string_end(const char *p, const char *end)
+    {
+        for (; p + Ops::WIDTH <= end; p += Ops::WIDTH)
+        {
+            auto chunk = Ops::load(p);
+            uint64_t found = Ops::equal(chunk, '"') | Ops::equal(chunk, '\\');
+            if (found)
+            {
+                return p + first_byte<Ops>(found);
+            }
+        }
+        return scalar_find_string_end(p, end);
+    }
+
+    template <typename Ops>
+    const char *vector_find_comment_end(const char *p, const char *end, size_t &newlines)
+    {
+        for (; p + Ops::WIDTH <= end; p += Ops::WIDTH)
+        {
+            auto chunk = Ops::load(p);
+            uint64_t stars = Ops::equal(chunk, '*');
+            while (stars)
+            {
+                unsigned byte = first_byte<Ops>(stars);
+                if (p + byte + 1 < end && p[byte + 1] == '/')
+                {
+                    newlines += count_bytes<Ops>(Ops::equal(chunk, '\n') & bytes_before<Ops>(byte));
+                    return p + byte;
+                }
+                stars &= ~bytes_before<Ops>(byte + 1);
+            }
+            newlines += count_bytes<Ops>(Ops::equal(chunk, '\n'));
+        }
+        return scalar_find_comment_end(p, end, newlines);
+    }
+
+    template <typename Ops>
+    constexpr ScanKernels make_vector_kernels(const char *name)
+    {
+        return {
+            name,
+            vector_skip_whitespace<Ops>,
+            vector_skip<Ops, Ops::identifier, CC_IDENT>,
+            vector_skip<Ops, Ops::number, CC_NUMBER>,
+            vector_find_string_end<Ops>,
+            vector_find_comment_end<Ops>,
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef SEMA_HH
+#define SEMA_HH
+
+#include <string>
+#include "ast_visitor.hh"
+#include "interner.hh"
+#include "print.hh"
+#include "table.hh"
+#include "types.hh"
+
+/**
+ * @brief Resolves the names of a program and gives every expression its type.
+ *
+ * Top-level declarations are declared first, so they may be used before they
+ * are declared, then every function is checked in one walk over its body.
+ * Names are resolved through a SymbolTable and types are canonical types of a
+ * TypeContext, so both take constant time and checking is linear in the size
+ * of the program. Expressions are typed like code generation types them: a
+ * variable has its declared type, and a literal takes the type its context
+ * expects, defaulting to i32 and f64. An expression with an error has the
+ * error type, which every check accepts, so an error is reported only once.
+ * Every type node is resolved once, code generation reuses its type.
+ */
+class SemanticAnalyzer : public ASTVisitor<SemanticAnalyzer>
+{
+public:
+    SemanticAnalyzer(TypeContext &types, const StringInterner &names, PrintGlobalState &print);
+
+    /**
+     * @brief Check a program, setting the type of each of its expressions.
+     * @param file File the program was parsed from, errors are reported at the offsets of its nodes.
+     * @return Whether no error was reported.
+     */
+    bool analyze(ProgramNode *program, FileID file);
+
+    void visitFunctionDeclarationNode(FunctionDeclarationNode *function);
+    void visitBlockNode(BlockNode *block);
+    void visitIfStatementNode(IfStatementNode *statement);
+    void visitLoopStatementNode(LoopStatementNode *statement);
+    void visitVarDeclarationNode(VarDeclarationNode *declaration);
+    void visitExpressionStatementNode(ExpressionStatementNode *statement);
+    void visitMatchStatementNode(MatchStatementNode *statement);
+    void visitBreakStatementNode(BreakStatementNode *statement);
+    void visitContinueStatementNode(ContinueStatementNode *statement);
+    void visitRetStatementNode(RetStatementNode *statement);
+
+private:
+    TypeContext &types;
+    const StringInterner &names;
+    PrintGlobalState &print;
+    SymbolTable table;
+    FileID file;
+    int_t level;              ///< Depth of the innermost scope, 1 for the top-level declarations.
+    int_t loops;              ///< Loops around the statement being checked.
+    const Type *return_type;  ///< Of the function being checked.
+    bool failed;
+
+    void error(const std::string &message, const ASTNode *node);
+    std::string getName(const Type *type) const;
+    void enterScope();
+    void exitScope();
+    void declare(NameID name, SymbolType kind, const Type *type, const ASTNode *node);
+    const Type *resolveType(TypeNode *type);
+    void declareTypes(llvm::ArrayRef<DeclarationNode *> declarations);
+
+    const Type *checkExpression(ExpressionNode *expression, const Type *expected);
+    const Type *checkLiteral(const LiteralNode *literal, const Type *expected);
+    const Type *checkIdentifier(const IdentifierNode *identifier);
+    const Type *checkUnary(UnaryExprNode *expression, const Type *expected);
+    const Type *checkBinary(BinaryExprNode *expression, const Type *expected);
+    const Type *checkOperation(Operator op, const Type *left, const Type *right, const ExpressionNode *expression);
+    const Type *checkVariable(ExpressionNode *expression, Operator op);
+    void checkCondition(ExpressionNode *condition);
+    void checkConversion(const Type *from, const Type *to, const ASTNode *node);
+};
+
+#endif
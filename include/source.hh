@@ -0,0 +1,121 @@
+#ifndef SOURCE_HH
+#define SOURCE_HH
+
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "token.hh"
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+typedef unsigned int FileID;
+
+/**
+ * @brief Replacement of a range of a file by new text, as sent by an editor.
+ */
+struct TextEdit
+{
+    int_t offset; ///< Offset of the first replaced character.
+    int_t length; ///< Number of replaced characters.
+    std::string text;
+};
+
+/**
+ * @brief Owns the content of every source file of a compilation.
+ *
+ * Files are memory mapped once and handed out as views, every other stage
+ * refers to a file through its FileID instead of copying its content.
+ */
+class SourceManager
+{
+public:
+    SourceManager() = default;
+    SourceManager(const SourceManager &) = delete;
+    SourceManager &operator=(const SourceManager &) = delete;
+
+    /**
+     * @brief Map a file from disk.
+     * @param file_name Path of the file to load.
+     * @return ID of the loaded file, or nothing if it could not be read.
+     */
+    std::optional<FileID> loadFile(const std::string &file_name);
+
+    /**
+     * @brief Register an in-memory buffer as a source file.
+     * @param content Content of the file, it is copied once.
+     * @param file_name Name used for diagnostics.
+     * @return ID of the new file.
+     */
+    FileID addBuffer(llvm::StringRef content, const std::string &file_name);
+
+    /**
+     * @brief Apply an edit to a file, updating its line table in place.
+     * @param id ID of the file.
+     * @param edit Edit to apply, its range must lie within the file.
+     *
+     * Views of the previous content are invalidated.
+     */
+    void applyEdit(FileID id, const TextEdit &edit);
+
+    /**
+     * @brief Get the content of a file.
+     * @param id ID of the file.
+     * @return View of the content, which is guaranteed to be null terminated.
+     */
+    llvm::StringRef getBuffer(FileID id) const;
+
+    /**
+     * @brief Get the name of a file.
+     * @param id ID of the file.
+     * @return Name the file was loaded with.
+     */
+    llvm::StringRef getFileName(FileID id) const;
+
+    /**
+     * @brief Get the number of lines in a file.
+     * @param id ID of the file.
+     * @return Number of lines.
+     */
+    int_t getLineCount(FileID id) const;
+
+    /**
+     * @brief Get the offset of the first character of a line.
+     * @param id ID of the file.
+     * @param line Line number, starting at 1.
+     * @return Offset into the buffer of the file.
+     */
+    int_t getLineOffset(FileID id, int_t line) const;
+
+    /**
+     * @brief Find the line and column of an offset.
+     * @param id ID of the file.
+     * @param offset Offset into the buffer of the file.
+     * @return Line and column, both starting at 1.
+     */
+    std::pair<int_t, int_t> getLineAndColumn(FileID id, int_t offset) const;
+
+    /**
+     * @brief Get the content of a line without its line terminator.
+     * @param id ID of the file.
+     * @param line Line number, starting at 1.
+     * @return View of the line, empty if the line does not exist.
+     */
+    llvm::StringRef getLine(FileID id, int_t line) const;
+
+private:
+    struct SourceFile
+    {
+        std::string name;
+        std::unique_ptr<llvm::MemoryBuffer> buffer;
+        std::vector<int_t> line_offsets; ///< Offset of the start of every line.
+    };
+
+    std::deque<SourceFile> files;
+
+    FileID addFile(std::unique_ptr<llvm::MemoryBuffer> buffer, const std::string &file_name);
+};
+
+#endif
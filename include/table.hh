@@ -3,37 +3,81 @@
 
 #include <string>
 #include <vector>
-#include <unordered_map>
 #include "token.hh"
 #include "print.hh"
 #include "parser.hh"
+#include "interner.hh"
+#include "types.hh"
 
-// Reuse definitions
-typedef VarType SymbolType;
+// What a name refers to, the type of its values is in Symbol::value_type.
+enum class SymbolType : uint8_t
+{
+    ERR,
+    VARIABLE,
+    FUNCTION,
+    STRUCT,
+    ENUM,
+};
 
 struct Symbol
 {
-    std::string name;
+    NameID name;
     SymbolType type;
     int_t level;
     int_t space;
+    const Type *value_type = nullptr; ///< Type of a variable, or the type a struct or enum declares.
 };
 
+/**
+ * Scoped symbol table in a single open addressed hash table.
+ *
+ * Every name has one slot referring to its innermost declaration, each
+ * declaration links to the one it shadows. Declarations are appended to a log
+ * in order, so exiting a scope pops its declarations off the log and restores
+ * the shadowed ones. Lookups take one probe sequence regardless of how deeply
+ * scopes are nested, entering and exiting a scope cost O(1) plus the symbols
+ * declared in it.
+ */
 class SymbolTable
 {
 public:
-    SymbolTable(PrintGlobalState &state);
-    void insert(const std::string &name, const Symbol &symbol);
-    bool lookup(const std::string &name, Symbol &symbol) const;
-    Symbol get(const std::string &name) const;
-    SymbolType getType(const std::string &name) const;
-    bool check(const std::string &name) const;
+    SymbolTable(PrintGlobalState &state, const StringInterner &names);
+    void insert(NameID name, const Symbol &symbol);
+    bool lookup(NameID name, Symbol &symbol) const;
+    Symbol get(NameID name) const;
+    SymbolType getType(NameID name) const;
+    bool check(NameID name) const;
     void enterScope();
     void exitScope();
 
 private:
-    std::vector<std::unordered_map<std::string, Symbol>> scopes;
-    PrintGlobalState state;
+    static constexpr uint32_t NONE = ~0u;
+
+    struct Slot
+    {
+        NameID name;    ///< 0 if the slot is empty.
+        uint32_t entry; ///< Innermost declaration of the name, NONE if it is out of scope.
+    };
+
+    struct Entry
+    {
+        Symbol symbol;
+        NameID name;       ///< Name the symbol was declared as.
+        uint32_t shadowed; ///< Declaration of the same name in an outer scope, or NONE.
+        uint32_t depth;    ///< Depth of the scope declaring it.
+    };
+
+    std::vector<Slot> slots;            ///< Power of two sized, linear probing.
+    unsigned hash_shift;                ///< 64 minus the log2 of the number of slots.
+    size_t used_slots;
+    std::vector<Entry> entries;         ///< Declarations of all open scopes, innermost last.
+    std::vector<uint32_t> scope_starts; ///< Index of the first entry of every open scope.
+    PrintGlobalState &state;
+    const StringInterner &names; ///< Resolves names for diagnostics.
+
+    Slot &findSlot(NameID name);
+    const Entry *find(NameID name) const;
+    void grow();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,80 @@
+#ifndef THREADPOOL_HH
+#define THREADPOOL_HH
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of worker threads running jobs, balanced by work stealing.
+ *
+ * Every worker has its own queue. Jobs submitted by a job go to the queue of
+ * its worker, which runs its newest job first. Idle workers steal the oldest
+ * job of another worker, so uneven jobs such as files of very different sizes
+ * still keep every worker busy.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief Start the workers.
+     * @param threads Number of workers, 0 for one per hardware thread.
+     */
+    explicit ThreadPool(unsigned threads = 0);
+
+    /**
+     * @brief Wait for every job to finish and stop the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief Queue a job, it may run on any worker.
+     */
+    void submit(std::function<void()> job);
+
+    /**
+     * @brief Block until every submitted job finished, must not be called from a job.
+     */
+    void wait();
+
+    /**
+     * @brief Run a job for every index from 0 to count, and return once all of them finished.
+     *
+     * May be called from a job, unlike wait(). The calling thread runs queued
+     * jobs while it waits, so workers waiting this way never idle the pool.
+     */
+    void runAll(size_t count, const std::function<void(size_t)> &job);
+
+    unsigned size() const;
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::mutex mutex;                ///< Guards the counters below for the condition variables.
+    std::condition_variable wake;    ///< Signaled when a job was queued or the pool stops.
+    std::condition_variable idle;    ///< Signaled when the last pending job finished.
+    std::atomic<size_t> queued;      ///< Jobs waiting in a queue.
+    size_t pending;                  ///< Jobs submitted and not finished yet.
+    unsigned next;                   ///< Worker receiving the next job submitted from outside.
+    bool stopping;
+
+    bool take(unsigned self, std::function<void()> &job);
+    void execute(std::function<void()> &job);
+    void run(unsigned self);
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef TIMING_HH
+#define TIMING_HH
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <llvm/ADT/StringRef.h>
+
+/**
+ * @brief Collects where the time of a compilation goes, for -time-report.
+ *
+ * Every phase of every file is timed separately and added to the totals of
+ * its phase. Phases may be timed from several threads at once. CPU time is
+ * the time of the timing thread, so it stays correct when files are compiled
+ * in parallel. Peak RSS is process wide, with several jobs its growth is
+ * attributed to whichever phase happened to raise it.
+ */
+class TimeReport
+{
+public:
+    enum Phase
+    {
+        READ,
+        LEX,
+        LEX_PARSE, ///< Lexing and parsing at once, the parser pulling its tokens from the lexer.
+        PARSE,
+        CACHE,
+        ANALYSIS,
+        CODEGEN,
+        OPTIMIZE,
+        EMIT,
+        RUN,
+        PHASE_COUNT
+    };
+
+    /**
+     * @brief Times a phase from its construction to its destruction, does nothing without a report.
+     */
+    class Scope
+    {
+    public:
+        Scope(TimeReport *report, Phase phase, llvm::StringRef detail);
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        TimeReport *report;
+        Phase phase;
+        std::string detail;
+        std::chrono::steady_clock::time_point wall_start;
+        std::chrono::nanoseconds cpu_start;
+        int64_t rss_start;
+    };
+
+    TimeReport();
+
+    /**
+     * @brief Count the items a phase processed, tokens for LEX and AST nodes for PARSE, CACHE and ANALYSIS.
+     */
+    void count(Phase phase, uint64_t items);
+
+    /**
+     * @brief Count the tokens and AST nodes of LEX_PARSE.
+     *
+     * The driver lexes while parsing, so its tokens and nodes share the time
+     * of LEX_PARSE and both rates are reported for it. Only large files
+     * parsed on several threads are lexed up front and timed as LEX and PARSE.
+     */
+    void count(Phase phase, uint64_t tokens, uint64_t nodes);
+
+    /**
+     * @brief Print the totals of every phase which ran as a table.
+     */
+    void print(std::ostream &out) const;
+
+    /**
+     * @brief Write every timed phase as Chrome trace events, for chrome://tracing or Perfetto.
+     * @return False with error set if the file could not be written.
+     */
+    bool writeTrace(const std::string &path, std::string &error) const;
+
+private:
+    struct Totals
+    {
+        std::chrono::nanoseconds wall{0};
+        std::chrono::nanoseconds cpu{0};
+        int64_t rss = 0; ///< Growth of the peak RSS in KB.
+        uint64_t tokens = 0;
+        uint64_t nodes = 0;
+        unsigned samples = 0;
+    };
+
+    struct Event
+    {
+        Phase phase;
+        std::string detail;
+        uint64_t thread;
+        std::chrono::nanoseconds start;
+        std::chrono::nanoseconds duration;
+    };
+
+    mutable std::mutex mutex;
+    std::chrono::steady_clock::time_point start;
+    std::array<Totals, PHASE_COUNT> totals;
+    std::vector<Event> events;
+};
+
+#endif
@@ -1,9 +1,13 @@
 #ifndef TOKEN_HH
 #define TOKEN_HH
 
+#include <cstdint>
+#include "operators.hh"
+
 typedef unsigned long long int_t;
+typedef uint32_t NameID; ///< ID of an interned name, see StringInterner.
 
-enum TokenType
+enum TokenType : uint8_t
 {
     TK_DATATYPE,
     TK_KEYWORD,
@@ -20,22 +24,126 @@ enum TokenType
     __EOF,
 };
 
-#include <string>
+/**
+ * Keywords in the order of KEYWORDS, see definitions.hh.
+ */
+enum Keyword : uint8_t
+{
+    KW_NONE,
+    KW_ASM,
+    KW_IF,
+    KW_ELIF,
+    KW_ELSE,
+    KW_LOOP,
+    KW_FN,
+    KW_RET,
+    KW_TRUE,
+    KW_FALSE,
+    KW_REF,
+    KW_DEREF,
+    KW_STRUCT,
+    KW_SYNC,
+    KW_ENUM,
+    KW_VOID,
+    KW_VOLATILE,
+    KW_NULL,
+    KW_IMPORT,
+    KW_BREAK,
+    KW_CONTINUE,
+    KW_MATCH,
+    KW_COUNT,
+};
+
+enum Separator : uint8_t
+{
+    SEP_NONE,
+    SEP_SEMICOLON,
+    SEP_COMMA,
+    SEP_COLON,
+    SEP_LBRACE,
+    SEP_RBRACE,
+    SEP_LBRACKET,
+    SEP_RBRACKET,
+    SEP_LPAREN,
+    SEP_RPAREN,
+};
+
+constexpr Separator classify_separator(char c)
+{
+    switch (c)
+    {
+    case ';':
+        return SEP_SEMICOLON;
+    case ',':
+        return SEP_COMMA;
+    case ':':
+        return SEP_COLON;
+    case '{':
+        return SEP_LBRACE;
+    case '}':
+        return SEP_RBRACE;
+    case '[':
+        return SEP_LBRACKET;
+    case ']':
+        return SEP_RBRACKET;
+    case '(':
+        return SEP_LPAREN;
+    case ')':
+        return SEP_RPAREN;
+    default:
+        return SEP_NONE;
+    }
+}
+
+constexpr char separator_spelling(Separator separator)
+{
+    return ";,:{}[]()"[separator - SEP_SEMICOLON];
+}
+
+#include <string_view>
 
+/**
+ * The lexeme does not own its characters. It either points into the source
+ * buffer the token was lexed from, or into the lexer's literal table when an
+ * escape sequence had to be decoded. Tokens are therefore only valid as long as
+ * the Lexer that produced them.
+ *
+ * Identifiers also carry the ID their name was interned as, and keywords,
+ * separators and operators which one they are, so the parser never has to
+ * compare lexemes.
+ */
 struct Token
 {
     TokenType type;
+    uint8_t kind; ///< Keyword, Separator or Operator, depending on the type.
+    NameID name;
     int_t line;
     int_t col;
-    std::string lexeme;
-    Token(TokenType _type, int_t _line, int_t _col, const std::string &_lexeme)
-        : type(_type), line(_line), col(_col), lexeme(_lexeme) {}
-    Token(TokenType _type, int_t _line, int_t _col, const char &_lexeme)
-        : type(_type), line(_line), col(_col)
+    std::string_view lexeme;
+    Token(TokenType _type, int_t _line, int_t _col, std::string_view _lexeme, NameID _name = 0)
+        : type(_type), kind(0), name(_name), line(_line), col(_col), lexeme(_lexeme) {}
+    Token(Keyword _keyword, int_t _line, int_t _col, std::string_view _lexeme)
+        : Token(TK_KEYWORD, _line, _col, _lexeme) { kind = _keyword; }
+    Token(Separator _separator, int_t _line, int_t _col, std::string_view _lexeme)
+        : Token(TK_SEPARATOR, _line, _col, _lexeme) { kind = _separator; }
+    Token(Operator _op, int_t _line, int_t _col, std::string_view _lexeme)
+        : Token(TK_OPERATOR, _line, _col, _lexeme) { kind = static_cast<uint8_t>(_op); }
+    Token() {}
+
+    Keyword keyword() const
     {
-        lexeme.push_back(_lexeme);
+        return type == TK_KEYWORD ? static_cast<Keyword>(kind) : KW_NONE;
+    }
+
+    Separator separator() const
+    {
+        return type == TK_SEPARATOR ? static_cast<Separator>(kind) : SEP_NONE;
+    }
+
+    Operator op() const
+    {
+        return type == TK_OPERATOR ? static_cast<Operator>(kind) : Operator::NONE;
     }
-    Token() {}
 };
 
 #endif
\ No newline at end of file
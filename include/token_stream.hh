@@ -0,0 +1,95 @@
+#ifndef TOKEN_STREAM_HH
+#define TOKEN_STREAM_HH
+
+#include <array>
+#include <vector>
+#include "lexer.hh"
+#include "token.hh"
+
+/**
+ * @brief Tokens the parser consumes, either lexed up front or pulled from a Lexer as needed.
+ *
+ * Pulled tokens are kept in a ring buffer, so the memory for tokens stays the
+ * same however large the file is, and lexing and parsing interleave. A pulled
+ * token is overwritten once RING_SIZE - 1 tokens past it have been looked at.
+ * The parser looks at most one token ahead and does not hold on to a token
+ * past the next advance, which stays well within that.
+ */
+class TokenStream
+{
+public:
+    /**
+     * @brief Stream tokens which were already lexed, the vector must end with the end of file token.
+     */
+    explicit TokenStream(const std::vector<Token> &tokens);
+
+    /**
+     * @brief Stream tokens pulled from the lexer, which must outlive the stream.
+     */
+    explicit TokenStream(Lexer &lexer);
+
+    TokenStream(const TokenStream &) = delete;
+    TokenStream &operator=(const TokenStream &) = delete;
+
+    /**
+     * @brief Get the token `ahead` tokens after the current one, the end of file token past the end.
+     */
+    const Token &peek(int_t ahead = 0)
+    {
+        int_t position = index + ahead;
+        if (lexer)
+        {
+            if (position >= pulled)
+            {
+                pull(position);
+            }
+            return ring[position & (RING_SIZE - 1)];
+        }
+        return position < tokens->size() ? (*tokens)[position] : eof;
+    }
+
+    void advance()
+    {
+        index++;
+    }
+
+    /**
+     * @brief Get the index of the current token.
+     */
+    int_t position() const
+    {
+        return index;
+    }
+
+    /**
+     * @brief Move to the token at an index, only possible for tokens lexed up front.
+     */
+    void seek(int_t position);
+
+    /**
+     * @brief Get the tokens lexed up front, nullptr when pulling from a lexer.
+     */
+    const std::vector<Token> *lexed() const
+    {
+        return tokens;
+    }
+
+    /**
+     * @brief Get the number of tokens, only those pulled so far when pulling from a lexer.
+     */
+    int_t size() const;
+
+private:
+    static constexpr int_t RING_SIZE = 8; ///< Power of two, so indices are wrapped by masking.
+
+    const std::vector<Token> *tokens; ///< Tokens lexed up front, or nullptr when pulling.
+    Lexer *lexer;                     ///< Lexer to pull from, or nullptr.
+    std::array<Token, RING_SIZE> ring;
+    int_t index;                      ///< Index of the current token.
+    int_t pulled;                     ///< Number of tokens pulled from the lexer so far.
+    Token eof;
+
+    void pull(int_t position);
+};
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef TYPES_HH
+#define TYPES_HH
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include "definitions.hh"
+#include "interner.hh"
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Allocator.h>
+#include <llvm/Support/Casting.h>
+
+/**
+ * @brief Type of a value, as resolved by semantic analysis.
+ *
+ * Types are created by a TypeContext only, which creates every type once, so
+ * two types are equal exactly when their pointers are. Like AST nodes, types
+ * carry their kind for llvm::isa, llvm::cast and llvm::dyn_cast instead of
+ * virtual functions.
+ */
+class Type
+{
+public:
+    enum Kind : uint8_t
+    {
+        TYPE_ERROR, ///< Type of an erroneous expression, accepted everywhere so one error is reported once.
+        TYPE_VOID,
+        TYPE_BOOL,
+        TYPE_CHAR,
+        TYPE_INTEGER,
+        TYPE_FLOAT,
+        TYPE_ENUM,
+        TYPE_STRUCT,
+        TYPE_ARRAY,
+
+        FIRST_PRIMITIVE = TYPE_ERROR,
+        LAST_PRIMITIVE = TYPE_FLOAT,
+    };
+
+    Kind getKind() const { return kind; }
+    bool isError() const { return kind == TYPE_ERROR; }
+    bool isVoid() const { return kind == TYPE_VOID; }
+    bool isFloat() const { return kind == TYPE_FLOAT; }
+
+    /**
+     * @brief Whether values of the type are whole numbers, enums are the index of their field.
+     */
+    bool isInteger() const { return (kind >= TYPE_BOOL && kind <= TYPE_INTEGER) || kind == TYPE_ENUM; }
+
+    /**
+     * @brief Whether values of the type are numbers, which operators compute with and convert into each other.
+     */
+    bool isScalar() const { return kind >= TYPE_BOOL && kind <= TYPE_ENUM; }
+
+protected:
+    explicit Type(Kind kind) : kind(kind) {}
+
+private:
+    const Kind kind;
+};
+
+/**
+ * @brief One of the data types, void, or the error type.
+ */
+class PrimitiveType : public Type
+{
+public:
+    PrimitiveType(Kind kind, llvm::StringRef name, unsigned bits, bool is_signed)
+        : Type(kind), name(name), bits(bits), is_signed(is_signed) {}
+
+    llvm::StringRef name;
+    unsigned bits; ///< Width of a value, 0 for void and the error type.
+    bool is_signed;
+
+    static bool classof(const Type *type)
+    {
+        return type->getKind() >= FIRST_PRIMITIVE && type->getKind() <= LAST_PRIMITIVE;
+    }
+};
+
+class EnumType : public Type
+{
+public:
+    EnumType(NameID name, llvm::ArrayRef<NameID> fields)
+        : Type(TYPE_ENUM), name(name), fields(fields) {}
+
+    NameID name;
+    llvm::ArrayRef<NameID> fields;
+
+    static bool classof(const Type *type) { return type->getKind() == TYPE_ENUM; }
+};
+
+class StructType : public Type
+{
+public:
+    struct Field
+    {
+        NameID name;
+        const Type *type;
+    };
+
+    explicit StructType(NameID name) : Type(TYPE_STRUCT), name(name) {}
+
+    NameID name;
+    llvm::ArrayRef<Field> fields; ///< Set once every struct is declared, so fields may be of any struct.
+
+    static bool classof(const Type *type) { return type->getKind() == TYPE_STRUCT; }
+};
+
+class ArrayType : public Type
+{
+public:
+    ArrayType(const Type *element, uint64_t size)
+        : Type(TYPE_ARRAY), element(element), size(size) {}
+
+    const Type *element;
+    uint64_t size;
+
+    static bool classof(const Type *type) { return type->getKind() == TYPE_ARRAY; }
+};
+
+/**
+ * @brief Creates and owns the types of a translation unit.
+ *
+ * Primitive types exist from the start, array types are uniqued by their
+ * element type and size. Structs and enums are nominal, every declaration
+ * creates a distinct type. Types are bump allocated and released with the
+ * context.
+ */
+class TypeContext
+{
+public:
+    TypeContext();
+    TypeContext(const TypeContext &) = delete;
+    TypeContext &operator=(const TypeContext &) = delete;
+
+    const PrimitiveType *getError() const { return &error; }
+    const PrimitiveType *getVoid() const { return &void_type; }
+
+    /**
+     * @brief Get the type of one of DATA_TYPES by its name.
+     * @return The type, or nullptr if the name is not a data type.
+     */
+    const PrimitiveType *getPrimitive(llvm::StringRef name) const;
+
+    /**
+     * @brief Get the integer type of a width, bool for a width of 1.
+     * @return The type, or nullptr if no data type is that wide.
+     */
+    const PrimitiveType *getInteger(unsigned bits, bool is_signed) const;
+
+    /**
+     * @brief Get the type binary arithmetic converts two scalar operands to, as code generation computes it.
+     *
+     * Enums compute as i32 and integers become floats. Of two integers or two
+     * floats the wider one is taken, the left one if they are equally wide, and
+     * an integer result is unsigned when either operand is.
+     */
+    const PrimitiveType *getArithmeticType(const Type *left, const Type *right) const;
+
+    const ArrayType *getArray(const Type *element, uint64_t size);
+    EnumType *createEnum(NameID name, llvm::ArrayRef<NameID> fields);
+    StructType *createStruct(NameID name);
+    void setFields(StructType *structure, llvm::ArrayRef<StructType::Field> fields);
+
+    /**
+     * @brief Spell a type like it is written in the source, for diagnostics.
+     */
+    static std::string getName(const Type *type, const StringInterner &names);
+
+private:
+    llvm::BumpPtrAllocator allocator;
+    PrimitiveType error;
+    PrimitiveType void_type;
+    std::array<PrimitiveType *, DATA_TYPES.size()> primitives; ///< In the order of DATA_TYPES.
+    llvm::DenseMap<std::pair<const Type *, uint64_t>, const ArrayType *> arrays;
+
+    template <typename T, typename... Args>
+    T *create(Args &&...args)
+    {
+        return new (allocator.Allocate<T>()) T(std::forward<Args>(args)...);
+    }
+};
+
+#endif
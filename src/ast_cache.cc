@@ -0,0 +1,733 @@
+#include <ast_cache.hh>
+#include <version.hh>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+
+// Changed whenever the encoding of the tree changes, so older files are ignored.
+static constexpr llvm::StringLiteral MAGIC = "ZXAST\x04";
+
+namespace
+{
+    // Every node is written as a tag, then its offset in the source and its
+    // fields in declaration order. Children of a single known class go without
+    // a tag, those which may be missing are preceded by a flag.
+    enum Tag : uint8_t
+    {
+        TAG_NULL,
+        TAG_FUNCTION,
+        TAG_ENUM,
+        TAG_STRUCT,
+        TAG_BLOCK,
+        TAG_IF,
+        TAG_LOOP,
+        TAG_VAR,
+        TAG_EXPRESSION_STATEMENT,
+        TAG_MATCH,
+        TAG_BREAK,
+        TAG_CONTINUE,
+        TAG_RET,
+        TAG_BINARY,
+        TAG_UNARY,
+        TAG_PRIMARY,
+        TAG_LITERAL,
+        TAG_IDENTIFIER,
+    };
+
+    class Writer
+    {
+    public:
+        explicit Writer(const StringInterner &names) : names(names) {}
+
+        std::string write(llvm::StringRef source, const ProgramNode *program)
+        {
+            number(program->declarations.size());
+            for (const DeclarationNode *declaration : program->declarations)
+            {
+                this->declaration(declaration);
+            }
+
+            // The names are only known once the nodes are written, but are read first.
+            std::string tree = std::move(out);
+            out.clear();
+            out.append(MAGIC.data(), MAGIC.size());
+            string(_VER_NUM);
+            number(llvm::xxHash64(source));
+            number(source.size());
+            number(order.size());
+            for (NameID id : order)
+            {
+                string(names.get(id));
+            }
+            number(type_order.size());
+            for (llvm::StringRef type : type_order)
+            {
+                string(type);
+            }
+            out += tree;
+            return std::move(out);
+        }
+
+    private:
+        const StringInterner &names;
+        std::string out;
+        llvm::DenseMap<NameID, uint64_t> indices; ///< Index in the file of every name written.
+        std::vector<NameID> order;                ///< Names in the order of their indices.
+        llvm::StringMap<uint64_t> type_indices;   ///< Types are few and repeated, so they are numbered like names.
+        std::vector<llvm::StringRef> type_order;
+
+        void number(uint64_t value)
+        {
+            do
+            {
+                uint8_t byte = value & 0x7f;
+                value >>= 7;
+                out.push_back(static_cast<char>(value ? byte | 0x80 : byte));
+            } while (value);
+        }
+
+        void string(llvm::StringRef str)
+        {
+            number(str.size());
+            out.append(str.data(), str.size());
+        }
+
+        void name(NameID id)
+        {
+            auto inserted = indices.try_emplace(id, order.size());
+            if (inserted.second)
+            {
+                order.push_back(id);
+            }
+            number(inserted.first->second);
+        }
+
+        void tag(Tag tag)
+        {
+            out.push_back(static_cast<char>(tag));
+        }
+
+        bool present(const ASTNode *node)
+        {
+            out.push_back(node != nullptr);
+            return node != nullptr;
+        }
+
+        void offset(const ASTNode *node)
+        {
+            number(node->offset);
+        }
+
+        void declaration(const DeclarationNode *declaration)
+        {
+            switch (declaration->getKind())
+            {
+            case ASTNode::NODE_FUNCTION_DECLARATION:
+            {
+                auto *function = llvm::cast<FunctionDeclarationNode>(declaration);
+                tag(TAG_FUNCTION);
+                offset(function);
+                name(function->name);
+                parameters(function->parameters);
+                type(function->return_type);
+                block(function->body);
+                break;
+            }
+            case ASTNode::NODE_ENUM_DECLARATION:
+            {
+                auto *enumeration = llvm::cast<EnumDeclarationNode>(declaration);
+                tag(TAG_ENUM);
+                offset(enumeration);
+                name(enumeration->name);
+                number(enumeration->fields.size());
+                for (NameID field : enumeration->fields)
+                {
+                    name(field);
+                }
+                break;
+            }
+            default:
+            {
+                auto *structure = llvm::cast<StructDeclarationNode>(declaration);
+                tag(TAG_STRUCT);
+                offset(structure);
+                name(structure->name);
+                parameters(structure->fields);
+                break;
+            }
+            }
+        }
+
+        void parameters(llvm::ArrayRef<ParameterNode *> parameters)
+        {
+            number(parameters.size());
+            for (const ParameterNode *parameter : parameters)
+            {
+                offset(parameter);
+                type(parameter->type);
+                name(parameter->name);
+            }
+        }
+
+        void type(const TypeNode *type)
+        {
+            if (present(type))
+            {
+                offset(type);
+                auto inserted = type_indices.try_emplace(type->name, type_order.size());
+                if (inserted.second)
+                {
+                    type_order.push_back(inserted.first->getKey());
+                }
+                number(inserted.first->second);
+                name(type->reference);
+            }
+        }
+
+        void block(const BlockNode *block)
+        {
+            if (present(block))
+            {
+                offset(block);
+                number(block->statements.size());
+                for (const StatementNode *statement : block->statements)
+                {
+                    this->statement(statement);
+                }
+            }
+        }
+
+        void ifStatement(const IfStatementNode *statement)
+        {
+            offset(statement);
+            expression(statement->condition);
+            block(statement->then_block);
+            number(statement->elif_statements.size());
+            for (const IfStatementNode *elif : statement->elif_statements)
+            {
+                ifStatement(elif);
+            }
+            block(statement->else_block);
+        }
+
+        void statement(const StatementNode *statement)
+        {
+            switch (statement->getKind())
+            {
+            case ASTNode::NODE_BLOCK:
+                tag(TAG_BLOCK);
+                block(llvm::cast<BlockNode>(statement));
+                break;
+            case ASTNode::NODE_IF_STATEMENT:
+                tag(TAG_IF);
+                ifStatement(llvm::cast<IfStatementNode>(statement));
+                break;
+            case ASTNode::NODE_LOOP_STATEMENT:
+                tag(TAG_LOOP);
+                offset(statement);
+                block(llvm::cast<LoopStatementNode>(statement)->body);
+                break;
+            case ASTNode::NODE_VAR_DECLARATION:
+            {
+                auto *variable = llvm::cast<VarDeclarationNode>(statement);
+                tag(TAG_VAR);
+                offset(variable);
+                type(variable->type);
+                name(variable->name);
+                expression(variable->initializer);
+                break;
+            }
+            case ASTNode::NODE_EXPRESSION_STATEMENT:
+                tag(TAG_EXPRESSION_STATEMENT);
+                offset(statement);
+                expression(llvm::cast<ExpressionStatementNode>(statement)->expression);
+                break;
+            case ASTNode::NODE_MATCH_STATEMENT:
+            {
+                auto *match = llvm::cast<MatchStatementNode>(statement);
+                tag(TAG_MATCH);
+                offset(match);
+                expression(match->subject);
+                number(match->cases.size());
+                for (const CaseClauseNode *clause : match->cases)
+                {
+                    offset(clause);
+                    expression(clause->literal);
+                    block(clause->block);
+                }
+                block(match->default_block);
+                break;
+            }
+            case ASTNode::NODE_BREAK_STATEMENT:
+                tag(TAG_BREAK);
+                offset(statement);
+                break;
+            case ASTNode::NODE_CONTINUE_STATEMENT:
+                tag(TAG_CONTINUE);
+                offset(statement);
+                break;
+            default:
+                tag(TAG_RET);
+                offset(statement);
+                expression(llvm::cast<RetStatementNode>(statement)->value);
+                break;
+            }
+        }
+
+        void expression(const ExpressionNode *expression)
+        {
+            if (!expression)
+            {
+                tag(TAG_NULL);
+                return;
+            }
+            switch (expression->getKind())
+            {
+            case ASTNode::NODE_BINARY_EXPR:
+            {
+                auto *binary = llvm::cast<BinaryExprNode>(expression);
+                tag(TAG_BINARY);
+                offset(binary);
+                out.push_back(static_cast<char>(binary->op));
+                this->expression(binary->left);
+                this->expression(binary->right);
+                break;
+            }
+            case ASTNode::NODE_UNARY_EXPR:
+            {
+                auto *unary = llvm::cast<UnaryExprNode>(expression);
+                tag(TAG_UNARY);
+                offset(unary);
+                out.push_back(static_cast<char>(unary->op));
+                this->expression(unary->operand);
+                break;
+            }
+            case ASTNode::NODE_LITERAL:
+            {
+                auto *literal = llvm::cast<LiteralNode>(expression);
+                tag(TAG_LITERAL);
+                offset(literal);
+                out.push_back(static_cast<char>(literal->type));
+                string(literal->value);
+                break;
+            }
+            case ASTNode::NODE_IDENTIFIER:
+                tag(TAG_IDENTIFIER);
+                offset(expression);
+                name(llvm::cast<IdentifierNode>(expression)->name);
+                break;
+            default:
+                tag(TAG_PRIMARY);
+                offset(expression);
+                string(llvm::cast<PrimaryExprNode>(expression)->value);
+                break;
+            }
+        }
+    };
+
+    // Reads what Writer wrote, stopping at the first byte which does not fit.
+    class Reader
+    {
+    public:
+        Reader(llvm::StringRef data, ASTContext &context, StringInterner &names)
+            : position(data.begin()), end(data.end()), context(context), interner(names), failed(false) {}
+
+        ProgramNode *read(llvm::StringRef source)
+        {
+            if (llvm::StringRef(position, end - position).substr(0, MAGIC.size()) != MAGIC)
+            {
+                return nullptr;
+            }
+            position += MAGIC.size();
+            if (string() != _VER_NUM || number() != llvm::xxHash64(source) || number() != source.size())
+            {
+                return nullptr;
+            }
+            uint64_t name_count = count();
+            for (uint64_t i = 0; i < name_count && !failed; i++)
+            {
+                names.push_back(interner.intern(string()));
+            }
+            uint64_t type_count = count();
+            for (uint64_t i = 0; i < type_count && !failed; i++)
+            {
+                types.push_back(context.save(string()));
+            }
+
+            llvm::SmallVector<DeclarationNode *, 16> declarations(count());
+            for (DeclarationNode *&declaration : declarations)
+            {
+                declaration = this->declaration();
+            }
+            if (failed || position != end)
+            {
+                return nullptr;
+            }
+            return context.create<ProgramNode>(context.copy<DeclarationNode *>(declarations));
+        }
+
+    private:
+        const char *position;
+        const char *end;
+        ASTContext &context;
+        StringInterner &interner;
+        std::vector<NameID> names;           ///< ID of every name of the file, by its index in the file.
+        std::vector<llvm::StringRef> types; ///< Type names copied into the context, shared by their nodes.
+        bool failed;
+
+        uint8_t byte()
+        {
+            if (position == end)
+            {
+                failed = true;
+                return 0;
+            }
+            return static_cast<uint8_t>(*position++);
+        }
+
+        uint64_t number()
+        {
+            uint64_t value = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7)
+            {
+                uint8_t next = byte();
+                value |= static_cast<uint64_t>(next & 0x7f) << shift;
+                if (!(next & 0x80))
+                {
+                    return value;
+                }
+            }
+            failed = true;
+            return 0;
+        }
+
+        // Get the number of items of a list, which can not be more than the bytes left.
+        uint64_t count()
+        {
+            uint64_t value = number();
+            if (value > static_cast<uint64_t>(end - position))
+            {
+                failed = true;
+                return 0;
+            }
+            return value;
+        }
+
+        llvm::StringRef string()
+        {
+            uint64_t size = count();
+            llvm::StringRef str(position, size);
+            position += size;
+            return str;
+        }
+
+        NameID name()
+        {
+            uint64_t index = number();
+            if (index >= names.size())
+            {
+                failed = true;
+                return 0;
+            }
+            return names[index];
+        }
+
+        bool present()
+        {
+            return byte() != 0;
+        }
+
+        uint32_t offset()
+        {
+            uint64_t value = number();
+            if (value > UINT32_MAX)
+            {
+                failed = true;
+                return 0;
+            }
+            return static_cast<uint32_t>(value);
+        }
+
+        // Give a node the offset read before its fields.
+        template <typename T>
+        T *located(uint32_t offset, T *node)
+        {
+            node->offset = offset;
+            return node;
+        }
+
+        DeclarationNode *declaration()
+        {
+            switch (byte())
+            {
+            case TAG_FUNCTION:
+            {
+                uint32_t offset = this->offset();
+                NameID name = this->name();
+                auto parameters = this->parameters();
+                TypeNode *return_type = type();
+                return located(offset, context.create<FunctionDeclarationNode>(name, parameters, return_type, block()));
+            }
+            case TAG_ENUM:
+            {
+                uint32_t offset = this->offset();
+                NameID name = this->name();
+                llvm::SmallVector<NameID, 8> fields(count());
+                for (NameID &field : fields)
+                {
+                    field = this->name();
+                }
+                return located(offset, context.create<EnumDeclarationNode>(name, context.copy<NameID>(fields)));
+            }
+            case TAG_STRUCT:
+            {
+                uint32_t offset = this->offset();
+                NameID name = this->name();
+                return located(offset, context.create<StructDeclarationNode>(name, parameters()));
+            }
+            default:
+                failed = true;
+                return nullptr;
+            }
+        }
+
+        llvm::ArrayRef<ParameterNode *> parameters()
+        {
+            llvm::SmallVector<ParameterNode *, 8> parameters(count());
+            for (ParameterNode *&parameter : parameters)
+            {
+                uint32_t offset = this->offset();
+                TypeNode *type = this->type();
+                parameter = located(offset, context.create<ParameterNode>(type, name()));
+            }
+            return context.copy<ParameterNode *>(parameters);
+        }
+
+        TypeNode *type()
+        {
+            if (!present())
+            {
+                return nullptr;
+            }
+            uint32_t offset = this->offset();
+            uint64_t index = number();
+            if (index >= types.size())
+            {
+                failed = true;
+                return nullptr;
+            }
+            return located(offset, context.create<TypeNode>(types[index], name()));
+        }
+
+        BlockNode *block()
+        {
+            if (!present())
+            {
+                return nullptr;
+            }
+            uint32_t offset = this->offset();
+            llvm::SmallVector<StatementNode *, 16> statements(count());
+            for (StatementNode *&statement : statements)
+            {
+                statement = this->statement();
+            }
+            return located(offset, context.create<BlockNode>(context.copy<StatementNode *>(statements)));
+        }
+
+        IfStatementNode *ifStatement()
+        {
+            uint32_t offset = this->offset();
+            ExpressionNode *condition = expression();
+            BlockNode *then_block = block();
+            llvm::SmallVector<IfStatementNode *, 4> elifs(count());
+            for (IfStatementNode *&elif : elifs)
+            {
+                elif = ifStatement();
+            }
+            auto elif_statements = context.copy<IfStatementNode *>(elifs);
+            return located(offset, context.create<IfStatementNode>(condition, then_block, elif_statements, block()));
+        }
+
+        StatementNode *statement()
+        {
+            switch (byte())
+            {
+            case TAG_BLOCK:
+                return block();
+            case TAG_IF:
+                return ifStatement();
+            case TAG_LOOP:
+            {
+                uint32_t offset = this->offset();
+                return located(offset, context.create<LoopStatementNode>(block()));
+            }
+            case TAG_VAR:
+            {
+                uint32_t offset = this->offset();
+                TypeNode *type = this->type();
+                NameID name = this->name();
+                return located(offset, context.create<VarDeclarationNode>(type, name, expression()));
+            }
+            case TAG_EXPRESSION_STATEMENT:
+            {
+                uint32_t offset = this->offset();
+                return located(offset, context.create<ExpressionStatementNode>(expression()));
+            }
+            case TAG_MATCH:
+            {
+                uint32_t offset = this->offset();
+                ExpressionNode *subject = expression();
+                llvm::SmallVector<CaseClauseNode *, 8> cases(count());
+                for (CaseClauseNode *&clause : cases)
+                {
+                    uint32_t clause_offset = this->offset();
+                    ExpressionNode *literal = expression();
+                    if (literal && !llvm::isa<LiteralNode>(literal))
+                    {
+                        failed = true;
+                    }
+                    clause = located(clause_offset, context.create<CaseClauseNode>(static_cast<LiteralNode *>(literal), block()));
+                }
+                auto clauses = context.copy<CaseClauseNode *>(cases);
+                return located(offset, context.create<MatchStatementNode>(subject, clauses, block()));
+            }
+            case TAG_BREAK:
+                return located(offset(), context.create<BreakStatementNode>());
+            case TAG_CONTINUE:
+                return located(offset(), context.create<ContinueStatementNode>());
+            case TAG_RET:
+            {
+                uint32_t offset = this->offset();
+                return located(offset, context.create<RetStatementNode>(expression()));
+            }
+            default:
+                failed = true;
+                return nullptr;
+            }
+        }
+
+        Operator op()
+        {
+            uint8_t value = byte();
+            if (value >= static_cast<uint8_t>(Operator::COUNT))
+            {
+                failed = true;
+            }
+            return static_cast<Operator>(value);
+        }
+
+        ExpressionNode *expression()
+        {
+            switch (byte())
+            {
+            case TAG_NULL:
+                return nullptr;
+            case TAG_BINARY:
+            {
+                uint32_t offset = this->offset();
+                Operator op = this->op();
+                ExpressionNode *left = expression();
+                return located(offset, context.create<BinaryExprNode>(left, op, expression()));
+            }
+            case TAG_UNARY:
+            {
+                uint32_t offset = this->offset();
+                Operator op = this->op();
+                return located(offset, context.create<UnaryExprNode>(op, expression()));
+            }
+            case TAG_LITERAL:
+            {
+                uint32_t offset = this->offset();
+                auto type = static_cast<TokenType>(byte());
+                return located(offset, context.create<LiteralNode>(context.save(string()), type));
+            }
+            case TAG_IDENTIFIER:
+            {
+                uint32_t offset = this->offset();
+                return located(offset, context.create<IdentifierNode>(name()));
+            }
+            case TAG_PRIMARY:
+            {
+                uint32_t offset = this->offset();
+                return located(offset, context.create<PrimaryExprNode>(context.save(string())));
+            }
+            default:
+                failed = true;
+                return nullptr;
+            }
+        }
+    };
+}
+
+ASTCache::ASTCache(std::string directory) : directory(std::move(directory)) {}
+
+std::string ASTCache::serialize(llvm::StringRef source, const ProgramNode *program, const StringInterner &names)
+{
+    return Writer(names).write(source, program);
+}
+
+ProgramNode *ASTCache::deserialize(llvm::StringRef data, llvm::StringRef source, ASTContext &context, StringInterner &names)
+{
+    return Reader(data, context, names).read(source);
+}
+
+std::string ASTCache::getPath(uint64_t hash) const
+{
+    llvm::SmallString<128> path(directory);
+    llvm::sys::path::append(path, llvm::utohexstr(hash, false, 16) + ".zxast");
+    return std::string(path);
+}
+
+ProgramNode *ASTCache::load(llvm::StringRef source, ASTContext &context, StringInterner &names) const
+{
+    // Mapped rather than read, and only the nodes are copied out of it.
+    auto buffer = llvm::MemoryBuffer::getFile(getPath(llvm::xxHash64(source)), false, false);
+    if (!buffer)
+    {
+        return nullptr;
+    }
+    return deserialize((*buffer)->getBuffer(), source, context, names);
+}
+
+bool ASTCache::store(llvm::StringRef source, const ProgramNode *program, const StringInterner &names, std::string &error) const
+{
+    if (std::error_code code = llvm::sys::fs::create_directories(directory))
+    {
+        error = "Cannot create the AST cache directory '" + directory + "': " + code.message();
+        return false;
+    }
+    std::string path = getPath(llvm::xxHash64(source));
+    int fd;
+    llvm::SmallString<128> temporary;
+    if (std::error_code code = llvm::sys::fs::createUniqueFile(path + ".%%%%%%%%.tmp", fd, temporary))
+    {
+        error = "Cannot write to the AST cache directory '" + directory + "': " + code.message();
+        return false;
+    }
+    {
+        llvm::raw_fd_ostream out(fd, true);
+        out << serialize(source, program, names);
+        out.close();
+        if (out.has_error())
+        {
+            error = "Cannot write '" + std::string(temporary) + "': " + out.error().message();
+            out.clear_error();
+            llvm::sys::fs::remove(temporary);
+            return false;
+        }
+    }
+    if (std::error_code code = llvm::sys::fs::rename(temporary, path))
+    {
+        error = "Cannot write '" + path + "': " + code.message();
+        llvm::sys::fs::remove(temporary);
+        return false;
+    }
+    return true;
+}
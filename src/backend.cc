@@ -0,0 +1,143 @@
+#include <mutex>
+#include <backend.hh>
+#include <llvm/Analysis/CGSCCPassManager.h>
+#include <llvm/Analysis/LoopAnalysisManager.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/TargetParser/Host.h>
+#include <llvm/TargetParser/Triple.h>
+
+static void initialize_targets()
+{
+    static std::once_flag initialized;
+    std::call_once(initialized, []()
+                   {
+        llvm::InitializeAllTargetInfos();
+        llvm::InitializeAllTargets();
+        llvm::InitializeAllTargetMCs();
+        llvm::InitializeAllAsmParsers();
+        llvm::InitializeAllAsmPrinters(); });
+}
+
+std::unique_ptr<llvm::TargetMachine> create_target_machine(const std::string &march, OptimizationLevel level, std::string &error)
+{
+    initialize_targets();
+    llvm::Triple triple(llvm::sys::getDefaultTargetTriple());
+    std::string cpu = "generic";
+    if (march.empty())
+    {
+        cpu = llvm::sys::getHostCPUName().str();
+    }
+    else
+    {
+        llvm::Triple::ArchType arch = llvm::Triple::getArchTypeForLLVMName(march);
+        if (arch == llvm::Triple::UnknownArch)
+        {
+            error = "Unknown target architecture '" + march + "'.";
+            return nullptr;
+        }
+        triple.setArch(arch);
+    }
+
+    const llvm::Target *target = llvm::TargetRegistry::lookupTarget(triple.str(), error);
+    if (!target)
+    {
+        return nullptr;
+    }
+    llvm::CodeGenOpt::Level codegen_level = llvm::CodeGenOpt::None;
+    switch (level)
+    {
+    case O1:
+        codegen_level = llvm::CodeGenOpt::Less;
+        break;
+    case O2:
+        codegen_level = llvm::CodeGenOpt::Default;
+        break;
+    case O3:
+        codegen_level = llvm::CodeGenOpt::Aggressive;
+        break;
+    default:
+        break;
+    }
+    llvm::TargetOptions options;
+    std::unique_ptr<llvm::TargetMachine> machine(target->createTargetMachine(triple.str(), cpu, "", options, llvm::Reloc::PIC_));
+    machine->setOptLevel(codegen_level);
+    return machine;
+}
+
+void optimize_module(llvm::Module &module, llvm::TargetMachine &target, OptimizationLevel level)
+{
+    llvm::LoopAnalysisManager loop_analyses;
+    llvm::FunctionAnalysisManager function_analyses;
+    llvm::CGSCCAnalysisManager cgscc_analyses;
+    llvm::ModuleAnalysisManager module_analyses;
+    llvm::PassBuilder builder(&target);
+    builder.registerModuleAnalyses(module_analyses);
+    builder.registerCGSCCAnalyses(cgscc_analyses);
+    builder.registerFunctionAnalyses(function_analyses);
+    builder.registerLoopAnalyses(loop_analyses);
+    builder.crossRegisterProxies(loop_analyses, function_analyses, cgscc_analyses, module_analyses);
+
+    llvm::ModulePassManager passes;
+    switch (level)
+    {
+    case O1:
+        passes = builder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O1);
+        break;
+    case O2:
+        passes = builder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2);
+        break;
+    case O3:
+        passes = builder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O3);
+        break;
+    default:
+        passes = builder.buildO0DefaultPipeline(llvm::OptimizationLevel::O0);
+        break;
+    }
+    passes.run(module, module_analyses);
+}
+
+bool emit_module(llvm::Module &module, llvm::TargetMachine &target, StageType stage, const std::string &path, std::string &error)
+{
+    std::error_code code;
+    llvm::raw_fd_ostream out(path, code, stage == c ? llvm::sys::fs::OF_None : llvm::sys::fs::OF_Text);
+    if (code)
+    {
+        error = "Unable to open '" + path + "': " + code.message();
+        return false;
+    }
+    if (stage == B)
+    {
+        module.print(out, nullptr);
+        return true;
+    }
+
+    // Machine code is still emitted by the legacy pass manager.
+    llvm::legacy::PassManager passes;
+    auto type = stage == S ? llvm::CGFT_AssemblyFile : llvm::CGFT_ObjectFile;
+    if (target.addPassesToEmitFile(passes, out, nullptr, type))
+    {
+        error = "The target cannot emit this kind of file.";
+        return false;
+    }
+    passes.run(module);
+    return true;
+}
+
+const char *output_extension(StageType stage)
+{
+    switch (stage)
+    {
+    case S:
+        return ".s";
+    case B:
+        return ".ll";
+    default:
+        return ".o";
+    }
+}
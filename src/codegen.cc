@@ -0,0 +1,916 @@
+#include <algorithm>
+#include <codegen.hh>
+#include <llvm/ADT/APFloat.h>
+#include <llvm/ADT/APInt.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/raw_ostream.h>
+
+// Jump tables pay off from this many cases on, as in the switch lowering of LLVM.
+static constexpr size_t MIN_JUMP_TABLE_CASES = 4;
+// Least percentage of the values between the lowest and highest case of a jump table which have a case.
+static constexpr uint64_t MIN_JUMP_TABLE_DENSITY = 40;
+
+// Whether count cases from low to high, sorted in the order they are compared in, fill a jump table densely enough.
+static bool isDense(const llvm::APInt &low, const llvm::APInt &high, size_t count)
+{
+    // The difference of the sorted values is their distance in either order, limited so the product cannot overflow.
+    uint64_t range = (high - low).getLimitedValue(UINT64_MAX / 100 - 1) + 1;
+    return count * 100 >= range * MIN_JUMP_TABLE_DENSITY;
+}
+
+CodeGenerator::CodeGenerator(llvm::LLVMContext &llvm_context, const StringInterner &names, PrintGlobalState &print)
+    : llvm_context(llvm_context), names(names), print(print), file(0), builder(llvm_context), function(nullptr), returns_signed(false), failed(false) {}
+
+std::unique_ptr<llvm::Module> CodeGenerator::generate(const ProgramNode *program, FileID file, llvm::StringRef module_name, const llvm::TargetMachine &target)
+{
+    this->file = file;
+    // Set before generating anything, the alignment of every alloca, load and store depends on it.
+    module = std::make_unique<llvm::Module>(module_name, llvm_context);
+    module->setTargetTriple(target.getTargetTriple().str());
+    module->setDataLayout(target.createDataLayout());
+    structs.clear();
+    failed = false;
+    for (const DeclarationNode *declaration : program->declarations)
+    {
+        // Enums and structs only declare types, which are resolved where they are used.
+        if (auto *function_declaration = llvm::dyn_cast<FunctionDeclarationNode>(declaration))
+        {
+            generateFunction(function_declaration);
+        }
+    }
+    if (failed)
+    {
+        return nullptr;
+    }
+
+    std::string message;
+    llvm::raw_string_ostream stream(message);
+    if (llvm::verifyModule(*module, &stream))
+    {
+        print.error(module->getSourceFileName() + ": Generated invalid LLVM IR: " + stream.str());
+        return nullptr;
+    }
+    return std::move(module);
+}
+
+void CodeGenerator::error(const std::string &message, const ASTNode *node)
+{
+    print.error(message, node->offset, file);
+    failed = true;
+}
+
+llvm::Type *CodeGenerator::getType(const Type *type)
+{
+    if (auto *primitive = llvm::dyn_cast<PrimitiveType>(type))
+    {
+        return primitive->isVoid() ? builder.getVoidTy() : getType(primitive);
+    }
+    // Enums are represented by the index of their field.
+    if (llvm::isa<EnumType>(type))
+    {
+        return builder.getInt32Ty();
+    }
+    // Declared types are scalars and structs, arrays are only the types of string literals.
+    auto *structure = llvm::cast<StructType>(type);
+    if (llvm::StructType *lowered = structs.lookup(structure))
+    {
+        return lowered;
+    }
+    // Semantic analysis rejects structs holding themselves, so lowering their fields ends.
+    llvm::SmallVector<llvm::Type *, 8> fields;
+    for (const StructType::Field &field : structure->fields)
+    {
+        fields.push_back(getType(field.type));
+    }
+    llvm::StructType *lowered = llvm::StructType::create(llvm_context, fields, "struct." + names.get(structure->name).str());
+    structs[structure] = lowered;
+    return lowered;
+}
+
+llvm::Type *CodeGenerator::getType(const PrimitiveType *type)
+{
+    if (!type->isFloat())
+    {
+        return builder.getIntNTy(type->bits);
+    }
+    switch (type->bits)
+    {
+    case 32:
+        return builder.getFloatTy();
+    case 64:
+        return builder.getDoubleTy();
+    case 80:
+        return llvm::Type::getX86_FP80Ty(llvm_context);
+    default:
+        return llvm::Type::getFP128Ty(llvm_context);
+    }
+}
+
+bool CodeGenerator::isSigned(const Type *type)
+{
+    auto *primitive = llvm::dyn_cast<PrimitiveType>(type);
+    return primitive ? primitive->is_signed : llvm::isa<EnumType>(type);
+}
+
+void CodeGenerator::generateFunction(const FunctionDeclarationNode *declaration)
+{
+    llvm::Type *return_type = declaration->return_type ? getType(declaration->return_type->resolved_type) : builder.getVoidTy();
+    llvm::SmallVector<llvm::Type *, 8> parameter_types;
+    for (const ParameterNode *parameter : declaration->parameters)
+    {
+        parameter_types.push_back(getType(parameter->type->resolved_type));
+    }
+
+    llvm::StringRef name = names.get(declaration->name);
+    if (module->getFunction(name))
+    {
+        error("Redefinition of function '" + name.str() + "'.", declaration);
+        return;
+    }
+    auto *type = llvm::FunctionType::get(return_type, parameter_types, false);
+    function = llvm::Function::Create(type, llvm::Function::ExternalLinkage, name, module.get());
+    returns_signed = declaration->return_type && isSigned(declaration->return_type->resolved_type);
+    builder.SetInsertPoint(llvm::BasicBlock::Create(llvm_context, "entry", function));
+
+    llvm::ScopedHashTableScope<NameID, Variable> scope(variables);
+    for (size_t i = 0; i < declaration->parameters.size(); i++)
+    {
+        const ParameterNode *parameter = declaration->parameters[i];
+        llvm::Argument *argument = function->getArg(i);
+        argument->setName(names.get(parameter->name));
+        llvm::AllocaInst *address = createEntryAlloca(argument->getType(), argument->getName());
+        builder.CreateStore(argument, address);
+        variables.insert(parameter->name, {address, isSigned(parameter->type->resolved_type)});
+    }
+
+    generateBlock(declaration->body);
+
+    // Semantic analysis checked that only a function without a return type can fall off its end.
+    if (!builder.GetInsertBlock()->getTerminator())
+    {
+        if (return_type->isVoidTy())
+        {
+            builder.CreateRetVoid();
+        }
+        else
+        {
+            builder.CreateUnreachable();
+        }
+    }
+}
+
+void CodeGenerator::generateStatement(const StatementNode *statement)
+{
+    switch (statement->getKind())
+    {
+    case ASTNode::NODE_BLOCK:
+        generateBlock(llvm::cast<BlockNode>(statement));
+        break;
+    case ASTNode::NODE_IF_STATEMENT:
+        generateIf(llvm::cast<IfStatementNode>(statement));
+        break;
+    case ASTNode::NODE_LOOP_STATEMENT:
+        generateLoop(llvm::cast<LoopStatementNode>(statement));
+        break;
+    case ASTNode::NODE_VAR_DECLARATION:
+        generateVarDeclaration(llvm::cast<VarDeclarationNode>(statement));
+        break;
+    case ASTNode::NODE_RET_STATEMENT:
+        generateRet(llvm::cast<RetStatementNode>(statement));
+        break;
+    case ASTNode::NODE_EXPRESSION_STATEMENT:
+        generateExpression(llvm::cast<ExpressionStatementNode>(statement)->expression, nullptr);
+        break;
+    case ASTNode::NODE_BREAK_STATEMENT:
+    case ASTNode::NODE_CONTINUE_STATEMENT:
+        if (loops.empty())
+        {
+            error("'break' and 'continue' are only allowed inside of a loop.", statement);
+            return;
+        }
+        builder.CreateBr(llvm::isa<BreakStatementNode>(statement) ? loops.back().exit : loops.back().header);
+        break;
+    case ASTNode::NODE_MATCH_STATEMENT:
+        generateMatch(llvm::cast<MatchStatementNode>(statement));
+        break;
+    default:
+        llvm_unreachable("Unknown statement kind");
+    }
+}
+
+void CodeGenerator::generateBlock(const BlockNode *block)
+{
+    llvm::ScopedHashTableScope<NameID, Variable> scope(variables);
+    for (const StatementNode *statement : block->statements)
+    {
+        // Everything after a ret, break or continue is unreachable.
+        if (builder.GetInsertBlock()->getTerminator())
+        {
+            break;
+        }
+        generateStatement(statement);
+    }
+}
+
+void CodeGenerator::generateIf(const IfStatementNode *statement)
+{
+    llvm::BasicBlock *end = llvm::BasicBlock::Create(llvm_context, "if.end");
+    llvm::SmallVector<const IfStatementNode *, 4> branches = {statement};
+    branches.append(statement->elif_statements.begin(), statement->elif_statements.end());
+
+    for (const IfStatementNode *branch : branches)
+    {
+        llvm::Value *condition = toCondition(generateExpression(branch->condition, nullptr), branch->condition);
+        if (!condition)
+        {
+            // Already reported, the module is discarded but must stay well formed until then.
+            condition = builder.getFalse();
+        }
+        llvm::BasicBlock *then = llvm::BasicBlock::Create(llvm_context, "if.then", function);
+        llvm::BasicBlock *otherwise = llvm::BasicBlock::Create(llvm_context, "if.else");
+        builder.CreateCondBr(condition, then, otherwise);
+
+        builder.SetInsertPoint(then);
+        generateBlock(branch->then_block);
+        if (!builder.GetInsertBlock()->getTerminator())
+        {
+            builder.CreateBr(end);
+        }
+        otherwise->insertInto(function);
+        builder.SetInsertPoint(otherwise);
+    }
+
+    if (statement->else_block)
+    {
+        generateBlock(statement->else_block);
+    }
+    if (!builder.GetInsertBlock()->getTerminator())
+    {
+        builder.CreateBr(end);
+    }
+    end->insertInto(function);
+    builder.SetInsertPoint(end);
+}
+
+void CodeGenerator::generateLoop(const LoopStatementNode *statement)
+{
+    llvm::BasicBlock *header = llvm::BasicBlock::Create(llvm_context, "loop", function);
+    llvm::BasicBlock *exit = llvm::BasicBlock::Create(llvm_context, "loop.end");
+    builder.CreateBr(header);
+    builder.SetInsertPoint(header);
+
+    loops.push_back({header, exit});
+    generateBlock(statement->body);
+    loops.pop_back();
+    if (!builder.GetInsertBlock()->getTerminator())
+    {
+        builder.CreateBr(header);
+    }
+    exit->insertInto(function);
+    builder.SetInsertPoint(exit);
+}
+
+void CodeGenerator::generateMatch(const MatchStatementNode *statement)
+{
+    if (llvm::isa_and_nonnull<ArrayType>(statement->subject->value_type))
+    {
+        generateStringMatch(statement);
+        return;
+    }
+    TypedValue subject = generateExpression(statement->subject, nullptr);
+    if (!subject.value)
+    {
+        return;
+    }
+    llvm::Type *type = subject.value->getType();
+    if (!type->isIntegerTy())
+    {
+        error("Cannot match on a value which is not an integer.", statement->subject);
+        return;
+    }
+
+    llvm::BasicBlock *end = llvm::BasicBlock::Create(llvm_context, "match.end");
+    llvm::BasicBlock *otherwise = statement->default_block ? llvm::BasicBlock::Create(llvm_context, "match.default") : end;
+    llvm::SmallVector<Case, 16> cases;
+    for (const CaseClauseNode *clause : statement->cases)
+    {
+        llvm::Value *value = convert(generateLiteral(clause->literal, type), type, subject.is_signed, clause->literal);
+        if (!value)
+        {
+            continue;
+        }
+        // Constant, since the literal is converted by the builder which folds constants.
+        cases.push_back({llvm::cast<llvm::ConstantInt>(value), llvm::BasicBlock::Create(llvm_context, "match.case")});
+    }
+    if (failed)
+    {
+        return;
+    }
+
+    // Dispatched in order of value, bodies are still generated in the order of their cases.
+    llvm::SmallVector<Case, 16> sorted(cases.begin(), cases.end());
+    std::stable_sort(sorted.begin(), sorted.end(), [&](const Case &left, const Case &right)
+                     {
+                         const llvm::APInt &a = left.value->getValue(), &b = right.value->getValue();
+                         return subject.is_signed ? a.slt(b) : a.ult(b);
+                     });
+    // Duplicates are reported by constant evaluation, the first case of a value wins.
+    sorted.erase(std::unique(sorted.begin(), sorted.end(), [](const Case &left, const Case &right)
+                             { return left.value == right.value; }),
+                 sorted.end());
+    llvm::SmallVector<CaseCluster, 16> clusters = clusterCases(sorted);
+    if (clusters.empty())
+    {
+        builder.CreateBr(otherwise);
+    }
+    else
+    {
+        generateCaseTree(subject.value, subject.is_signed, sorted, clusters, otherwise);
+    }
+
+    for (size_t i = 0; i < cases.size(); i++)
+    {
+        cases[i].block->insertInto(function);
+        builder.SetInsertPoint(cases[i].block);
+        generateBlock(statement->cases[i]->block);
+        if (!builder.GetInsertBlock()->getTerminator())
+        {
+            builder.CreateBr(end);
+        }
+    }
+    if (statement->default_block)
+    {
+        otherwise->insertInto(function);
+        builder.SetInsertPoint(otherwise);
+        generateBlock(statement->default_block);
+        if (!builder.GetInsertBlock()->getTerminator())
+        {
+            builder.CreateBr(end);
+        }
+    }
+    end->insertInto(function);
+    builder.SetInsertPoint(end);
+}
+
+llvm::SmallVector<CodeGenerator::CaseCluster, 16> CodeGenerator::clusterCases(llvm::ArrayRef<Case> cases)
+{
+    // Each cluster is grown as long as it stays dense, one too small for a jump table is split into single cases.
+    llvm::SmallVector<CaseCluster, 16> clusters;
+    size_t first = 0;
+    while (first < cases.size())
+    {
+        size_t last = first + 1;
+        while (last < cases.size() && isDense(cases[first].value->getValue(), cases[last].value->getValue(), last + 1 - first))
+        {
+            last++;
+        }
+        if (last - first < MIN_JUMP_TABLE_CASES)
+        {
+            last = first + 1;
+        }
+        clusters.push_back({first, last});
+        first = last;
+    }
+    return clusters;
+}
+
+void CodeGenerator::generateCaseTree(llvm::Value *subject, bool is_signed, llvm::ArrayRef<Case> cases, llvm::ArrayRef<CaseCluster> clusters, llvm::BasicBlock *otherwise)
+{
+    if (clusters.size() == 1)
+    {
+        llvm::ArrayRef<Case> cluster = cases.slice(clusters[0].first, clusters[0].last - clusters[0].first);
+        if (cluster.size() == 1)
+        {
+            builder.CreateCondBr(builder.CreateICmpEQ(subject, cluster[0].value), cluster[0].block, otherwise);
+            return;
+        }
+        // Lowered to a jump table by the backend.
+        llvm::SwitchInst *table = builder.CreateSwitch(subject, otherwise, cluster.size());
+        for (const Case &branch : cluster)
+        {
+            table->addCase(branch.value, branch.block);
+        }
+        return;
+    }
+    // Split at the lowest value of the upper half, so every case is reached after a logarithmic number of compares.
+    size_t middle = clusters.size() / 2;
+    llvm::ConstantInt *pivot = cases[clusters[middle].first].value;
+    llvm::Value *below = is_signed ? builder.CreateICmpSLT(subject, pivot) : builder.CreateICmpULT(subject, pivot);
+    llvm::BasicBlock *lower = llvm::BasicBlock::Create(llvm_context, "match.lt", function);
+    llvm::BasicBlock *upper = llvm::BasicBlock::Create(llvm_context, "match.ge", function);
+    builder.CreateCondBr(below, lower, upper);
+    builder.SetInsertPoint(lower);
+    generateCaseTree(subject, is_signed, cases, clusters.take_front(middle), otherwise);
+    builder.SetInsertPoint(upper);
+    generateCaseTree(subject, is_signed, cases, clusters.drop_front(middle), otherwise);
+}
+
+void CodeGenerator::generateStringMatch(const MatchStatementNode *statement)
+{
+    // Strings are literals only, so the case taken is known at compile time.
+    auto *subject = llvm::dyn_cast<LiteralNode>(statement->subject);
+    if (!subject)
+    {
+        error("Cannot match on a string which is not a literal.", statement->subject);
+        return;
+    }
+    const BlockNode *taken = statement->default_block;
+    for (const CaseClauseNode *clause : statement->cases)
+    {
+        if (clause->literal->type == TokenType::TKL_STR && clause->literal->value == subject->value)
+        {
+            taken = clause->block;
+            break;
+        }
+    }
+    if (taken)
+    {
+        generateBlock(taken);
+    }
+}
+
+void CodeGenerator::generateVarDeclaration(const VarDeclarationNode *declaration)
+{
+    const Type *declared = declaration->type->resolved_type;
+    llvm::Type *type = getType(declared);
+    llvm::Value *value = llvm::Constant::getNullValue(type);
+    if (declaration->initializer)
+    {
+        value = convert(generateExpression(declaration->initializer, type), type, isSigned(declared), declaration->initializer);
+        if (!value)
+        {
+            return;
+        }
+    }
+    // Inserted after the initializer, which still refers to any shadowed variable.
+    llvm::AllocaInst *address = createEntryAlloca(type, names.get(declaration->name));
+    builder.CreateStore(value, address);
+    variables.insert(declaration->name, {address, isSigned(declared)});
+}
+
+void CodeGenerator::generateRet(const RetStatementNode *statement)
+{
+    llvm::Type *return_type = function->getReturnType();
+    if (!statement->value)
+    {
+        if (!return_type->isVoidTy())
+        {
+            error("Missing return value in function '" + function->getName().str() + "'.", statement);
+            return;
+        }
+        builder.CreateRetVoid();
+        return;
+    }
+    if (return_type->isVoidTy())
+    {
+        error("Function '" + function->getName().str() + "' has no return type but returns a value.", statement);
+        return;
+    }
+    llvm::Value *value = convert(generateExpression(statement->value, return_type), return_type, returns_signed, statement->value);
+    if (value)
+    {
+        builder.CreateRet(value);
+    }
+}
+
+CodeGenerator::TypedValue CodeGenerator::generateExpression(const ExpressionNode *expression, llvm::Type *expected)
+{
+    switch (expression->getKind())
+    {
+    case ASTNode::NODE_LITERAL:
+        return generateLiteral(llvm::cast<LiteralNode>(expression), expected);
+    case ASTNode::NODE_IDENTIFIER:
+    {
+        Variable variable = lookupVariable(expression, Operator::NONE);
+        if (!variable.address)
+        {
+            return {nullptr, false};
+        }
+        return {builder.CreateLoad(variable.address->getAllocatedType(), variable.address), variable.is_signed};
+    }
+    case ASTNode::NODE_UNARY_EXPR:
+        return generateUnary(llvm::cast<UnaryExprNode>(expression), expected);
+    case ASTNode::NODE_BINARY_EXPR:
+        return generateBinary(llvm::cast<BinaryExprNode>(expression), expected);
+    default:
+        // Only literals, identifiers and operators are parsed, semantic analysis rejects any other expression.
+        llvm_unreachable("Unknown expression kind");
+    }
+}
+
+CodeGenerator::Variable CodeGenerator::lookupVariable(const ExpressionNode *expression, Operator op)
+{
+    auto *identifier = llvm::dyn_cast<IdentifierNode>(expression);
+    if (!identifier)
+    {
+        error("Operand of '" + std::string(operator_info(op).spelling) + "' must be a variable.", expression);
+        return {nullptr, false};
+    }
+    Variable variable = variables.lookup(identifier->name);
+    if (!variable.address)
+    {
+        error("Unknown identifier '" + names.get(identifier->name).str() + "'.", identifier);
+    }
+    return variable;
+}
+
+CodeGenerator::TypedValue CodeGenerator::generateLiteral(const LiteralNode *literal, llvm::Type *expected)
+{
+    // Typed by semantic analysis, folded constants keep the exact type they were computed in.
+    bool is_signed = true;
+    if (literal->value_type && literal->value_type->isScalar())
+    {
+        auto *type = llvm::isa<PrimitiveType>(literal->value_type) ? llvm::cast<PrimitiveType>(literal->value_type) : nullptr;
+        expected = type ? getType(type) : builder.getInt32Ty();
+        is_signed = !type || type->is_signed || type->isFloat();
+    }
+    switch (literal->type)
+    {
+    case TokenType::TKL_INT:
+    {
+        if (expected && expected->isFloatingPointTy())
+        {
+            break;
+        }
+        llvm::APInt value;
+        if (literal->value.getAsInteger(0, value))
+        {
+            error("Invalid integer literal '" + literal->value.str() + "'.", literal);
+            return {nullptr, false};
+        }
+        unsigned width = expected && expected->isIntegerTy() ? expected->getIntegerBitWidth() : (value.getActiveBits() < 32 ? 32 : 64);
+        return {builder.getInt(value.zextOrTrunc(width)), is_signed};
+    }
+    case TokenType::TKL_FLOAT:
+        break;
+    case TokenType::TKL_CHAR:
+        return {builder.getInt8(literal->value.empty() ? 0 : literal->value[0]), false};
+    case TokenType::TKL_STR:
+        return {builder.CreateGlobalStringPtr(literal->value, "str"), false};
+    case TokenType::TK_KEYWORD:
+    {
+        // Without a type from semantic analysis 'true' and 'false' are bools and 'null' an i32.
+        uint64_t value = literal->value == "true";
+        if (!expected)
+        {
+            expected = literal->value == "null" ? builder.getInt32Ty() : builder.getInt1Ty();
+            is_signed = literal->value == "null";
+        }
+        if (expected->isFloatingPointTy())
+        {
+            return {llvm::ConstantFP::get(expected, static_cast<double>(value)), true};
+        }
+        return {llvm::ConstantInt::get(expected, value), is_signed};
+    }
+    default:
+        error("Invalid literal '" + literal->value.str() + "'.", literal);
+        return {nullptr, false};
+    }
+
+    llvm::Type *type = expected && expected->isFloatingPointTy() ? expected : builder.getDoubleTy();
+    llvm::APFloat value(type->getFltSemantics());
+    auto status = value.convertFromString(literal->value, llvm::APFloat::rmNearestTiesToEven);
+    if (!status)
+    {
+        llvm::consumeError(status.takeError());
+        error("Invalid floating point literal '" + literal->value.str() + "'.", literal);
+        return {nullptr, false};
+    }
+    return {llvm::ConstantFP::get(llvm_context, value), true};
+}
+
+CodeGenerator::TypedValue CodeGenerator::generateUnary(const UnaryExprNode *expression, llvm::Type *expected)
+{
+    Operator op = expression->op;
+    if (op == Operator::INCREMENT || op == Operator::DECREMENT)
+    {
+        Variable variable = lookupVariable(expression->operand, op);
+        if (!variable.address)
+        {
+            return {nullptr, false};
+        }
+        llvm::Type *type = variable.address->getAllocatedType();
+        llvm::Value *value = builder.CreateLoad(type, variable.address);
+        if (type->isFloatingPointTy())
+        {
+            llvm::Value *one = llvm::ConstantFP::get(type, 1.0);
+            value = op == Operator::INCREMENT ? builder.CreateFAdd(value, one) : builder.CreateFSub(value, one);
+        }
+        else
+        {
+            llvm::Value *one = llvm::ConstantInt::get(type, 1);
+            value = op == Operator::INCREMENT ? builder.CreateAdd(value, one) : builder.CreateSub(value, one);
+        }
+        builder.CreateStore(value, variable.address);
+        return {value, variable.is_signed};
+    }
+
+    TypedValue operand = generateExpression(expression->operand, op == Operator::NOT ? nullptr : expected);
+    if (!operand.value)
+    {
+        return operand;
+    }
+    llvm::Type *type = operand.value->getType();
+    if (op == Operator::NOT)
+    {
+        llvm::Value *condition = toCondition(operand, expression->operand);
+        return {condition ? builder.CreateNot(condition) : nullptr, false};
+    }
+    if (op == Operator::ADD && (type->isIntegerTy() || type->isFloatingPointTy()))
+    {
+        return operand;
+    }
+    if (op == Operator::SUB && type->isFloatingPointTy())
+    {
+        return {builder.CreateFNeg(operand.value), true};
+    }
+    if (op == Operator::SUB && type->isIntegerTy())
+    {
+        return {builder.CreateNeg(operand.value), operand.is_signed};
+    }
+    if (op == Operator::BIT_NOT && type->isIntegerTy())
+    {
+        return {builder.CreateNot(operand.value), operand.is_signed};
+    }
+    error("Invalid operand to unary operator '" + std::string(operator_info(op).spelling) + "'.", expression);
+    return {nullptr, false};
+}
+
+CodeGenerator::TypedValue CodeGenerator::generateBinary(const BinaryExprNode *expression, llvm::Type *expected)
+{
+    const OperatorInfo &info = operator_info(expression->op);
+    if (info.precedence == PREC_ASSIGN)
+    {
+        return generateAssignment(expression);
+    }
+    if (expression->op == Operator::LOGICAL_AND || expression->op == Operator::LOGICAL_OR)
+    {
+        return generateLogical(expression);
+    }
+    // Comparisons produce a bool, what their operands are typed as does not depend on it.
+    if (info.precedence == PREC_EQUALITY || info.precedence == PREC_RELATIONAL)
+    {
+        expected = nullptr;
+    }
+    TypedValue left = generateExpression(expression->left, expected);
+    TypedValue right = generateExpression(expression->right, expected);
+    return generateOperation(expression->op, left, right, expression);
+}
+
+CodeGenerator::TypedValue CodeGenerator::generateAssignment(const BinaryExprNode *expression)
+{
+    Variable variable = lookupVariable(expression->left, expression->op);
+    if (!variable.address)
+    {
+        return {nullptr, false};
+    }
+    llvm::Type *type = variable.address->getAllocatedType();
+    TypedValue value = generateExpression(expression->right, type);
+    Operator compound = operator_info(expression->op).compound;
+    if (compound != Operator::NONE)
+    {
+        TypedValue current = {builder.CreateLoad(type, variable.address), variable.is_signed};
+        value = generateOperation(compound, current, value, expression);
+    }
+    llvm::Value *result = convert(value, type, variable.is_signed, expression->right);
+    if (!result)
+    {
+        return {nullptr, false};
+    }
+    builder.CreateStore(result, variable.address);
+    return {result, variable.is_signed};
+}
+
+CodeGenerator::TypedValue CodeGenerator::generateLogical(const BinaryExprNode *expression)
+{
+    // The right operand is only evaluated when the left one does not decide the result.
+    bool is_and = expression->op == Operator::LOGICAL_AND;
+    llvm::Value *left = toCondition(generateExpression(expression->left, nullptr), expression->left);
+    if (!left)
+    {
+        return {nullptr, false};
+    }
+    llvm::BasicBlock *start = builder.GetInsertBlock();
+    llvm::BasicBlock *rhs = llvm::BasicBlock::Create(llvm_context, is_and ? "and.rhs" : "or.rhs", function);
+    llvm::BasicBlock *end = llvm::BasicBlock::Create(llvm_context, is_and ? "and.end" : "or.end");
+    if (is_and)
+    {
+        builder.CreateCondBr(left, rhs, end);
+    }
+    else
+    {
+        builder.CreateCondBr(left, end, rhs);
+    }
+
+    builder.SetInsertPoint(rhs);
+    llvm::Value *right = toCondition(generateExpression(expression->right, nullptr), expression->right);
+    if (!right)
+    {
+        // Already reported, the module is discarded but must stay well formed until then.
+        right = builder.getFalse();
+    }
+    rhs = builder.GetInsertBlock();
+    builder.CreateBr(end);
+
+    end->insertInto(function);
+    builder.SetInsertPoint(end);
+    llvm::PHINode *result = builder.CreatePHI(builder.getInt1Ty(), 2);
+    result->addIncoming(builder.getInt1(!is_and), start);
+    result->addIncoming(right, rhs);
+    return {result, false};
+}
+
+CodeGenerator::TypedValue CodeGenerator::generateOperation(Operator op, TypedValue left, TypedValue right, const ExpressionNode *expression)
+{
+    if (!left.value || !right.value)
+    {
+        return {nullptr, false};
+    }
+    std::string spelling(operator_info(op).spelling);
+    llvm::Type *left_type = left.value->getType();
+    llvm::Type *right_type = right.value->getType();
+    bool is_float = left_type->isFloatingPointTy() || right_type->isFloatingPointTy();
+    if ((!left_type->isIntegerTy() && !left_type->isFloatingPointTy()) || (!right_type->isIntegerTy() && !right_type->isFloatingPointTy()))
+    {
+        error("Invalid operands to binary operator '" + spelling + "'.", expression);
+        return {nullptr, false};
+    }
+
+    // Both operands are converted to the wider type, integers become floats.
+    llvm::Type *type;
+    if (is_float && !left_type->isFloatingPointTy())
+    {
+        type = right_type;
+    }
+    else if (is_float && !right_type->isFloatingPointTy())
+    {
+        type = left_type;
+    }
+    else
+    {
+        type = left_type->getPrimitiveSizeInBits() >= right_type->getPrimitiveSizeInBits() ? left_type : right_type;
+    }
+    bool is_signed = left.is_signed && right.is_signed;
+    llvm::Value *lhs = convert(left, type, is_signed, expression);
+    llvm::Value *rhs = convert(right, type, is_signed, expression);
+
+    switch (op)
+    {
+    case Operator::ADD:
+        return {is_float ? builder.CreateFAdd(lhs, rhs) : builder.CreateAdd(lhs, rhs), is_signed};
+    case Operator::SUB:
+        return {is_float ? builder.CreateFSub(lhs, rhs) : builder.CreateSub(lhs, rhs), is_signed};
+    case Operator::MUL:
+        return {is_float ? builder.CreateFMul(lhs, rhs) : builder.CreateMul(lhs, rhs), is_signed};
+    case Operator::DIV:
+        return {is_float ? builder.CreateFDiv(lhs, rhs) : is_signed ? builder.CreateSDiv(lhs, rhs) : builder.CreateUDiv(lhs, rhs), is_signed};
+    case Operator::MOD:
+        return {is_float ? builder.CreateFRem(lhs, rhs) : is_signed ? builder.CreateSRem(lhs, rhs) : builder.CreateURem(lhs, rhs), is_signed};
+    case Operator::POW:
+        if (is_float)
+        {
+            return {builder.CreateBinaryIntrinsic(llvm::Intrinsic::pow, lhs, rhs), is_signed};
+        }
+        return {generateIntegerPower(lhs, rhs, is_signed), is_signed};
+    case Operator::EQUAL:
+        return {is_float ? builder.CreateFCmpOEQ(lhs, rhs) : builder.CreateICmpEQ(lhs, rhs), false};
+    case Operator::NOT_EQUAL:
+        return {is_float ? builder.CreateFCmpUNE(lhs, rhs) : builder.CreateICmpNE(lhs, rhs), false};
+    case Operator::LESS:
+        return {is_float ? builder.CreateFCmpOLT(lhs, rhs) : is_signed ? builder.CreateICmpSLT(lhs, rhs) : builder.CreateICmpULT(lhs, rhs), false};
+    case Operator::GREATER:
+        return {is_float ? builder.CreateFCmpOGT(lhs, rhs) : is_signed ? builder.CreateICmpSGT(lhs, rhs) : builder.CreateICmpUGT(lhs, rhs), false};
+    case Operator::LESS_EQUAL:
+        return {is_float ? builder.CreateFCmpOLE(lhs, rhs) : is_signed ? builder.CreateICmpSLE(lhs, rhs) : builder.CreateICmpULE(lhs, rhs), false};
+    case Operator::GREATER_EQUAL:
+        return {is_float ? builder.CreateFCmpOGE(lhs, rhs) : is_signed ? builder.CreateICmpSGE(lhs, rhs) : builder.CreateICmpUGE(lhs, rhs), false};
+    default:
+        break;
+    }
+
+    if (is_float)
+    {
+        error("Invalid floating point operands to binary operator '" + spelling + "'.", expression);
+        return {nullptr, false};
+    }
+    switch (op)
+    {
+    case Operator::BIT_AND:
+        return {builder.CreateAnd(lhs, rhs), is_signed};
+    case Operator::BIT_OR:
+        return {builder.CreateOr(lhs, rhs), is_signed};
+    case Operator::SHIFT_LEFT:
+        return {builder.CreateShl(lhs, rhs), is_signed};
+    case Operator::SHIFT_RIGHT:
+        return {is_signed ? builder.CreateAShr(lhs, rhs) : builder.CreateLShr(lhs, rhs), is_signed};
+    default:
+        // Semantic analysis rejects any other operator.
+        llvm_unreachable("Unknown binary operator");
+    }
+}
+
+llvm::Value *CodeGenerator::generateIntegerPower(llvm::Value *base, llvm::Value *exponent, bool is_signed)
+{
+    // Exponentiation by squaring, at most one iteration per bit of the exponent.
+    llvm::Type *type = base->getType();
+    llvm::BasicBlock *start = builder.GetInsertBlock();
+    llvm::BasicBlock *header = llvm::BasicBlock::Create(llvm_context, "pow", function);
+    llvm::BasicBlock *body = llvm::BasicBlock::Create(llvm_context, "pow.body", function);
+    llvm::BasicBlock *end = llvm::BasicBlock::Create(llvm_context, "pow.end", function);
+    builder.CreateBr(header);
+
+    builder.SetInsertPoint(header);
+    llvm::PHINode *result = builder.CreatePHI(type, 2);
+    llvm::PHINode *square = builder.CreatePHI(type, 2);
+    llvm::PHINode *bits = builder.CreatePHI(type, 2);
+    builder.CreateCondBr(builder.CreateICmpNE(bits, llvm::Constant::getNullValue(type)), body, end);
+
+    builder.SetInsertPoint(body);
+    llvm::Value *odd = builder.CreateTrunc(bits, builder.getInt1Ty());
+    llvm::Value *next = builder.CreateSelect(odd, builder.CreateMul(result, square), result);
+    llvm::Value *next_square = builder.CreateMul(square, square);
+    llvm::Value *next_bits = builder.CreateLShr(bits, 1);
+    builder.CreateBr(header);
+
+    result->addIncoming(llvm::ConstantInt::get(type, 1), start);
+    result->addIncoming(next, body);
+    square->addIncoming(base, start);
+    square->addIncoming(next_square, body);
+    bits->addIncoming(exponent, start);
+    bits->addIncoming(next_bits, body);
+
+    builder.SetInsertPoint(end);
+    if (!is_signed)
+    {
+        return result;
+    }
+    // A negative exponent truncates to 0 like division does. The loop already gets
+    // the powers of 1 and -1 right, since only the parity of the exponent matters for them.
+    llvm::Value *negative = builder.CreateICmpSLT(exponent, llvm::Constant::getNullValue(type));
+    llvm::Value *unit = builder.CreateICmpULE(builder.CreateAdd(base, llvm::ConstantInt::get(type, 1)), llvm::ConstantInt::get(type, 2));
+    return builder.CreateSelect(builder.CreateAnd(negative, builder.CreateNot(unit)), llvm::Constant::getNullValue(type), result);
+}
+
+llvm::Value *CodeGenerator::convert(TypedValue value, llvm::Type *type, bool is_signed, const ExpressionNode *expression)
+{
+    if (!value.value || value.value->getType() == type)
+    {
+        return value.value;
+    }
+    llvm::Type *from = value.value->getType();
+    if (from->isIntegerTy() && type->isIntegerTy(1))
+    {
+        return builder.CreateICmpNE(value.value, llvm::Constant::getNullValue(from));
+    }
+    if (from->isIntegerTy() && type->isIntegerTy())
+    {
+        return builder.CreateIntCast(value.value, type, value.is_signed);
+    }
+    if (from->isIntegerTy() && type->isFloatingPointTy())
+    {
+        return value.is_signed ? builder.CreateSIToFP(value.value, type) : builder.CreateUIToFP(value.value, type);
+    }
+    if (from->isFloatingPointTy() && type->isIntegerTy(1))
+    {
+        // NaN is true, as it is not equal to 0.
+        return builder.CreateFCmpUNE(value.value, llvm::Constant::getNullValue(from));
+    }
+    if (from->isFloatingPointTy() && type->isIntegerTy())
+    {
+        return is_signed ? builder.CreateFPToSI(value.value, type) : builder.CreateFPToUI(value.value, type);
+    }
+    if (from->isFloatingPointTy() && type->isFloatingPointTy())
+    {
+        return builder.CreateFPCast(value.value, type);
+    }
+    error("Invalid conversion of a string literal.", expression);
+    return nullptr;
+}
+
+llvm::Value *CodeGenerator::toCondition(TypedValue value, const ExpressionNode *expression)
+{
+    if (!value.value)
+    {
+        return nullptr;
+    }
+    llvm::Type *type = value.value->getType();
+    if (type->isIntegerTy())
+    {
+        return convert(value, builder.getInt1Ty(), false, expression);
+    }
+    if (type->isFloatingPointTy())
+    {
+        return builder.CreateFCmpUNE(value.value, llvm::Constant::getNullValue(type));
+    }
+    error("Invalid condition.", expression);
+    return nullptr;
+}
+
+llvm::AllocaInst *CodeGenerator::createEntryAlloca(llvm::Type *type, llvm::StringRef name)
+{
+    // Allocas in the entry block are promoted to registers by mem2reg.
+    llvm::BasicBlock &entry = function->getEntryBlock();
+    llvm::IRBuilder<> entry_builder(&entry, entry.begin());
+    return entry_builder.CreateAlloca(type, nullptr, name);
+}
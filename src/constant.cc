@@ -0,0 +1,594 @@
+#include <cmath>
+#include <constant.hh>
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Support/Error.h>
+
+static const llvm::fltSemantics &getSemantics(const PrimitiveType *type)
+{
+    switch (type->bits)
+    {
+    case 32:
+        return llvm::APFloat::IEEEsingle();
+    case 64:
+        return llvm::APFloat::IEEEdouble();
+    case 80:
+        return llvm::APFloat::x87DoubleExtended();
+    default:
+        return llvm::APFloat::IEEEquad();
+    }
+}
+
+static ConstantValue makeBool(const TypeContext &types, bool value)
+{
+    return ConstantValue(types.getPrimitive("bool"), llvm::APSInt(llvm::APInt(1, value), true));
+}
+
+ConstantEvaluator::ConstantEvaluator(ASTContext &context, TypeContext &types, PrintGlobalState &print, FileID file)
+    : context(context), types(types), print(print), file(file), failed(false) {}
+
+void ConstantEvaluator::error(const std::string &message, const ASTNode *node)
+{
+    print.error(message, node->offset, file);
+    failed = true;
+}
+
+std::optional<ConstantValue> ConstantEvaluator::overflow(const PrimitiveType *type, const ASTNode *node)
+{
+    error("Constant expression overflows '" + type->name.str() + "'.", node);
+    return std::nullopt;
+}
+
+std::optional<ConstantValue> ConstantEvaluator::evaluate(const ExpressionNode *expression)
+{
+    // Without folding nothing is written, the expression is only read.
+    return compute(const_cast<ExpressionNode *>(expression), false);
+}
+
+bool ConstantEvaluator::fold(ProgramNode *program)
+{
+    failed = false;
+    for (DeclarationNode *declaration : program->declarations)
+    {
+        visit(declaration);
+    }
+    return !failed;
+}
+
+void ConstantEvaluator::visitFunctionDeclarationNode(FunctionDeclarationNode *function)
+{
+    visit(function->body);
+}
+
+void ConstantEvaluator::visitBlockNode(BlockNode *block)
+{
+    for (StatementNode *statement : block->statements)
+    {
+        visit(statement);
+    }
+}
+
+void ConstantEvaluator::visitIfStatementNode(IfStatementNode *statement)
+{
+    foldExpression(statement->condition);
+    visit(statement->then_block);
+    for (IfStatementNode *elif : statement->elif_statements)
+    {
+        visit(elif);
+    }
+    if (statement->else_block)
+    {
+        visit(statement->else_block);
+    }
+}
+
+void ConstantEvaluator::visitLoopStatementNode(LoopStatementNode *statement)
+{
+    visit(statement->body);
+}
+
+void ConstantEvaluator::visitVarDeclarationNode(VarDeclarationNode *declaration)
+{
+    if (declaration->initializer)
+    {
+        foldExpression(declaration->initializer);
+    }
+}
+
+void ConstantEvaluator::visitExpressionStatementNode(ExpressionStatementNode *statement)
+{
+    foldExpression(statement->expression);
+}
+
+void ConstantEvaluator::visitMatchStatementNode(MatchStatementNode *statement)
+{
+    foldExpression(statement->subject);
+    // Integer cases all have the type of the subject, so equal values are equal APInts.
+    llvm::DenseSet<llvm::APInt> values;
+    llvm::StringSet<> strings;
+    for (CaseClauseNode *clause : statement->cases)
+    {
+        // Already literals, only checked to fit their type and to be distinct.
+        const LiteralNode *literal = clause->literal;
+        if (literal->type == TokenType::TKL_STR)
+        {
+            if (!strings.insert(literal->value).second)
+            {
+                error("Duplicate case \"" + literal->value.str() + "\" in match statement.", literal);
+            }
+        }
+        else if (std::optional<ConstantValue> value = compute(clause->literal, false))
+        {
+            if (!values.insert(value->integer).second)
+            {
+                error("Duplicate case " + llvm::toString(value->integer, 10, value->type->is_signed) + " in match statement.", literal);
+            }
+        }
+        visit(clause->block);
+    }
+    if (statement->default_block)
+    {
+        visit(statement->default_block);
+    }
+}
+
+void ConstantEvaluator::visitRetStatementNode(RetStatementNode *statement)
+{
+    if (statement->value)
+    {
+        foldExpression(statement->value);
+    }
+}
+
+void ConstantEvaluator::foldExpression(ExpressionNode *&expression)
+{
+    std::optional<ConstantValue> value = compute(expression, true);
+    materialize(expression, value);
+}
+
+std::optional<ConstantValue> ConstantEvaluator::compute(ExpressionNode *expression, bool fold)
+{
+    if (!expression->value_type || !expression->value_type->isScalar())
+    {
+        return std::nullopt;
+    }
+    // Enums compute as the index of their field.
+    auto primitive = [&](const Type *type)
+    {
+        return llvm::isa<EnumType>(type) ? types.getPrimitive("i32") : llvm::cast<PrimitiveType>(type);
+    };
+
+    switch (expression->getKind())
+    {
+    case ASTNode::NODE_LITERAL:
+        return computeLiteral(llvm::cast<LiteralNode>(expression), false);
+    case ASTNode::NODE_UNARY_EXPR:
+    {
+        auto *unary = llvm::cast<UnaryExprNode>(expression);
+        if (unary->op == Operator::INCREMENT || unary->op == Operator::DECREMENT)
+        {
+            return std::nullopt;
+        }
+        // The magnitude of a negative literal may be out of range of its type, like 128 of -128 as i8.
+        auto *literal = llvm::dyn_cast<LiteralNode>(unary->operand);
+        if (unary->op == Operator::SUB && literal && literal->type == TokenType::TKL_INT && literal->value_type->isInteger())
+        {
+            return computeLiteral(literal, true);
+        }
+        std::optional<ConstantValue> operand = compute(unary->operand, fold);
+        if (!operand)
+        {
+            return std::nullopt;
+        }
+        return computeUnary(unary, *operand, primitive(unary->value_type));
+    }
+    case ASTNode::NODE_BINARY_EXPR:
+    {
+        auto *binary = llvm::cast<BinaryExprNode>(expression);
+        if (operator_info(binary->op).precedence == PREC_ASSIGN)
+        {
+            if (fold)
+            {
+                foldExpression(binary->right);
+            }
+            return std::nullopt;
+        }
+        std::optional<ConstantValue> left = compute(binary->left, fold);
+        // The right operand of && and || is not evaluated once the left one decides, whatever it would compute.
+        bool is_logical = binary->op == Operator::LOGICAL_AND || binary->op == Operator::LOGICAL_OR;
+        if (left && is_logical && isTrue(*left) == (binary->op == Operator::LOGICAL_OR))
+        {
+            return makeBool(types, isTrue(*left));
+        }
+        std::optional<ConstantValue> right = compute(binary->right, fold);
+        if (left && right)
+        {
+            return computeBinary(binary, *left, *right, primitive(binary->value_type));
+        }
+        if (fold)
+        {
+            materialize(binary->left, left);
+            materialize(binary->right, right);
+        }
+        return std::nullopt;
+    }
+    default:
+        return std::nullopt;
+    }
+}
+
+void ConstantEvaluator::materialize(ExpressionNode *&expression, std::optional<ConstantValue> &value)
+{
+    if (!value || llvm::isa<LiteralNode>(expression))
+    {
+        return;
+    }
+    llvm::SmallString<64> text;
+    TokenType token_type = TokenType::TKL_INT;
+    if (value->type->isFloat())
+    {
+        // Infinities and NaNs have no literal, and a literal must read back as exactly the same value.
+        if (!value->real.isFinite())
+        {
+            return;
+        }
+        value->real.toString(text);
+        llvm::APFloat parsed(value->real.getSemantics());
+        auto status = parsed.convertFromString(text, llvm::APFloat::rmNearestTiesToEven);
+        if (!status)
+        {
+            llvm::consumeError(status.takeError());
+            return;
+        }
+        if (!parsed.bitwiseIsEqual(value->real))
+        {
+            return;
+        }
+        token_type = TokenType::TKL_FLOAT;
+    }
+    else
+    {
+        // Written as its bits, which code generation reads back in the type of the literal.
+        static_cast<const llvm::APInt &>(value->integer).toString(text, 10, false);
+    }
+    auto *literal = context.create<LiteralNode>(context.save(text), token_type);
+    literal->offset = expression->offset;
+    literal->value_type = value->type;
+    expression = literal;
+}
+
+std::optional<ConstantValue> ConstantEvaluator::computeLiteral(const LiteralNode *literal, bool negated)
+{
+    auto *type = llvm::isa<EnumType>(literal->value_type) ? types.getPrimitive("i32") : llvm::cast<PrimitiveType>(literal->value_type);
+    switch (literal->type)
+    {
+    case TokenType::TKL_INT:
+        if (!type->isFloat())
+        {
+            llvm::APInt value;
+            if (literal->value.getAsInteger(0, value))
+            {
+                error("Invalid integer literal '" + literal->value.str() + "'.", literal);
+                return std::nullopt;
+            }
+            // Signed types reach one further below zero than above it.
+            unsigned active = value.getActiveBits();
+            bool fits;
+            if (!type->is_signed)
+            {
+                fits = negated ? active == 0 : active <= type->bits;
+            }
+            else
+            {
+                fits = active < type->bits || (negated && active == type->bits && value.isPowerOf2());
+            }
+            if (!fits)
+            {
+                error("Constant '" + std::string(negated ? "-" : "") + literal->value.str() + "' overflows '" + type->name.str() + "'.", literal);
+                return std::nullopt;
+            }
+            llvm::APInt bits = value.zextOrTrunc(type->bits);
+            if (negated)
+            {
+                bits.negate();
+            }
+            return ConstantValue(type, llvm::APSInt(bits, !type->is_signed));
+        }
+        // fall through
+    case TokenType::TKL_FLOAT:
+    {
+        llvm::APFloat value(getSemantics(type));
+        auto status = value.convertFromString(literal->value, llvm::APFloat::rmNearestTiesToEven);
+        if (!status)
+        {
+            llvm::consumeError(status.takeError());
+            error("Invalid floating point literal '" + literal->value.str() + "'.", literal);
+            return std::nullopt;
+        }
+        if (negated)
+        {
+            value.changeSign();
+        }
+        return ConstantValue(type, value);
+    }
+    case TokenType::TKL_CHAR:
+        return ConstantValue(type, llvm::APSInt(llvm::APInt(type->bits, literal->value.empty() ? 0 : static_cast<unsigned char>(literal->value[0])), !type->is_signed));
+    case TokenType::TK_KEYWORD:
+    {
+        // 'true' is 1 and 'false' and 'null' are 0, in whatever type the literal was given.
+        bool value = literal->value == "true";
+        if (type->isFloat())
+        {
+            return ConstantValue(type, llvm::APFloat(getSemantics(type), value));
+        }
+        return ConstantValue(type, llvm::APSInt(llvm::APInt(type->bits, value), !type->is_signed));
+    }
+    default:
+        return std::nullopt;
+    }
+}
+
+bool ConstantEvaluator::isTrue(const ConstantValue &value) const
+{
+    if (value.type->isFloat())
+    {
+        // NaN is true, as it is not equal to 0.
+        return !value.real.isZero();
+    }
+    return value.integer.getBoolValue();
+}
+
+std::optional<ConstantValue> ConstantEvaluator::convert(const ConstantValue &value, const PrimitiveType *type, const ASTNode *node)
+{
+    if (value.type == type)
+    {
+        return value;
+    }
+    if (type->isFloat())
+    {
+        llvm::APFloat real(getSemantics(type));
+        if (value.type->isFloat())
+        {
+            bool loses_info;
+            real = value.real;
+            real.convert(getSemantics(type), llvm::APFloat::rmNearestTiesToEven, &loses_info);
+        }
+        else
+        {
+            real.convertFromAPInt(value.integer, value.integer.isSigned(), llvm::APFloat::rmNearestTiesToEven);
+        }
+        return ConstantValue(type, real);
+    }
+    if (type->getKind() == Type::TYPE_BOOL)
+    {
+        return makeBool(types, isTrue(value));
+    }
+    if (!value.type->isFloat())
+    {
+        // Extended by the signedness of the value, truncated like code generation converts.
+        llvm::APSInt integer = value.integer.extOrTrunc(type->bits);
+        integer.setIsUnsigned(!type->is_signed);
+        return ConstantValue(type, integer);
+    }
+    llvm::APSInt integer(type->bits, !type->is_signed);
+    bool exact;
+    if (value.real.convertToInteger(integer, llvm::APFloat::rmTowardZero, &exact) & llvm::APFloat::opInvalidOp)
+    {
+        return overflow(type, node);
+    }
+    return ConstantValue(type, integer);
+}
+
+std::optional<ConstantValue> ConstantEvaluator::computeUnary(const UnaryExprNode *expression, const ConstantValue &operand, const PrimitiveType *type)
+{
+    switch (expression->op)
+    {
+    case Operator::NOT:
+        return makeBool(types, !isTrue(operand));
+    case Operator::ADD:
+        return operand;
+    case Operator::SUB:
+        if (operand.type->isFloat())
+        {
+            llvm::APFloat real = operand.real;
+            real.changeSign();
+            return ConstantValue(type, real);
+        }
+        if (operand.integer.isSigned() ? operand.integer.isMinSignedValue() : operand.integer.getBoolValue())
+        {
+            return overflow(type, expression);
+        }
+        return ConstantValue(type, -operand.integer);
+    case Operator::BIT_NOT:
+        return ConstantValue(type, ~operand.integer);
+    default:
+        return std::nullopt;
+    }
+}
+
+std::optional<ConstantValue> ConstantEvaluator::computeBinary(const BinaryExprNode *expression, const ConstantValue &left, const ConstantValue &right, const PrimitiveType *type)
+{
+    Operator op = expression->op;
+    const OperatorInfo &info = operator_info(op);
+    if (op == Operator::LOGICAL_AND || op == Operator::LOGICAL_OR)
+    {
+        bool value = op == Operator::LOGICAL_AND ? isTrue(left) && isTrue(right) : isTrue(left) || isTrue(right);
+        return makeBool(types, value);
+    }
+    // Comparisons compute in the type of their operands and produce a bool.
+    bool is_comparison = info.precedence == PREC_EQUALITY || info.precedence == PREC_RELATIONAL;
+    const PrimitiveType *operation = is_comparison ? types.getArithmeticType(left.type, right.type) : type;
+    std::optional<ConstantValue> lhs = convert(left, operation, expression);
+    std::optional<ConstantValue> rhs = convert(right, operation, expression);
+    if (!lhs || !rhs)
+    {
+        return std::nullopt;
+    }
+
+    if (operation->isFloat())
+    {
+        llvm::APFloat a = lhs->real;
+        const llvm::APFloat &b = rhs->real;
+        llvm::APFloat::cmpResult order = a.compare(b);
+        switch (op)
+        {
+        case Operator::EQUAL:
+            return makeBool(types, order == llvm::APFloat::cmpEqual);
+        case Operator::NOT_EQUAL:
+            return makeBool(types, order != llvm::APFloat::cmpEqual);
+        case Operator::LESS:
+            return makeBool(types, order == llvm::APFloat::cmpLessThan);
+        case Operator::GREATER:
+            return makeBool(types, order == llvm::APFloat::cmpGreaterThan);
+        case Operator::LESS_EQUAL:
+            return makeBool(types, order == llvm::APFloat::cmpLessThan || order == llvm::APFloat::cmpEqual);
+        case Operator::GREATER_EQUAL:
+            return makeBool(types, order == llvm::APFloat::cmpGreaterThan || order == llvm::APFloat::cmpEqual);
+        case Operator::ADD:
+            a.add(b, llvm::APFloat::rmNearestTiesToEven);
+            break;
+        case Operator::SUB:
+            a.subtract(b, llvm::APFloat::rmNearestTiesToEven);
+            break;
+        case Operator::MUL:
+            a.multiply(b, llvm::APFloat::rmNearestTiesToEven);
+            break;
+        case Operator::DIV:
+            a.divide(b, llvm::APFloat::rmNearestTiesToEven);
+            break;
+        case Operator::MOD:
+            a.mod(b);
+            break;
+        case Operator::POW:
+            // Only where the host computes it like the pow of the target's C library.
+            if (operation->bits == 32)
+            {
+                a = llvm::APFloat(std::pow(a.convertToFloat(), b.convertToFloat()));
+                break;
+            }
+            if (operation->bits == 64)
+            {
+                a = llvm::APFloat(std::pow(a.convertToDouble(), b.convertToDouble()));
+                break;
+            }
+            return std::nullopt;
+        default:
+            return std::nullopt;
+        }
+        return ConstantValue(operation, a);
+    }
+
+    const llvm::APSInt &a = lhs->integer;
+    const llvm::APSInt &b = rhs->integer;
+    bool is_signed = operation->is_signed;
+    bool overflowed = false;
+    llvm::APInt result;
+    switch (op)
+    {
+    case Operator::EQUAL:
+        return makeBool(types, a == b);
+    case Operator::NOT_EQUAL:
+        return makeBool(types, a != b);
+    case Operator::LESS:
+        return makeBool(types, a < b);
+    case Operator::GREATER:
+        return makeBool(types, a > b);
+    case Operator::LESS_EQUAL:
+        return makeBool(types, a <= b);
+    case Operator::GREATER_EQUAL:
+        return makeBool(types, a >= b);
+    case Operator::ADD:
+        result = is_signed ? a.sadd_ov(b, overflowed) : a.uadd_ov(b, overflowed);
+        break;
+    case Operator::SUB:
+        result = is_signed ? a.ssub_ov(b, overflowed) : a.usub_ov(b, overflowed);
+        break;
+    case Operator::MUL:
+        result = is_signed ? a.smul_ov(b, overflowed) : a.umul_ov(b, overflowed);
+        break;
+    case Operator::DIV:
+    case Operator::MOD:
+        if (!b.getBoolValue())
+        {
+            error("Division by zero in constant expression.", expression);
+            return std::nullopt;
+        }
+        if (op == Operator::DIV)
+        {
+            result = is_signed ? a.sdiv_ov(b, overflowed) : a.udiv(b);
+        }
+        else
+        {
+            // Undefined like the division it is computed with.
+            overflowed = is_signed && a.isMinSignedValue() && b == -1;
+            result = is_signed ? a.srem(b) : a.urem(b);
+        }
+        break;
+    case Operator::POW:
+        return computeIntegerPower(a, b, operation, expression);
+    case Operator::BIT_AND:
+        result = a & b;
+        break;
+    case Operator::BIT_OR:
+        result = a | b;
+        break;
+    case Operator::SHIFT_LEFT:
+    case Operator::SHIFT_RIGHT:
+        if ((is_signed && b.isNegative()) || b.uge(operation->bits))
+        {
+            error("Shift by " + llvm::toString(b, 10, is_signed) + " is out of range for '" + operation->name.str() + "'.", expression);
+            return std::nullopt;
+        }
+        if (op == Operator::SHIFT_LEFT)
+        {
+            result = is_signed ? a.sshl_ov(b, overflowed) : a.ushl_ov(b, overflowed);
+        }
+        else
+        {
+            result = is_signed ? a.ashr(b) : a.lshr(b);
+        }
+        break;
+    default:
+        return std::nullopt;
+    }
+    if (overflowed)
+    {
+        return overflow(operation, expression);
+    }
+    return ConstantValue(operation, llvm::APSInt(result, !is_signed));
+}
+
+std::optional<ConstantValue> ConstantEvaluator::computeIntegerPower(const llvm::APSInt &base, const llvm::APSInt &exponent, const PrimitiveType *type, const ASTNode *node)
+{
+    bool is_signed = type->is_signed;
+    if (is_signed && exponent.isNegative())
+    {
+        // A negative exponent truncates to 0 like division does, except for the powers of 1 and -1.
+        int64_t value = base == 1 ? 1 : base == -1 ? (exponent[0] ? -1 : 1) : 0;
+        return ConstantValue(type, llvm::APSInt(llvm::APInt(type->bits, value, true), false));
+    }
+    // Exponentiation by squaring, squares are only computed while they are still needed.
+    llvm::APInt result(type->bits, 1);
+    llvm::APInt square = base;
+    llvm::APInt bits = exponent;
+    bool overflowed = false;
+    while (bits.getBoolValue() && !overflowed)
+    {
+        if (bits[0])
+        {
+            result = is_signed ? result.smul_ov(square, overflowed) : result.umul_ov(square, overflowed);
+        }
+        bits.lshrInPlace(1);
+        if (bits.getBoolValue() && !overflowed)
+        {
+            square = is_signed ? square.smul_ov(square, overflowed) : square.umul_ov(square, overflowed);
+        }
+    }
+    if (overflowed)
+    {
+        return overflow(type, node);
+    }
+    return ConstantValue(type, llvm::APSInt(result, !is_signed));
+}
@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <thread>
+#include <ast_cache.hh>
+#include <backend.hh>
+#include <codegen.hh>
+#include <constant.hh>
+#include <driver.hh>
+#include <interner.hh>
+#include <jit.hh>
+#include <lexer.hh>
+#include <parser.hh>
+#include <print.hh>
+#include <sema.hh>
+#include <threadpool.hh>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/Path.h>
+
+// Files from this size on are parsed on several threads when there are threads to spare.
+static constexpr size_t PARALLEL_PARSE_BYTES = 1 << 20;
+
+Driver::Driver(const DriverOptions &options, std::ostream &diagnostics)
+    : options(options), diagnostics(diagnostics) {}
+
+int Driver::run(const std::vector<std::string> &files)
+{
+    // Buffered like the diagnostics of a file, the driver only reports before compiling or once every file is.
+    std::ostringstream messages;
+    PrintGlobalState print(sources);
+    print.setOutput(messages);
+    print.setFormat(options.diagnostics_format);
+    int result;
+    {
+        DiagnosticsWriter writer(diagnostics, options.diagnostics_format);
+        result = compileFiles(files, print, writer);
+        writer.write(messages.str());
+    }
+    if (report && options.time_report)
+    {
+        report->print(diagnostics);
+    }
+    return result;
+}
+
+int Driver::compileFiles(const std::vector<std::string> &files, PrintGlobalState &print, DiagnosticsWriter &writer)
+{
+    if (files.empty())
+    {
+        print.error("No input files.");
+        return 1;
+    }
+
+    // The table would follow the diagnostics on their stream, where it breaks a JSON or SARIF log.
+    if (options.time_report && options.diagnostics_format != DiagnosticFormat::TEXT)
+    {
+        print.error("-time-report needs text diagnostics, use -time-trace to time a compilation with JSON or SARIF diagnostics.");
+        return 1;
+    }
+
+    if (!options.ast_cache.empty())
+    {
+        cache = std::make_unique<ASTCache>(options.ast_cache);
+    }
+    if (options.time_report || !options.time_trace.empty())
+    {
+        report = std::make_unique<TimeReport>();
+    }
+
+    // Loading mutates the SourceManager, so it happens before any job reads it.
+    std::vector<std::unique_ptr<CompilationUnit>> units;
+    for (const std::string &file_name : files)
+    {
+        TimeReport::Scope timer(report.get(), TimeReport::READ, file_name);
+        auto file = sources.loadFile(file_name);
+        if (!file)
+        {
+            print.error("File '" + file_name + "' not found !!!");
+            continue;
+        }
+        units.push_back(std::make_unique<CompilationUnit>());
+        units.back()->file = *file;
+        llvm::SmallString<128> output(llvm::sys::path::filename(file_name));
+        llvm::sys::path::replace_extension(output, output_extension(options.stage));
+        units.back()->output = options.output.empty() ? std::string(output) : options.output;
+    }
+    if (print.hasEncounteredError())
+    {
+        return 127;
+    }
+    if (options.stage == R && !options.march.empty())
+    {
+        print.error("Programs can only be run for the host architecture.");
+        return 1;
+    }
+    if (options.stage != C)
+    {
+        if (options.stage != R && !options.output.empty() && units.size() > 1)
+        {
+            print.error("Cannot write the output of several input files to '" + options.output + "'.");
+            return 1;
+        }
+        // Checked once here instead of once per file.
+        std::string error;
+        if (!create_target_machine(options.march, options.optimization, error))
+        {
+            print.error(error);
+            return 1;
+        }
+    }
+
+    int result = execute(units, print, writer);
+    std::string error;
+    if (report && !options.time_trace.empty() && !report->writeTrace(options.time_trace, error))
+    {
+        print.error(error);
+        return 1;
+    }
+    return result;
+}
+
+// Compile the loaded files on the pool, then run the program for the R stage.
+int Driver::execute(std::vector<std::unique_ptr<CompilationUnit>> &units, PrintGlobalState &print, DiagnosticsWriter &writer)
+{
+    {
+        // Threads beyond one per file are only useful to parse large files, they stay idle otherwise.
+        unsigned threads = std::max(1u, options.jobs ? options.jobs : std::thread::hardware_concurrency());
+        ThreadPool files(threads);
+        pool = &files;
+        for (size_t i = 0; i < units.size(); i++)
+        {
+            files.submit([&, i]()
+                         {
+                // Written as soon as every file before it is.
+                compile(*units[i]);
+                writer.write(i, units[i]->diagnostics.str());
+                units[i]->diagnostics = std::ostringstream(); });
+        }
+        files.wait();
+        pool = nullptr;
+    }
+    // Every file is written, and the diagnostics should come before what the program prints.
+    diagnostics.flush();
+    bool failed = std::any_of(units.begin(), units.end(), [](const std::unique_ptr<CompilationUnit> &unit)
+                              { return unit->failed; });
+    if (failed || options.stage != R)
+    {
+        return failed ? 1 : 0;
+    }
+
+    std::vector<llvm::orc::ThreadSafeModule> modules;
+    for (auto &unit : units)
+    {
+        modules.push_back(std::move(unit->module));
+    }
+    int exit_code;
+    std::string error;
+    TimeReport::Scope timer(report.get(), TimeReport::RUN, "main");
+    if (!run_main(std::move(modules), options.optimization, exit_code, error))
+    {
+        print.error(error);
+        return 1;
+    }
+    return exit_code;
+}
+
+ProgramNode *Driver::parse(CompilationUnit &unit, ASTContext &context, StringInterner &names, PrintGlobalState &print)
+{
+    llvm::StringRef file_name = sources.getFileName(unit.file);
+    Lexer lexer(sources, unit.file, names, print);
+    ProgramNode *program;
+    if (pool && pool->size() > 1 && sources.getBuffer(unit.file).size() >= PARALLEL_PARSE_BYTES)
+    {
+        // Threads the other files leave idle parse the declarations of a large file in parallel,
+        // which needs all of its tokens up front.
+        const std::vector<Token> *tokens;
+        {
+            TimeReport::Scope timer(report.get(), TimeReport::LEX, file_name);
+            tokens = &lexer.lex();
+        }
+        TimeReport::Scope timer(report.get(), TimeReport::PARSE, file_name);
+        Parser parser(*tokens, context, unit.file, print);
+        program = parser.parse(*pool);
+        if (report)
+        {
+            report->count(TimeReport::LEX, parser.token_count());
+            report->count(TimeReport::PARSE, context.getNodeCount());
+        }
+        return program;
+    }
+
+    // The parser pulls its tokens from the lexer, so lexing and parsing are timed together
+    // and the tokens of the file are never held all at once.
+    Parser parser(lexer, context, unit.file, print);
+    {
+        TimeReport::Scope timer(report.get(), TimeReport::LEX_PARSE, file_name);
+        program = parser.parse();
+    }
+    if (report)
+    {
+        report->count(TimeReport::LEX_PARSE, parser.token_count(), context.getNodeCount());
+    }
+    return program;
+}
+
+void Driver::compile(CompilationUnit &unit)
+{
+    PrintGlobalState print(sources);
+    print.setOutput(unit.diagnostics);
+    print.setFormat(options.diagnostics_format);
+
+    llvm::StringRef file_name = sources.getFileName(unit.file);
+    llvm::StringRef source = sources.getBuffer(unit.file);
+    StringInterner names;
+    ASTContext context;
+    TypeContext types; // Expressions refer to their types as long as the tree lives.
+    ProgramNode *program = nullptr;
+    if (cache)
+    {
+        TimeReport::Scope timer(report.get(), TimeReport::CACHE, file_name);
+        program = cache->load(source, context, names);
+        if (program && report)
+        {
+            report->count(TimeReport::CACHE, context.getNodeCount());
+        }
+    }
+    if (!program)
+    {
+        program = parse(unit, context, names, print);
+        // Files with errors are not cached, so their errors are reported again next time.
+        std::string error;
+        if (cache && !print.hasEncounteredError())
+        {
+            TimeReport::Scope timer(report.get(), TimeReport::CACHE, file_name);
+            if (!cache->store(source, program, names, error))
+            {
+                print.warn(error);
+            }
+        }
+    }
+    if (!print.hasEncounteredError())
+    {
+        SemanticAnalyzer analyzer(types, names, print);
+        TimeReport::Scope timer(report.get(), TimeReport::ANALYSIS, file_name);
+        // Constants are folded in the frontend, which keeps them out of the IR handed to LLVM.
+        if (analyzer.analyze(program, unit.file))
+        {
+            ConstantEvaluator(context, types, print, unit.file).fold(program);
+        }
+        if (report)
+        {
+            report->count(TimeReport::ANALYSIS, context.getNodeCount());
+        }
+    }
+    if (options.stage == C || print.hasEncounteredError())
+    {
+        unit.failed = print.hasEncounteredError();
+        return;
+    }
+
+    // Every file has its own LLVM context and target machine, neither may be shared between threads.
+    auto llvm_context = std::make_unique<llvm::LLVMContext>();
+    std::string error;
+    std::unique_ptr<llvm::TargetMachine> target = create_target_machine(options.march, options.optimization, error);
+    if (!target)
+    {
+        print.error(error);
+        unit.failed = true;
+        return;
+    }
+    CodeGenerator generator(*llvm_context, names, print);
+    std::unique_ptr<llvm::Module> module;
+    {
+        TimeReport::Scope timer(report.get(), TimeReport::CODEGEN, file_name);
+        module = generator.generate(program, unit.file, file_name, *target);
+    }
+    if (module)
+    {
+        {
+            TimeReport::Scope timer(report.get(), TimeReport::OPTIMIZE, file_name);
+            optimize_module(*module, *target, options.optimization);
+        }
+        if (options.stage == R)
+        {
+            unit.module = llvm::orc::ThreadSafeModule(std::move(module), std::move(llvm_context));
+        }
+        else
+        {
+            TimeReport::Scope timer(report.get(), TimeReport::EMIT, file_name);
+            if (!emit_module(*module, *target, options.stage, unit.output, error))
+            {
+                print.error(error);
+            }
+        }
+    }
+    unit.failed = print.hasEncounteredError();
+}
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cstdint>
+#include <incremental.hh>
+#include <lexer.hh>
+#include <parser.hh>
+
+// Replace `items[first, last)` by `replacement`, moving the following items only if the sizes differ.
+template <typename T>
+static void splice(std::vector<T> &items, size_t first, size_t last, const std::vector<T> &replacement)
+{
+    size_t common = std::min(last - first, replacement.size());
+    std::copy(replacement.begin(), replacement.begin() + common, items.begin() + first);
+    if (common < replacement.size())
+    {
+        items.insert(items.begin() + first + common, replacement.begin() + common, replacement.end());
+    }
+    else
+    {
+        items.erase(items.begin() + first + common, items.begin() + last);
+    }
+}
+
+IncrementalSession::IncrementalSession(SourceManager &sources, FileID file, StringInterner &names, PrintGlobalState &print)
+    : sources(sources), file(file), names(names), print(print), parsed_bytes(0), program(nullptr), literals(literal_storage), stats{0, 0}
+{
+}
+
+ProgramNode *IncrementalSession::parse()
+{
+    literal_storage = llvm::BumpPtrAllocator();
+    Lexer lexer(sources, file, names, print);
+    tokens = lexer.lex();
+    keepLiterals(tokens.begin(), tokens.end());
+
+    context = std::make_unique<ASTContext>();
+    program = context->create<ProgramNode>(llvm::ArrayRef<DeclarationNode *>());
+    top_levels.clear();
+    size_t parsed = reparse(0, tokens.size(), tokens.size());
+    parsed_bytes = context->getBytesAllocated();
+
+    stats = {tokens.size(), parsed};
+    return program;
+}
+
+ProgramNode *IncrementalSession::applyEdit(const TextEdit &edit)
+{
+    int_t begin, old_end, new_end;
+    relex(edit, begin, old_end, new_end);
+    size_t relexed = new_end - begin;
+
+    // Replaced declarations stay in the arena, start over once they outweigh the live tree.
+    size_t live_bytes = std::max<size_t>(parsed_bytes, 1 << 16);
+    if (context->getBytesAllocated() > 2 * live_bytes)
+    {
+        return parse();
+    }
+
+    size_t reparsed = reparse(begin, old_end, new_end);
+    stats = {relexed, reparsed};
+    return program;
+}
+
+void IncrementalSession::relex(const TextEdit &edit, int_t &begin, int_t &old_end, int_t &new_end)
+{
+    llvm::StringRef old_buffer = sources.getBuffer(file);
+    uintptr_t old_start = reinterpret_cast<uintptr_t>(old_buffer.data());
+    uintptr_t old_stop = old_start + old_buffer.size();
+    int_t removed_lines = std::count(old_buffer.begin() + edit.offset, old_buffer.begin() + edit.offset + edit.length, '\n');
+    int_t added_lines = std::count(edit.text.begin(), edit.text.end(), '\n');
+
+    sources.applyEdit(file, edit);
+    llvm::StringRef buffer = sources.getBuffer(file);
+
+    // Tokens before the one preceding the edit cannot change, their lexing never looked past its start.
+    auto by_offset = [](const Token &token, int_t offset)
+    { return token.col < offset; };
+    int_t following = std::lower_bound(tokens.begin(), tokens.end(), edit.offset, by_offset) - tokens.begin();
+    begin = following > 0 ? following - 1 : 0;
+
+    Lexer lexer(sources, file, names, print);
+    if (following > 0)
+    {
+        lexer.seek(tokens[begin].col, tokens[begin].line);
+    }
+
+    // Lex until reaching an offset behind the edit a previous token started at,
+    // from there on lexing continues exactly as it did before.
+    int_t until = edit.offset + edit.text.size();
+    while (true)
+    {
+        int_t offset = lexer.lexUntil(until);
+        if (offset >= buffer.size())
+        {
+            old_end = tokens.size();
+            break;
+        }
+        int_t old_offset = offset - edit.text.size() + edit.length;
+        auto next = std::lower_bound(tokens.begin() + following, tokens.end(), old_offset, by_offset);
+        if (next != tokens.end() && next->col == old_offset)
+        {
+            old_end = next - tokens.begin();
+            break;
+        }
+        until = next != tokens.end() ? next->col - edit.length + edit.text.size() : buffer.size();
+    }
+
+    // Point the kept tokens into the new buffer, moving the ones behind the edit.
+    auto rebase = [&](int_t first, int_t last, bool behind)
+    {
+        int_t removed = behind ? edit.length : 0, added = behind ? edit.text.size() : 0;
+        for (int_t i = first; i < last; i++)
+        {
+            Token &token = tokens[i];
+            uintptr_t lexeme = reinterpret_cast<uintptr_t>(token.lexeme.data());
+            if (lexeme >= old_start && lexeme <= old_stop)
+            {
+                size_t offset = lexeme - old_start - removed + added;
+                token.lexeme = std::string_view(buffer.data() + offset, token.lexeme.size());
+            }
+            if (behind)
+            {
+                token.col = token.col - removed + added;
+                token.line = token.line - removed_lines + added_lines;
+            }
+        }
+    };
+    rebase(0, begin, false);
+    rebase(old_end, tokens.size(), true);
+
+    const std::vector<Token> &relexed = lexer.getTokens();
+    splice(tokens, begin, old_end, relexed);
+    keepLiterals(tokens.begin() + begin, tokens.begin() + begin + relexed.size());
+    new_end = begin + relexed.size();
+}
+
+size_t IncrementalSession::reparse(int_t begin, int_t old_end, int_t new_end)
+{
+    // A declaration ending right before the changed tokens is parsed again as well,
+    // in case the changes continue it.
+    auto first = std::lower_bound(top_levels.begin(), top_levels.end(), begin, [](const TopLevel &top_level, int_t index)
+                                  { return top_level.last < index; });
+    int_t position = first != top_levels.end() ? first->first : 0;
+
+    Parser parser(tokens, *context, file, print);
+    std::vector<TopLevel> reparsed;
+    auto resync = top_levels.end();
+    while (position < tokens.size() && tokens[position].type != TokenType::__EOF)
+    {
+        // Past the changes, parsing continues exactly as before once a previous declaration starts here.
+        if (position >= new_end)
+        {
+            int_t old_position = position - new_end + old_end;
+            auto next = std::lower_bound(first, top_levels.end(), old_position, [](const TopLevel &top_level, int_t index)
+                                         { return top_level.first < index; });
+            if (next != top_levels.end() && next->first == old_position)
+            {
+                resync = next;
+                break;
+            }
+        }
+        int_t start = position;
+        DeclarationNode *declaration = parser.parse_declaration_at(position);
+        reparsed.push_back(TopLevel{declaration, start, position});
+    }
+
+    for (auto it = resync; it != top_levels.end(); ++it)
+    {
+        it->first = it->first - old_end + new_end;
+        it->last = it->last - old_end + new_end;
+    }
+    splice(top_levels, first - top_levels.begin(), resync - top_levels.begin(), reparsed);
+
+    declarations.clear();
+    for (const TopLevel &top_level : top_levels)
+    {
+        if (top_level.declaration)
+        {
+            declarations.push_back(top_level.declaration);
+        }
+    }
+    program->declarations = declarations;
+    return reparsed.size();
+}
+
+void IncrementalSession::keepLiterals(std::vector<Token>::iterator first, std::vector<Token>::iterator last)
+{
+    // Decoded literals live in the lexer, which is gone after lexing.
+    llvm::StringRef buffer = sources.getBuffer(file);
+    uintptr_t start = reinterpret_cast<uintptr_t>(buffer.data());
+    for (auto it = first; it != last; ++it)
+    {
+        uintptr_t lexeme = reinterpret_cast<uintptr_t>(it->lexeme.data());
+        if (it->lexeme.data() && (lexeme < start || lexeme > start + buffer.size()))
+        {
+            llvm::StringRef saved = literals.save(llvm::StringRef(it->lexeme.data(), it->lexeme.size()));
+            it->lexeme = std::string_view(saved.data(), saved.size());
+        }
+    }
+}
+
+const std::vector<Token> &IncrementalSession::getTokens() const
+{
+    return tokens;
+}
+
+ProgramNode *IncrementalSession::getProgram() const
+{
+    return program;
+}
+
+const IncrementalSession::EditStats &IncrementalSession::getLastEditStats() const
+{
+    return stats;
+}
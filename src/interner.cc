@@ -0,0 +1,17 @@
+#include <interner.hh>
+
+StringInterner::StringInterner()
+{
+    intern("");
+}
+
+NameID StringInterner::intern(llvm::StringRef str)
+{
+    auto inserted = ids.try_emplace(str, static_cast<NameID>(names.size()));
+    if (inserted.second)
+    {
+        // Map entries never move, the key can be referenced directly.
+        names.push_back(inserted.first->getKey());
+    }
+    return inserted.first->second;
+}
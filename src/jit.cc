@@ -0,0 +1,100 @@
+#include <jit.hh>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/Support/TargetSelect.h>
+
+bool run_main(std::vector<llvm::orc::ThreadSafeModule> modules, OptimizationLevel level, int &exit_code, std::string &error)
+{
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    // main is looked up by its type before the modules are handed over.
+    llvm::FunctionType *main_type = nullptr;
+    for (auto &module : modules)
+    {
+        module.withModuleDo([&](llvm::Module &m)
+                            {
+            if (llvm::Function *function = m.getFunction("main"))
+            {
+                main_type = function->getFunctionType();
+            } });
+    }
+    if (!main_type)
+    {
+        error = "No main function to run.";
+        return false;
+    }
+    llvm::Type *return_type = main_type->getReturnType();
+    if (main_type->getNumParams() != 0 || !(return_type->isVoidTy() || (return_type->isIntegerTy() && return_type->getIntegerBitWidth() <= 64)))
+    {
+        error = "main must not take parameters and must return an integer or nothing to be run.";
+        return false;
+    }
+    unsigned width = return_type->isVoidTy() ? 0 : return_type->getIntegerBitWidth();
+
+    auto target = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!target)
+    {
+        error = llvm::toString(target.takeError());
+        return false;
+    }
+    target->setCodeGenOptLevel(level == O1 ? llvm::CodeGenOpt::Less : level == O2 ? llvm::CodeGenOpt::Default
+                                                                    : level == O3   ? llvm::CodeGenOpt::Aggressive
+                                                                                    : llvm::CodeGenOpt::None);
+    auto jit = llvm::orc::LLLazyJITBuilder().setJITTargetMachineBuilder(std::move(*target)).create();
+    if (!jit)
+    {
+        error = llvm::toString(jit.takeError());
+        return false;
+    }
+
+    // Programs may call into the C library and anything else the compiler is linked against.
+    auto process = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess((*jit)->getDataLayout().getGlobalPrefix());
+    if (!process)
+    {
+        error = llvm::toString(process.takeError());
+        return false;
+    }
+    (*jit)->getMainJITDylib().addGenerator(std::move(*process));
+
+    for (auto &module : modules)
+    {
+        if (llvm::Error failure = (*jit)->addLazyIRModule(std::move(module)))
+        {
+            error = llvm::toString(std::move(failure));
+            return false;
+        }
+    }
+    auto main = (*jit)->lookup("main");
+    if (!main)
+    {
+        error = llvm::toString(main.takeError());
+        return false;
+    }
+
+    // Called through a pointer of the exact return type, the upper bits of a narrower one are undefined.
+    switch (width)
+    {
+    case 0:
+        main->toPtr<void (*)()>()();
+        exit_code = 0;
+        break;
+    case 1:
+        exit_code = main->toPtr<bool (*)()>()();
+        break;
+    case 8:
+        exit_code = main->toPtr<int8_t (*)()>()();
+        break;
+    case 16:
+        exit_code = main->toPtr<int16_t (*)()>()();
+        break;
+    case 32:
+        exit_code = main->toPtr<int32_t (*)()>()();
+        break;
+    default:
+        exit_code = static_cast<int>(main->toPtr<int64_t (*)()>()());
+        break;
+    }
+    return true;
+}
@@ -1,14 +1,17 @@
 #include <array>
 #include <algorithm>
+#include <charconv>
 #include <memory>
 #include <optional>
 #include <string_view>
 #include <definitions.hh>
 #include <lexer.hh>
+#include <scan.hh>
 #include <version.hh>
+#include <llvm/ADT/APInt.h>
 
-Lexer::Lexer(const std::string &file, const std::string &file_name, PrintGlobalState &print)
-    : line(1), col(0), file_name(file_name), print(print), file(file)
+Lexer::Lexer(const SourceManager &sources, FileID file, StringInterner &names, PrintGlobalState &print)
+    : line(1), col(0), file(sources.getBuffer(file)), file_id(file), names(names), print(print), scan(get_scan_kernels()), literals(literal_storage)
 {
 }
 
@@ -17,58 +20,112 @@ llvm::StringRef Lexer::getFile()
     return this->file;
 }
 
-std::vector<Token> Lexer::lex()
+inline void Lexer::lexToken()
 {
-    while (col < file.length())
+    char c = current();
+    uint8_t cls = CHAR_CLASSES[static_cast<unsigned char>(c)];
+    if (cls & CC_IDENT_START)
     {
-        char c = current();
-        if (isalpha(c) || c == '_')
-        {
-            keywordOrDatatypeOrIdentifier();
-        }
-        else if (isdigit(c))
-        {
-            number();
-        }
-        else if (isSeperator(c))
-        {
-            tokens.emplace_back(TokenType::TK_SEPARATOR, line, col, std::string(1, current()));
-            advance();
-        }
-        else if (isOperator(c))
-        {
-            handleOperator();
-        }
-        else if (isspace(c))
-        {
-            if (c == '\n')
-            {
-                line++;
-            }
-            advance();
-        }
-        else if (c == '"')
-        {
-            handleStringLiteral();
-        }
-        else if (c == '\'')
-        {
-            handleCharLiteral();
-        }
-        else
+        keywordOrDatatypeOrIdentifier();
+    }
+    else if (cls & CC_DIGIT)
+    {
+        number();
+    }
+    else if (cls & CC_SEPARATOR)
+    {
+        tokens.emplace_back(classify_separator(c), line, col, slice(col, 1));
+        advance();
+    }
+    else if (cls & CC_OPERATOR)
+    {
+        handleOperator();
+    }
+    else if (cls & CC_SPACE)
+    {
+        // Most whitespace is a single character between two tokens.
+        if (!has_char_class(peek(), CC_SPACE))
         {
-            print.error("Unexpected character found.", line, col + 1, file);
-            tokens.emplace_back(TokenType::TK_SEPARATOR, line, col, std::string(1, current()));
+            line += c == '\n';
             advance();
+            return;
         }
+        size_t newlines = 0;
+        col = scan.skip_whitespace(file.data() + col, end(), newlines) - file.data();
+        line += newlines;
     }
-    tokens.emplace_back(TokenType::__EOF, line, col, "");
+    else if (c == '"')
+    {
+        handleStringLiteral();
+    }
+    else if (c == '\'')
+    {
+        handleCharLiteral();
+    }
+    else
+    {
+        print.error("Unexpected character found.", col, file_id);
+        tokens.emplace_back(TokenType::TK_SEPARATOR, line, col, slice(col, 1));
+        advance();
+    }
+}
+
+const std::vector<Token> &Lexer::lex()
+{
+    // Tokens are rarely shorter than 4 characters on average. Reserving up front
+    // avoids copying the vector while it grows, pages which are never written
+    // to are never backed by memory.
+    tokens.reserve(file.size() / 4 + 1);
+    while (col < file.size())
+    {
+        lexToken();
+    }
+    tokens.emplace_back(TokenType::__EOF, line, col, std::string_view());
+    return tokens;
+}
+
+Token Lexer::next()
+{
+    // Every call to lexToken() adds at most one token, whitespace and comments add none.
+    tokens.clear();
+    while (tokens.empty() && col < file.size())
+    {
+        lexToken();
+    }
+    if (tokens.empty())
+    {
+        return Token(TokenType::__EOF, line, col, std::string_view());
+    }
+    return tokens.back();
+}
+
+void Lexer::seek(size_t offset, size_t line)
+{
+    this->col = offset;
+    this->line = line;
+}
+
+size_t Lexer::lexUntil(size_t until)
+{
+    while (col < until && col < file.size())
+    {
+        lexToken();
+    }
+    if (col >= file.size() && (tokens.empty() || tokens.back().type != TokenType::__EOF))
+    {
+        tokens.emplace_back(TokenType::__EOF, line, col, std::string_view());
+    }
+    return col;
+}
+
+const std::vector<Token> &Lexer::getTokens() const
+{
     return tokens;
 }
 
 inline char Lexer::current() const
 {
-    return file[col];
+    return file.data()[col]; // The buffer is null terminated.
 }
 
 inline char Lexer::peek() const
@@ -78,7 +135,7 @@ inline char Lexer::peek() const
 
 inline char Lexer::previous() const
 {
-    return file.at(col - 1);
+    return file.data()[col - 1];
 }
 
 inline void Lexer::advance()
@@ -86,77 +143,82 @@ inline void Lexer::advance()
     col++;
 }
 
+inline const char *Lexer::end() const
+{
+    return file.data() + file.size();
+}
+
+inline std::string_view Lexer::slice(size_t start, size_t length) const
+{
+    return std::string_view(file.data() + start, length);
+}
+
 void Lexer::keywordOrDatatypeOrIdentifier()
 {
-    std::string str;
-    while (isalnum(current()) || current() == '_')
-    {
-        str.push_back(current());
-        advance();
-    }
+    size_t start = col;
+    col = scan.scan_identifier(file.data() + col, end()) - file.data();
+    std::string_view str = slice(start, col - start);
 
-    if (auto dt = find_dt(str); dt)
-    {
-        tokens.emplace_back(TokenType::TK_DATATYPE, line, col - str.length(), str);
-    }
-    else if (auto keyword = find_keyword(str); keyword)
-    {
-        tokens.emplace_back(TokenType::TK_KEYWORD, line, col - str.length(), str);
-    }
-    else if (auto arch_dt = find_archdt(str); arch_dt)
-    {
-        print.error("Found '" + str + "' which is not supported for " + _ARCH + ".", line, col - str.length(), file);
-        tokens.emplace_back(TokenType::TK_KEYWORD, line, col - str.length(), str); // It can be parsed and checked so add it
-    }
-    else
+    WordInfo info = classify_word(str);
+    switch (info.word_class)
     {
-        tokens.emplace_back(TokenType::TK_ID, line, col - str.length(), str);
+    case WordClass::DATATYPE:
+        tokens.emplace_back(TokenType::TK_DATATYPE, line, start, str);
+        break;
+    case WordClass::KEYWORD:
+        tokens.emplace_back(static_cast<Keyword>(info.index + 1), line, start, str);
+        break;
+    case WordClass::ARCH_DATATYPE:
+        print.error("Found '" + std::string(str) + "' which is not supported for " + _ARCH + ".", start, file_id);
+        tokens.emplace_back(TokenType::TK_KEYWORD, line, start, str); // It can be parsed and checked so add it
+        break;
+    case WordClass::IDENTIFIER:
+        tokens.emplace_back(TokenType::TK_ID, line, start, str, names.intern(str));
+        break;
     }
 }
 
 void Lexer::number()
 {
-    std::string str;
-    while (isdigit(current()) || current() == '.' || current() == 'x' || current() == 'e' || current() == 'E' || current() == '+' || current() == '-')
-    {
-        str.push_back(current());
-        advance();
-    }
+    size_t start = col;
+    col = scan.scan_number(file.data() + col, end()) - file.data();
+    std::string_view str = slice(start, col - start);
 
-    try
+    // Only validate the number here, the value is computed by later stages.
+    if (str.find('.') != std::string_view::npos || str.find('e') != std::string_view::npos || str.find('E') != std::string_view::npos)
     {
-        if (str.find('.') != std::string::npos || str.find('e') != std::string::npos || str.find('E') != std::string::npos)
-        {
-            std::stod(str);
-            tokens.emplace_back(TokenType::TKL_FLOAT, line, col - str.length(), str);
-        }
-        else
+        double value;
+        if (std::from_chars(str.data(), str.data() + str.size(), value).ec == std::errc())
         {
-            std::stoll(str);
-            tokens.emplace_back(TokenType::TKL_INT, line, col - str.length(), str);
+            tokens.emplace_back(TokenType::TKL_FLOAT, line, start, str);
+            return;
         }
     }
-    catch (const std::exception &)
+    else
     {
-        print.error("Invalid number format.", line, col - str.length(), file);
+        // Of any size, whether it fits is up to the type the constant evaluator gives it.
+        llvm::APInt value;
+        if (!llvm::StringRef(str.data(), str.size()).getAsInteger(0, value))
+        {
+            tokens.emplace_back(TokenType::TKL_INT, line, start, str);
+            return;
+        }
     }
+    print.error("Invalid number format.", start, file_id);
 }
 
 bool Lexer::isSeperator(char c) const
 {
-    constexpr std::array<char, 8> SEPARATORS = {';', ',', '{', '}', '[', ']', '(', ')'};
-    return std::find(SEPARATORS.begin(), SEPARATORS.end(), c) != SEPARATORS.end();
+    return has_char_class(c, CC_SEPARATOR);
 }
 
 bool Lexer::isOperator(char c) const
 {
-    constexpr std::array<char, 12> OPERATORS = {'>', '<', '=', '!', '^', '|', '&', '+', '-', '*', '/', '%'};
-    return std::find(OPERATORS.begin(), OPERATORS.end(), c) != OPERATORS.end();
+    return has_char_class(c, CC_OPERATOR);
 }
 
 void Lexer::handleOperator()
 {
-    std::string op;
     if (current() == '/' && (peek() == '/' || peek() == '*'))
     {
         handleComment();
@@ -164,38 +226,51 @@ void Lexer::handleOperator()
     }
     else
     {
-        op.push_back(current());
+        size_t start = col;
 
-        if ((current() == '>' && peek() == '>') || (current() == '<' && peek() == '<') || peek() == '=' || (current() == '&' && peek() == '&') || (current() == '|' && peek() == '|') || (current() == '+' && peek() == '+') || (current() == '-' && peek() == '-'))
+        if ((current() == '>' && peek() == '>') || (current() == '<' && peek() == '<') || peek() == '=' || (current() == '&' && peek() == '&') || (current() == '|' && peek() == '|') || (current() == '+' && peek() == '+') || (current() == '-' && peek() == '-') || (current() == '-' && peek() == '>'))
         {
-            op.push_back(peek());
             advance();
         }
-        tokens.emplace_back(TokenType::TK_OPERATOR, line, col, op);
         advance();
+        std::string_view str = slice(start, col - start);
+        tokens.emplace_back(classify_operator(str), line, start, str);
     }
 }
 
 void Lexer::handleStringLiteral()
 {
+    size_t start = col;
     advance();
-    std::string str;
 
-    while (current() != '"' && current() != '\0')
+    // Literals without escape sequences are referenced directly from the file.
+    col = scan.find_string_end(file.data() + col, end()) - file.data();
+    if (current() != '\\')
+    {
+        std::string_view str = slice(start + 1, col - start - 1);
+        if (col < file.size())
+        {
+            advance();
+        }
+        tokens.emplace_back(TokenType::TKL_STR, line, start, str);
+        line += std::count(str.begin(), str.end(), '\n');
+        return;
+    }
+
+    std::string str(slice(start + 1, col - start - 1));
+    while (col < file.size() && current() != '"')
     {
         if (current() == '\\')
         {
             advance();
+            if (col >= file.size())
+            {
+                break;
+            }
             if (current() == 'u')
             {
                 advance();
-                std::string unicode_seq;
-                for (int i = 0; i < 4; ++i)
-                {
-                    unicode_seq.push_back(current());
-                    advance();
-                }
-                str.push_back(static_cast<char>(std::stoi(unicode_seq, nullptr, 16)));
+                str.push_back(unicodeEscape());
             }
             else
             {
@@ -209,57 +284,80 @@ void Lexer::handleStringLiteral()
             advance();
         }
     }
-    advance();
-    tokens.emplace_back(TokenType::TKL_STR, line, col - str.length(), str);
+    if (col < file.size())
+    {
+        advance();
+    }
+    llvm::StringRef saved = literals.save(str);
+    tokens.emplace_back(TokenType::TKL_STR, line, start, std::string_view(saved.data(), saved.size()));
+    line += std::count(file.begin() + start, file.begin() + col, '\n');
 }
 
 void Lexer::handleCharLiteral()
 {
+    size_t start = col;
     advance();
-    if (current() == '\\')
+    if (col >= file.size())
+    {
+        tokens.emplace_back(TokenType::TKL_CHAR, line, start, std::string_view());
+        return;
+    }
+    if (current() == '\\' && col + 1 < file.size())
     {
         advance();
-        std::string escape_seq;
         if (current() == 'u')
         {
             advance();
-            for (int i = 0; i < 4; ++i)
-            {
-                escape_seq.push_back(current());
-                advance();
-            }
-            tokens.emplace_back(TokenType::TKL_CHAR, line, col - 6, static_cast<char>(std::stoi(escape_seq, nullptr, 16)));
+            char c = unicodeEscape();
+            llvm::StringRef saved = literals.save(llvm::StringRef(&c, 1));
+            tokens.emplace_back(TokenType::TKL_CHAR, line, start, std::string_view(saved.data(), saved.size()));
         }
         else
         {
-            escape_seq.push_back(current());
-            tokens.emplace_back(TokenType::TKL_CHAR, line, col - 3, escape_seq[0]);
+            tokens.emplace_back(TokenType::TKL_CHAR, line, start, slice(col, 1));
+            line += current() == '\n';
             advance();
         }
     }
     else
     {
-        char c = current();
+        tokens.emplace_back(TokenType::TKL_CHAR, line, start, slice(col, 1));
+        line += current() == '\n';
         advance();
-        tokens.emplace_back(TokenType::TKL_CHAR, line, col - 2, c);
     }
+    if (current() == '\'')
+    {
+        advance();
+    }
+}
+
+char Lexer::unicodeEscape()
+{
+    unsigned value = 0;
+    const char *digits = file.data() + col;
+    auto result = std::from_chars(digits, std::min(digits + 4, end()), value, 16);
+    if (result.ec != std::errc())
+    {
+        print.error("Invalid unicode escape sequence.", col, file_id);
+        return '?';
+    }
+    col = result.ptr - file.data();
+    return static_cast<char>(value);
 }
 
 void Lexer::handleComment()
 {
     if (peek() == '*')
     {
-        while (current() != '/' && previous() != '*')
-        {
-            advance();
-        }
+        size_t newlines = 0;
+        const char *comment_end = scan.find_comment_end(file.data() + col + 2, end(), newlines);
+        col = std::min<size_t>(comment_end - file.data() + 2, file.size());
+        line += newlines;
     }
     else
     {
-        while (current() != '\n')
-        {
-            advance();
-        }
-        return;
+        // The newline itself is left for lex() to count.
+        llvm::StringRef rest = file.substr(col);
+        col += std::min(rest.find('\n'), rest.size());
     }
 }
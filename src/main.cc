@@ -1,42 +1,11 @@
 #include <iostream>
 #include <string>
 #include <version.hh>
-#include <print.hh>
-#include <sstream>
-#include <fstream>
+#include <driver.hh>
 #include <cctype>
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/ADT/StringMap.h>
-#include <llvm/TargetParser/Triple.h>
-
-enum OptimizationLevel
-{
-    g,
-    O0,
-    O1,
-    O2,
-    O3
-};
-
-enum StageType {
-    c,
-    S,
-    B,
-    C
-};
-
-void read_file(std::string &file, const std::string &file_name, const PrintGlobalState& print) {
-    std::ifstream file_stream(file_name, std::ios::binary | std::ios::ate);
-    if (!file_stream)
-    {
-        print.error("File '" + file_name + "' not found !!!");
-        exit(127);
-    }
-    std::stringstream buffer;
-    buffer << file_stream.rdbuf();
-    file = buffer.str();
-}
 
 int main(int argc, char **argv)
 {
@@ -65,7 +34,8 @@ int main(int argc, char **argv)
         clEnumVal(c,"Run all stages except linking."),
         clEnumVal(S,"Specify to only compile files to provide assembly."),
         clEnumVal(B,"Specify to output the LLVM IR."),
-        clEnumVal(C,"Check if the code compiles, do not produce any files.")
+        clEnumVal(C,"Check if the code compiles, do not produce any files."),
+        clEnumValN(R, "run", "Compile the program just in time and run its main function.")
     ));
 
     llvm::cl::opt<OptimizationLevel> OptimizationLevel(llvm::cl::desc("Choose optimization level:"),
@@ -75,19 +45,30 @@ int main(int argc, char **argv)
                                                            clEnumVal(O1, "Enable trivial optimizations"),
                                                            clEnumVal(O2, "Enable default optimizations"),
                                                            clEnumVal(O3, "Enable expensive optimizations")));
-    llvm::cl::opt<std::string> March(llvm::cl::desc("Choose target architecture."), llvm::cl::value_desc("architecture name"));
-    llvm::cl::ParseCommandLineOptions(argc, argv, "Zurox Programming Language Compiler\n", nullptr, nullptr, true);
-    if (!March.empty()) {
-        llvm::Triple triple;
-        auto type = triple.getArchTypeForLLVMName(March);
-        if (type == llvm::Triple::ArchType::UnknownArch) {
-
-        }
-    }
-    
+    llvm::cl::opt<std::string> March("march", llvm::cl::desc("Choose target architecture."), llvm::cl::value_desc("architecture name"));
+    llvm::cl::opt<unsigned> Jobs("j", llvm::cl::desc("Number of threads to compile on, 0 for one per hardware thread."), llvm::cl::init(0));
+    llvm::cl::opt<bool> ReportTime("time-report", llvm::cl::desc("Print the time and memory every compilation phase took, with text diagnostics only."));
+    llvm::cl::opt<std::string> TimeTrace("time-trace", llvm::cl::desc("Write the timed phases as Chrome trace events to the file."), llvm::cl::value_desc("filename"));
+    llvm::cl::opt<std::string> ASTCacheDirectory("ast-cache", llvm::cl::desc("Cache the AST of every file in the directory, and load unchanged files from it."), llvm::cl::value_desc("directory"));
+    llvm::cl::opt<DiagnosticFormat> DiagnosticsFormat("diagnostics-format", llvm::cl::desc("Choose how diagnostics are written."), llvm::cl::init(DiagnosticFormat::TEXT),
+                                                      llvm::cl::values(
+                                                          clEnumValN(DiagnosticFormat::TEXT, "text", "Messages with the source line they refer to."),
+                                                          clEnumValN(DiagnosticFormat::JSON, "json", "One JSON object per line and diagnostic."),
+                                                          clEnumValN(DiagnosticFormat::SARIF, "sarif", "A SARIF 2.1.0 log.")));
+    llvm::cl::list<std::string> InputFiles(llvm::cl::Positional, llvm::cl::desc("<input files>"));
+    llvm::cl::ParseCommandLineOptions(argc, argv, "Zurox Programming Language Compiler\n");
 
-    // Process other options and logic here
-    // std::vector<std::string> files(argv + 1, argv + argc);
+    DriverOptions options;
+    options.stage = Stage;
+    options.optimization = OptimizationLevel;
+    options.output = Output;
+    options.march = March;
+    options.jobs = Jobs;
+    options.time_report = ReportTime;
+    options.time_trace = TimeTrace;
+    options.ast_cache = ASTCacheDirectory;
+    options.diagnostics_format = DiagnosticsFormat;
 
-    return 0;
+    Driver driver(options);
+    return driver.run(std::vector<std::string>(InputFiles.begin(), InputFiles.end()));
 }
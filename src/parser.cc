@@ -1,400 +1,521 @@
 #include <parser.hh>
-#include <functional>
 #include <definitions.hh>
 #include <ast.hh>
-#include <typeinfo>
+#include <algorithm>
+#include <sstream>
+#include <llvm/ADT/SmallVector.h>
 
-Parser::Parser(const std::vector<Token> &tokens, const std::string &file, PrintGlobalState &print)
-    : tokens(tokens), file(file), index(0), print(print) {}
+// Parts of a file parsed in parallel are at least this many tokens, so parsing one outweighs handing it to a thread.
+static constexpr size_t MIN_PART_TOKENS = 4096;
+// Parts per thread of the pool, so threads which finish their parts early can take others.
+static constexpr size_t PARTS_PER_THREAD = 4;
 
-std::shared_ptr<ProgramNode> Parser::parse()
+Parser::Parser(const std::vector<Token> &tokens, ASTContext &context, FileID file, PrintGlobalState &print)
+    : tokens(tokens), context(context), file(file), print(print), panicking(false) {}
+
+Parser::Parser(Lexer &lexer, ASTContext &context, FileID file, PrintGlobalState &print)
+    : tokens(lexer), context(context), file(file), print(print), panicking(false) {}
+
+ProgramNode *Parser::parse()
 {
-    auto program_node = std::make_shared<ProgramNode>(std::vector<std::shared_ptr<DeclarationNode>>{});
-    while (current_token().type != TokenType::__EOF)
+    llvm::SmallVector<DeclarationNode *, 16> declarations;
+    while (current_token().type != TokenType::__EOF && !print.errorLimitReached())
     {
-        auto declaration = parse_declaration();
+        auto declaration = parse_top_level();
         if (declaration)
         {
-            program_node->declarations.push_back(declaration);
+            declarations.push_back(declaration);
         }
-        else
+    }
+    return context.create<ProgramNode>(context.copy<DeclarationNode *>(declarations));
+}
+
+// Find the tokens parts start at: top-level declarations outside of any braces, at least `part_size` tokens apart.
+static std::vector<int_t> split_declarations(const std::vector<Token> &tokens, size_t part_size)
+{
+    std::vector<int_t> starts{0};
+    int depth = 0; // Signed, a '}' too many must not make it look like another top level.
+    for (int_t i = 0; i < tokens.size(); i++)
+    {
+        const Token &token = tokens[i];
+        if (token.separator() == SEP_LBRACE)
         {
-            // Handle error or skip to synchronize
-            auto t = tokens[index];
-            print.error("Unable to parse declaration.", t.line, t.col, file);
-            advance();
+            depth++;
+        }
+        else if (token.separator() == SEP_RBRACE)
+        {
+            depth--;
+        }
+        else if (depth == 0 && i - starts.back() >= part_size && Parser::is_declaration_start(token))
+        {
+            starts.push_back(i);
         }
     }
-    return program_node;
+    return starts;
 }
 
-Token Parser::current_token() const
+ProgramNode *Parser::parse(ThreadPool &pool)
 {
-    if (index < tokens.size())
+    const std::vector<Token> *lexed = tokens.lexed();
+    if (!lexed || pool.size() < 2 || print.hasEncounteredError())
     {
-        return tokens[index];
+        return parse();
     }
-    else
+    size_t part_size = std::max(MIN_PART_TOKENS, lexed->size() / (pool.size() * PARTS_PER_THREAD));
+    std::vector<int_t> starts = split_declarations(*lexed, part_size);
+    if (starts.size() < 2)
     {
-        Token eof_token;
-        eof_token.type = TokenType::__EOF;
-        eof_token.lexeme = "";
-        eof_token.line = 0;
-        eof_token.col = 0;
-        return eof_token;
+        return parse();
     }
+    int_t end = lexed->size() - 1; // The end of file token
+    starts.push_back(end);
+
+    size_t parts = starts.size() - 1;
+    std::vector<std::unique_ptr<ASTContext>> contexts(parts);
+    std::vector<std::vector<DeclarationNode *>> declarations(parts);
+    std::vector<char> clean(parts); // Not vector<bool>, the parts are written from several threads.
+    pool.runAll(parts, [&](size_t i)
+                {
+        contexts[i] = std::make_unique<ASTContext>();
+        // Errors are reported by parsing again on the calling thread, in order.
+        std::ostringstream discarded;
+        PrintGlobalState quiet;
+        quiet.setOutput(discarded);
+        Parser parser(*lexed, *contexts[i], file, quiet);
+        clean[i] = parser.parse_range(starts[i], starts[i + 1], declarations[i]) && !quiet.hasEncounteredError(); });
+
+    // A part not ending where the next one starts was split inside a declaration, the braces do not match.
+    if (std::find(clean.begin(), clean.end(), false) != clean.end())
+    {
+        return parse();
+    }
+    std::vector<DeclarationNode *> program;
+    for (size_t i = 0; i < parts; i++)
+    {
+        program.insert(program.end(), declarations[i].begin(), declarations[i].end());
+        context.adopt(std::move(contexts[i]));
+    }
+    tokens.seek(end);
+    return context.create<ProgramNode>(context.copy<DeclarationNode *>(program));
 }
 
-Token Parser::next_token() const
+bool Parser::parse_range(int_t begin, int_t end, std::vector<DeclarationNode *> &declarations)
 {
-    if (index + 1 < tokens.size())
+    tokens.seek(begin);
+    while (tokens.position() < end && current_token().type != TokenType::__EOF)
     {
-        return tokens[index + 1];
-    }
-    else
-    {
-        Token eof_token;
-        eof_token.type = TokenType::__EOF;
-        eof_token.lexeme = "";
-        eof_token.line = 0;
-        eof_token.col = 0;
-        return eof_token;
+        auto declaration = parse_top_level();
+        if (!declaration)
+        {
+            return false;
+        }
+        declarations.push_back(declaration);
     }
+    return tokens.position() == end;
 }
 
-void Parser::advance()
+DeclarationNode *Parser::parse_declaration_at(int_t &position)
 {
-    index++;
+    tokens.seek(position);
+    panicking = false;
+    auto declaration = parse_top_level();
+    position = tokens.position();
+    return declaration;
 }
 
-std::shared_ptr<DeclarationNode> Parser::parse_declaration()
+int_t Parser::token_count() const
 {
-    switch (current_token().type)
+    return tokens.size();
+}
+
+DeclarationNode *Parser::parse_top_level()
+{
+    auto declaration = parse_declaration();
+    if (panicking)
     {
-    case TokenType::TK_KEYWORD:
-        if (current_token().lexeme == "fn")
+        // Partly parsed declarations are dropped, so the AST never holds the nullptr of a failed node.
+        while (current_token().type != TokenType::__EOF && !is_declaration_start(current_token()))
         {
-            return parse_function_declaration();
-        }
-        else if (current_token().lexeme == "enum")
-        {
-            return parse_enum_declaration();
-        }
-        else if (current_token().lexeme == "struct")
-        {
-            return parse_struct_declaration();
+            advance();
         }
-        else
+        panicking = false;
+        return nullptr;
+    }
+    return declaration;
+}
+
+bool Parser::is_declaration_start(const Token &token)
+{
+    return token.keyword() == KW_FN || token.keyword() == KW_STRUCT || token.keyword() == KW_ENUM;
+}
+
+void Parser::synchronize()
+{
+    while (current_token().type != TokenType::__EOF && current_token().separator() != SEP_RBRACE && !is_declaration_start(current_token()))
+    {
+        if (current_token().separator() == SEP_SEMICOLON)
         {
-            // Handle error or skip to synchronize
-            auto t = tokens[index];
-            print.error("Unable to parse declaration.", t.line, t.col, file);
-            advance();
-            return nullptr;
+            advance(); // Consume ';', the statement it ends is skipped
+            break;
         }
-    default:
-        // Handle error or skip to synchronize
-        auto t = tokens[index];
-        print.error("Unable to parse declaration.", t.line, t.col, file);
         advance();
+    }
+    panicking = false;
+}
+
+void Parser::error(const std::string &expected)
+{
+    // Only the first error is reported, the ones following it until the parser
+    // has synchronized are almost always caused by it.
+    if (!panicking)
+    {
+        const Token &token = current_token();
+        std::string found = token.type == TokenType::__EOF ? "the end of the file" : "'" + std::string(token.lexeme) + "'";
+        print.error("Expected " + expected + " but found " + found + ".", token.col, file);
+    }
+    panicking = true;
+}
+
+const Token &Parser::current_token()
+{
+    return tokens.peek();
+}
+
+const Token &Parser::next_token()
+{
+    return tokens.peek(1);
+}
+
+void Parser::advance()
+{
+    tokens.advance();
+}
+
+DeclarationNode *Parser::parse_declaration()
+{
+    switch (current_token().keyword())
+    {
+    case KW_FN:
+        return parse_function_declaration();
+    case KW_ENUM:
+        return parse_enum_declaration();
+    case KW_STRUCT:
+        return parse_struct_declaration();
+    default:
+        error("'fn', 'struct' or 'enum'");
         return nullptr;
     }
 }
 
-std::shared_ptr<FunctionDeclarationNode> Parser::parse_function_declaration()
+FunctionDeclarationNode *Parser::parse_function_declaration()
 {
-    match(TokenType::TK_KEYWORD, "fn");
-    auto name = match(TokenType::TK_ID).lexeme;
-    match(TokenType::TK_SEPARATOR, "(");
+    int_t offset = match(KW_FN).col;
+    NameID name = match(TokenType::TK_ID).name;
+    match(SEP_LPAREN);
     auto parameters_list = parse_parameters();
-    match(TokenType::TK_SEPARATOR, ")");
-    std::shared_ptr<TypeNode> return_type = nullptr;
-    if (current_token().type == TokenType::TK_OPERATOR && current_token().lexeme == "->")
+    match(SEP_RPAREN);
+    TypeNode *return_type = nullptr;
+    if (current_token().op() == Operator::ARROW)
     {
         advance(); // Consume '->'
         return_type = parse_type();
     }
     auto body = parse_block();
-    return std::make_shared<FunctionDeclarationNode>(name, parameters_list, return_type, body);
+    return create<FunctionDeclarationNode>(offset, name, parameters_list, return_type, body);
 }
 
-std::vector<std::shared_ptr<ParameterNode>> Parser::parse_parameters()
+llvm::ArrayRef<ParameterNode *> Parser::parse_parameters()
 {
-    std::vector<std::shared_ptr<ParameterNode>> parameters;
-    if (current_token().type != TokenType::TK_SEPARATOR || current_token().lexeme != ")")
+    llvm::SmallVector<ParameterNode *, 8> parameters;
+    if (current_token().separator() != SEP_RPAREN)
     {
         parameters.push_back(parse_parameter());
-        while (current_token().type == TokenType::TK_SEPARATOR && current_token().lexeme == ",")
+        while (!panicking && current_token().separator() == SEP_COMMA)
         {
             advance(); // Consume ','
             parameters.push_back(parse_parameter());
         }
     }
-    return parameters;
+    return context.copy<ParameterNode *>(parameters);
 }
 
-std::shared_ptr<ParameterNode> Parser::parse_parameter()
+ParameterNode *Parser::parse_parameter()
 {
+    int_t offset = current_token().col;
     auto type_node = parse_type();
-    auto name = match(TokenType::TK_ID).lexeme;
-    return std::make_shared<ParameterNode>(type_node, name);
+    NameID name = match(TokenType::TK_ID).name;
+    return create<ParameterNode>(offset, type_node, name);
 }
 
-std::shared_ptr<TypeNode> Parser::parse_type()
+TypeNode *Parser::parse_type()
 {
+    int_t offset = current_token().col;
     switch (current_token().type)
     {
     case TokenType::TK_DATATYPE:
-        return std::make_shared<TypeNode>(match(TokenType::TK_DATATYPE).lexeme);
+        return create<TypeNode>(offset, context.save(match(TokenType::TK_DATATYPE).lexeme));
     case TokenType::TK_KEYWORD:
-        if (current_token().lexeme == "struct" || current_token().lexeme == "enum")
+        if (current_token().keyword() == KW_STRUCT || current_token().keyword() == KW_ENUM)
         {
-            return std::make_shared<TypeNode>(current_token().lexeme);
+            llvm::StringRef keyword = context.save(current_token().lexeme);
+            advance(); // Consume 'struct' or 'enum'
+            return create<TypeNode>(offset, keyword, match(TokenType::TK_ID).name);
         }
-        // Handle other type cases
+        // fall through
     default:
-        // Handle error or skip to synchronize
-        auto t = tokens[index];
-        print.error("Unable to parse declaration.", t.line, t.col, file);
-        advance();
+        error("a type");
         return nullptr;
     }
 }
 
-std::shared_ptr<StatementNode> Parser::parse_statement()
+StatementNode *Parser::parse_statement()
 {
     switch (current_token().type)
     {
     case TokenType::TK_KEYWORD:
-        if (current_token().lexeme == "if")
+        switch (current_token().keyword())
         {
+        case KW_IF:
             return parse_if_statement();
-        }
-        else if (current_token().lexeme == "loop")
-        {
+        case KW_LOOP:
             return parse_loop_statement();
-        }
-        else if (current_token().lexeme == "match")
-        {
+        case KW_MATCH:
             return parse_match_statement();
-        }
-        else if (current_token().lexeme == "break")
-        {
+        case KW_BREAK:
             return parse_break_statement();
-        }
-        else if (current_token().lexeme == "continue")
-        {
+        case KW_CONTINUE:
             return parse_continue_statement();
-        }
-        else
-        {
+        case KW_RET:
+            return parse_ret_statement();
+        case KW_TRUE:
+        case KW_FALSE:
+        case KW_NULL:
+            return parse_expression_statement();
+        default:
             return parse_var_declaration();
         }
+    case TokenType::TK_DATATYPE:
+        return parse_var_declaration();
+    case TokenType::TK_ID:
+    case TokenType::TKL_INT:
+    case TokenType::TKL_FLOAT:
+    case TokenType::TKL_CHAR:
+    case TokenType::TKL_STR:
+    case TokenType::TK_OPERATOR:
+        return parse_expression_statement();
     case TokenType::TK_SEPARATOR:
-        if (current_token().lexeme == "{")
+        switch (current_token().separator())
         {
+        case SEP_LBRACE:
             return parse_block();
+        case SEP_LPAREN:
+            return parse_expression_statement();
+        default:
+            break;
         }
-        else
-        {
-            // Handle error or skip to synchronize
-            auto t = tokens[index];
-            print.error("Unable to parse declaration.", t.line, t.col, file);
-            advance();
-            return nullptr;
-        }
+        // fall through
     default:
-        // Handle error or skip to synchronize
-        auto t = tokens[index];
-        print.error("Unable to parse declaration.", t.line, t.col, file);
-        advance();
+        error("a statement");
         return nullptr;
     }
 }
 
-std::shared_ptr<IfStatementNode> Parser::parse_if_statement()
+IfStatementNode *Parser::parse_if_statement()
 {
-    match(TokenType::TK_KEYWORD, "if");
-    match(TokenType::TK_SEPARATOR, "(");
+    int_t offset = match(KW_IF).col;
+    match(SEP_LPAREN);
     auto condition = parse_expression();
-    match(TokenType::TK_SEPARATOR, ")");
+    match(SEP_RPAREN);
     auto then_block = parse_block();
-    std::vector<std::shared_ptr<IfStatementNode>> elif_statements;
+    llvm::SmallVector<IfStatementNode *, 4> elif_statements;
 
-    while (current_token().type == TokenType::TK_KEYWORD && current_token().lexeme == "elif")
+    while (current_token().keyword() == KW_ELIF)
     {
+        int_t elif_offset = current_token().col;
         advance(); // Consume 'elif'
-        match(TokenType::TK_SEPARATOR, "(");
+        match(SEP_LPAREN);
         auto elif_condition = parse_expression();
-        match(TokenType::TK_SEPARATOR, ")");
+        match(SEP_RPAREN);
         auto elif_block = parse_block();
-        elif_statements.push_back(std::make_shared<IfStatementNode>(elif_condition, elif_block, std::vector<std::shared_ptr<IfStatementNode>>{}, nullptr));
+        elif_statements.push_back(create<IfStatementNode>(elif_offset, elif_condition, elif_block, llvm::ArrayRef<IfStatementNode *>(), nullptr));
     }
 
-    std::shared_ptr<BlockNode> else_block = nullptr;
-    if (current_token().type == TokenType::TK_KEYWORD && current_token().lexeme == "else")
+    BlockNode *else_block = nullptr;
+    if (current_token().keyword() == KW_ELSE)
     {
         advance(); // Consume 'else'
         else_block = parse_block();
     }
 
-    return std::make_shared<IfStatementNode>(condition, then_block, elif_statements, else_block);
+    return create<IfStatementNode>(offset, condition, then_block, context.copy<IfStatementNode *>(elif_statements), else_block);
 }
 
-std::shared_ptr<LoopStatementNode> Parser::parse_loop_statement()
+LoopStatementNode *Parser::parse_loop_statement()
 {
-    match(TokenType::TK_KEYWORD, "loop");
+    int_t offset = match(KW_LOOP).col;
     auto body = parse_block();
-    return std::make_shared<LoopStatementNode>(body);
+    return create<LoopStatementNode>(offset, body);
 }
 
-std::shared_ptr<VarDeclarationNode> Parser::parse_var_declaration()
+VarDeclarationNode *Parser::parse_var_declaration()
 {
+    int_t offset = current_token().col;
     auto type_node = parse_type();
-    auto name = match(TokenType::TK_ID).lexeme;
-    std::shared_ptr<ExpressionNode> initializer = nullptr;
-    if (current_token().type == TokenType::TK_OPERATOR && current_token().lexeme == "=")
+    NameID name = match(TokenType::TK_ID).name;
+    ExpressionNode *initializer = nullptr;
+    if (current_token().op() == Operator::ASSIGN)
     {
         advance(); // Consume '='
         initializer = parse_expression();
     }
-    match(TokenType::TK_SEPARATOR, ";");
-    return std::make_shared<VarDeclarationNode>(type_node, name, initializer);
+    match(SEP_SEMICOLON);
+    return create<VarDeclarationNode>(offset, type_node, name, initializer);
 }
 
-std::shared_ptr<ExpressionStatementNode> Parser::parse_expression_statement()
+ExpressionStatementNode *Parser::parse_expression_statement()
 {
+    int_t offset = current_token().col;
     auto expression = parse_expression();
-    match(TokenType::TK_SEPARATOR, ";");
-    return std::make_shared<ExpressionStatementNode>(expression);
+    match(SEP_SEMICOLON);
+    return create<ExpressionStatementNode>(offset, expression);
 }
 
-std::shared_ptr<MatchStatementNode> Parser::parse_match_statement()
+MatchStatementNode *Parser::parse_match_statement()
 {
-    match(TokenType::TK_KEYWORD, "match");
-    match(TokenType::TK_SEPARATOR, "{");
-    std::vector<std::shared_ptr<CaseClauseNode>> cases;
-    while (current_token().type == TokenType::TK_ID || is_literal(current_token().type))
+    int_t offset = match(KW_MATCH).col;
+    match(SEP_LPAREN);
+    auto subject = parse_expression();
+    match(SEP_RPAREN);
+    match(SEP_LBRACE);
+    llvm::SmallVector<CaseClauseNode *, 8> cases;
+    // The default case '_' is an identifier too, every other identifier is reported as not being a literal.
+    while (!panicking && ((current_token().type == TokenType::TK_ID && current_token().lexeme != "_") || is_literal(current_token().type) || is_keyword_literal(current_token().keyword())))
     {
         cases.push_back(parse_case_clause());
     }
-    std::shared_ptr<BlockNode> default_block = nullptr;
-    if (current_token().type == TokenType::TK_OPERATOR && current_token().lexeme == "_")
+    BlockNode *default_block = nullptr;
+    if (current_token().type == TokenType::TK_ID && current_token().lexeme == "_")
     {
         advance(); // Consume '_'
-        match(TokenType::TK_SEPARATOR, ":");
+        match(SEP_COLON);
         default_block = parse_block();
     }
-    match(TokenType::TK_SEPARATOR, "}");
-    return std::make_shared<MatchStatementNode>(cases, default_block);
+    match(SEP_RBRACE);
+    return create<MatchStatementNode>(offset, subject, context.copy<CaseClauseNode *>(cases), default_block);
 }
 
-std::shared_ptr<CaseClauseNode> Parser::parse_case_clause()
+CaseClauseNode *Parser::parse_case_clause()
 {
+    int_t offset = current_token().col;
     auto literal_node = parse_literal();
-    match(TokenType::TK_OPERATOR, ":");
+    match(SEP_COLON);
     auto block_node = parse_block();
-    return std::make_shared<CaseClauseNode>(literal_node, block_node);
+    return create<CaseClauseNode>(offset, literal_node, block_node);
 }
 
-std::shared_ptr<BreakStatementNode> Parser::parse_break_statement()
+BreakStatementNode *Parser::parse_break_statement()
 {
-    match(TokenType::TK_KEYWORD, "break");
-    match(TokenType::TK_SEPARATOR, ";");
-    return std::make_shared<BreakStatementNode>();
+    int_t offset = match(KW_BREAK).col;
+    match(SEP_SEMICOLON);
+    return create<BreakStatementNode>(offset);
 }
 
-std::shared_ptr<ContinueStatementNode> Parser::parse_continue_statement()
+ContinueStatementNode *Parser::parse_continue_statement()
 {
-    match(TokenType::TK_KEYWORD, "continue");
-    match(TokenType::TK_SEPARATOR, ";");
-    return std::make_shared<ContinueStatementNode>();
+    int_t offset = match(KW_CONTINUE).col;
+    match(SEP_SEMICOLON);
+    return create<ContinueStatementNode>(offset);
 }
 
-std::shared_ptr<EnumDeclarationNode> Parser::parse_enum_declaration()
+RetStatementNode *Parser::parse_ret_statement()
 {
-    match(TokenType::TK_KEYWORD, "enum");
-    auto name = match(TokenType::TK_ID).lexeme;
-    match(TokenType::TK_SEPARATOR, "{");
-    std::vector<std::string> fields;
-    while (current_token().type == TokenType::TK_ID)
+    int_t offset = match(KW_RET).col;
+    ExpressionNode *value = nullptr;
+    if (current_token().separator() != SEP_SEMICOLON)
     {
-        fields.push_back(match(TokenType::TK_ID).lexeme);
-        if (current_token().type == TokenType::TK_SEPARATOR && current_token().lexeme == ",")
-        {
-            advance(); // Consume ','
-        }
+        value = parse_expression();
     }
-    match(TokenType::TK_SEPARATOR, "}");
-    return std::make_shared<EnumDeclarationNode>(name, fields);
+    match(SEP_SEMICOLON);
+    return create<RetStatementNode>(offset, value);
 }
 
-std::shared_ptr<StructDeclarationNode> Parser::parse_struct_declaration()
+EnumDeclarationNode *Parser::parse_enum_declaration()
 {
-    match(TokenType::TK_KEYWORD, "struct");
-    auto name = match(TokenType::TK_ID).lexeme;
-    match(TokenType::TK_SEPARATOR, "{");
-    std::vector<std::shared_ptr<ParameterNode>> fields;
-    while (current_token().type == TokenType::TK_DATATYPE || current_token().type == TokenType::TK_ID)
+    int_t offset = match(KW_ENUM).col;
+    NameID name = match(TokenType::TK_ID).name;
+    match(SEP_LBRACE);
+    llvm::SmallVector<NameID, 8> fields;
+    while (current_token().type == TokenType::TK_ID)
     {
-        fields.push_back(parse_parameter());
-        if (current_token().type == TokenType::TK_SEPARATOR && current_token().lexeme == ",")
+        fields.push_back(match(TokenType::TK_ID).name);
+        if (current_token().separator() == SEP_COMMA)
         {
             advance(); // Consume ','
         }
     }
-    match(TokenType::TK_SEPARATOR, "}");
-    return std::make_shared<StructDeclarationNode>(name, fields);
+    match(SEP_RBRACE);
+    return create<EnumDeclarationNode>(offset, name, context.copy<NameID>(fields));
 }
 
-std::shared_ptr<ExpressionNode> Parser::parse_expression()
+StructDeclarationNode *Parser::parse_struct_declaration()
 {
-    return parse_term();
-}
-
-std::shared_ptr<ExpressionNode> Parser::parse_term()
-{
-    auto node = parse_factor();
-    while (current_token().type == TokenType::TK_OPERATOR &&
-           (current_token().lexeme == "+" || current_token().lexeme == "-"))
+    int_t offset = match(KW_STRUCT).col;
+    NameID name = match(TokenType::TK_ID).name;
+    match(SEP_LBRACE);
+    llvm::SmallVector<ParameterNode *, 8> fields;
+    while (!panicking && (current_token().type == TokenType::TK_DATATYPE || current_token().type == TokenType::TK_ID ||
+                          current_token().keyword() == KW_STRUCT || current_token().keyword() == KW_ENUM))
     {
-        auto op = current_token().lexeme;
-        advance(); // Consume operator
-        auto right = parse_factor();
-        node = std::make_shared<BinaryExprNode>(node, op, right);
+        fields.push_back(parse_parameter());
+        if (current_token().separator() == SEP_COMMA)
+        {
+            advance(); // Consume ','
+        }
     }
-    return node;
+    match(SEP_RBRACE);
+    return create<StructDeclarationNode>(offset, name, context.copy<ParameterNode *>(fields));
 }
 
-std::shared_ptr<ExpressionNode> Parser::parse_factor()
+// Precedence climbing: parse an operand, then keep folding in binary operators
+// that bind at least as tightly as `min_precedence`. The right operand of a
+// left associative operator only takes operators binding tighter than itself.
+ExpressionNode *Parser::parse_expression(Precedence min_precedence)
 {
     auto node = parse_unary_expr();
-    while (current_token().type == TokenType::TK_OPERATOR &&
-           (current_token().lexeme == "*" || current_token().lexeme == "/" || current_token().lexeme == "%"))
+    while (current_token().type == TokenType::TK_OPERATOR)
     {
-        auto op = current_token().lexeme;
+        Operator op = current_token().op();
+        const OperatorInfo &info = operator_info(op);
+        if (info.precedence == PREC_NONE || info.precedence < min_precedence)
+        {
+            break;
+        }
+        int_t offset = current_token().col;
         advance(); // Consume operator
-        auto right = parse_unary_expr();
-        node = std::make_shared<BinaryExprNode>(node, op, right);
+        Precedence next = info.right_associative ? info.precedence : static_cast<Precedence>(info.precedence + 1);
+        auto right = parse_expression(next);
+        node = create<BinaryExprNode>(offset, node, op, right);
     }
     return node;
 }
 
-std::shared_ptr<ExpressionNode> Parser::parse_unary_expr()
+ExpressionNode *Parser::parse_unary_expr()
 {
-    if (current_token().type == TokenType::TK_OPERATOR &&
-        (current_token().lexeme == "+" || current_token().lexeme == "-" ||
-         current_token().lexeme == "!" || current_token().lexeme == "~"))
+    if (current_token().type == TokenType::TK_OPERATOR)
     {
-        auto op = current_token().lexeme;
-        advance(); // Consume operator
-        auto right = parse_unary_expr();
-        return std::make_shared<UnaryExprNode>(op, right);
+        Operator op = current_token().op();
+        if (operator_info(op).prefix)
+        {
+            int_t offset = current_token().col;
+            advance(); // Consume operator
+            auto right = parse_unary_expr();
+            return create<UnaryExprNode>(offset, op, right);
+        }
     }
     return parse_primary();
 }
 
-std::shared_ptr<ExpressionNode> Parser::parse_primary()
+ExpressionNode *Parser::parse_primary()
 {
     switch (current_token().type)
     {
@@ -403,69 +524,96 @@ std::shared_ptr<ExpressionNode> Parser::parse_primary()
     case TokenType::TKL_CHAR:
     case TokenType::TKL_STR:
         return parse_literal();
+    case TokenType::TK_KEYWORD:
+        if (is_keyword_literal(current_token().keyword()))
+        {
+            return parse_literal();
+        }
+        break;
     case TokenType::TK_ID:
     {
-        auto identifier = std::make_shared<IdentifierNode>(match(TokenType::TK_ID).lexeme);
-        return std::static_pointer_cast<ExpressionNode>(identifier);
+        const Token &token = match(TokenType::TK_ID);
+        return create<IdentifierNode>(token.col, token.name);
     }
     case TokenType::TK_SEPARATOR:
-        if (current_token().lexeme == "(")
+        if (current_token().separator() == SEP_LPAREN)
         {
             advance(); // Consume '('
             auto node = parse_expression();
-            match(TokenType::TK_SEPARATOR, ")");
+            match(SEP_RPAREN);
             return node;
         }
-        // fall through
+        break;
     default:
-        // Handle error or throw exception
-        auto t = tokens[index];
-        print.error("Unable to parse declaration.", t.line, t.col, file);
-        advance();
-        return nullptr;
+        break;
     }
+    error("an expression");
+    return nullptr;
 }
 
-std::shared_ptr<LiteralNode> Parser::parse_literal()
+LiteralNode *Parser::parse_literal()
 {
     switch (current_token().type)
     {
     case TokenType::TKL_INT:
-        return std::make_shared<LiteralNode>(match(TokenType::TKL_INT).lexeme, "int");
     case TokenType::TKL_FLOAT:
-        return std::make_shared<LiteralNode>(match(TokenType::TKL_FLOAT).lexeme, "float");
     case TokenType::TKL_CHAR:
-        return std::make_shared<LiteralNode>(match(TokenType::TKL_CHAR).lexeme, "char");
     case TokenType::TKL_STR:
-        return std::make_shared<LiteralNode>(match(TokenType::TKL_STR).lexeme, "string");
+    {
+        // Copied since the AST may outlive the lexer and the version of the file it was parsed from.
+        const Token &token = match(current_token().type);
+        return create<LiteralNode>(token.col, context.save(token.lexeme), token.type);
+    }
+    case TokenType::TK_KEYWORD:
+        if (is_keyword_literal(current_token().keyword()))
+        {
+            // 'true', 'false' and 'null' keep their keyword as value.
+            const Token &token = match(current_token().keyword());
+            return create<LiteralNode>(token.col, context.save(token.lexeme), token.type);
+        }
+        // fall through
     default:
-        // Handle error
-        auto t = tokens[index];
-        print.error("Unable to parse declaration.", t.line, t.col, file);
-        advance();
+        error("a literal");
         return nullptr;
     }
 }
 
-Token Parser::match(TokenType expected_type, const std::string &expected_lexeme)
+// A token which does not match is not consumed, it is more likely that the
+// expected token is missing than that the one found is wrong.
+const Token &Parser::match(Keyword expected)
 {
-    Token token = current_token();
-    if (token.type != expected_type || (!expected_lexeme.empty() && token.lexeme != expected_lexeme))
+    const Token &token = current_token();
+    if (token.keyword() != expected)
     {
-        // Handle error: Unexpected token
-        auto t = tokens[index];
-        print.error("Unable to parse declaration.", t.line, t.col, file);
+        error("'" + std::string(KEYWORDS[expected - 1]) + "'");
+        return token;
     }
     advance(); // Consume the matched token
     return token;
 }
 
-Token Parser::match(TokenType expected_type) {
-    Token t = current_token();
-    if (t.type != expected_type) {
-        print.error("Unable to parse declaration.", t.line, t.col, file);
+const Token &Parser::match(Separator expected)
+{
+    const Token &token = current_token();
+    if (token.separator() != expected)
+    {
+        error("'" + std::string(1, separator_spelling(expected)) + "'");
+        return token;
     }
-    return t;
+    advance(); // Consume the matched token
+    return token;
+}
+
+const Token &Parser::match(TokenType expected_type)
+{
+    const Token &token = current_token();
+    if (token.type != expected_type)
+    {
+        error(expected_type == TokenType::TK_ID ? "an identifier" : "a literal");
+        return token;
+    }
+    advance(); // Consume the matched token
+    return token;
 }
 
 bool Parser::is_literal(TokenType type)
@@ -473,24 +621,29 @@ bool Parser::is_literal(TokenType type)
     return type == TKL_CHAR || type == TKL_FLOAT || type == TKL_INT || type == TKL_STR;
 }
 
-std::shared_ptr<BlockNode> Parser::parse_block()
+bool Parser::is_keyword_literal(Keyword keyword)
+{
+    return keyword == KW_TRUE || keyword == KW_FALSE || keyword == KW_NULL;
+}
+
+BlockNode *Parser::parse_block()
 {
-    match(TokenType::TK_SEPARATOR, "{");
-    std::vector<std::shared_ptr<StatementNode>> statements;
-    while (current_token().type != TokenType::TK_SEPARATOR || current_token().lexeme != "}")
+    int_t offset = match(SEP_LBRACE).col;
+    llvm::SmallVector<StatementNode *, 16> statements;
+    // 'fn' can not start a statement, the block is most likely missing its '}'.
+    while (!panicking && current_token().type != TokenType::__EOF && current_token().separator() != SEP_RBRACE &&
+           current_token().keyword() != KW_FN)
     {
         auto statement = parse_statement();
-        if (statement)
+        if (panicking)
         {
-            statements.push_back(statement);
+            synchronize();
         }
         else
         {
-            auto t = tokens[index];
-            print.error("Unable to parse declaration.", t.line, t.col, file);
-            advance();
+            statements.push_back(statement);
         }
     }
-    match(TokenType::TK_SEPARATOR, "}");
-    return std::make_shared<BlockNode>(statements);
+    match(SEP_RBRACE);
+    return create<BlockNode>(offset, context.copy<StatementNode *>(statements));
 }
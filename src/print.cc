@@ -2,12 +2,23 @@
 #include <string>
 #include "token.hh"
 #include "print.hh"
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
 
-PrintGlobalState::PrintGlobalState() : erroneous(false) {}
+// Indexed by Severity.
+static constexpr const char *TEXT_PREFIXES[] = {"\x1b[31;1merror:\x1b[0m ", "\x1b[33;1mwarn:\x1b[0m ", "\x1b[36;1minfo:\x1b[0m "};
+static constexpr const char *JSON_SEVERITIES[] = {"error", "warning", "info"};
+static constexpr const char *SARIF_LEVELS[] = {"error", "warning", "note"};
+
+PrintGlobalState::PrintGlobalState() : sources(nullptr), output(&std::cerr), format(DiagnosticFormat::TEXT), erroneous(false), counts{}, error_limit(20) {}
+
+PrintGlobalState::PrintGlobalState(const SourceManager &sources) : sources(&sources), output(&std::cerr), format(DiagnosticFormat::TEXT), erroneous(false), counts{}, error_limit(20) {}
 
 void PrintGlobalState::reset()
 {
     erroneous = false;
+    counts = {};
+    error_locations.clear();
 }
 
 bool PrintGlobalState::hasEncounteredError() const
@@ -15,77 +26,260 @@ bool PrintGlobalState::hasEncounteredError() const
     return erroneous;
 }
 
-void PrintGlobalState::error(const std::string &message, int_t line, int_t col, const std::string &file)
+void PrintGlobalState::setErrorLimit(int_t limit)
+{
+    error_limit = limit;
+}
+
+bool PrintGlobalState::errorLimitReached() const
+{
+    int_t error_count = counts[static_cast<size_t>(Severity::ERROR)];
+    return error_limit != 0 && error_count >= error_limit;
+}
+
+void PrintGlobalState::setOutput(std::ostream &output)
+{
+    this->output = &output;
+}
+
+void PrintGlobalState::setFormat(DiagnosticFormat format)
+{
+    this->format = format;
+}
+
+int_t PrintGlobalState::getCount(Severity severity) const
+{
+    return counts[static_cast<size_t>(severity)];
+}
+
+bool PrintGlobalState::countError() const
 {
     erroneous = true;
-    std::cerr << "\x1b[31;1merror:\x1b[0m " << message << std::endl;
-    printFile(line, col, file);
+    int_t &error_count = counts[static_cast<size_t>(Severity::ERROR)];
+    if (error_limit == 0 || error_count < error_limit)
+    {
+        error_count++;
+        return true;
+    }
+    if (error_count++ == error_limit)
+    {
+        report(Severity::ERROR, "too many errors emitted, stopping now.", 0, 0, false);
+    }
+    return false;
+}
+
+void PrintGlobalState::error(const std::string &message, int_t offset, FileID file)
+{
+    // Errors cascading from one bad token would otherwise be reported over and over.
+    if (!error_locations.insert(static_cast<uint64_t>(file) << 40 | offset).second)
+    {
+        erroneous = true;
+        return;
+    }
+    if (!countError())
+    {
+        return;
+    }
+    report(Severity::ERROR, message, offset, file, true);
 }
 
 void PrintGlobalState::error(const std::string &message) const
 {
-    erroneous = true;
-    std::cerr << "\x1b[31;1merror:\x1b[0m " << message << std::endl;
+    if (!countError())
+    {
+        return;
+    }
+    report(Severity::ERROR, message, 0, 0, false);
 }
 
-void PrintGlobalState::warn(const std::string &message, int_t line, int_t col, const std::string &file)
+void PrintGlobalState::warn(const std::string &message, int_t offset, FileID file)
 {
-    std::cerr << "\x1b[33;1mwarn:\x1b[0m " << message << std::endl;
-    printFile(line, col, file);
+    counts[static_cast<size_t>(Severity::WARNING)]++;
+    report(Severity::WARNING, message, offset, file, true);
 }
 
 void PrintGlobalState::warn(const std::string &message) const
 {
-    std::cerr << "\x1b[33;1mwarn:\x1b[0m " << message << std::endl;
+    counts[static_cast<size_t>(Severity::WARNING)]++;
+    report(Severity::WARNING, message, 0, 0, false);
 }
 
-void PrintGlobalState::info(const std::string &message, int_t line, int_t col, const std::string &file)
+void PrintGlobalState::info(const std::string &message, int_t offset, FileID file)
 {
-    std::cerr << "\x1b[36;1minfo:\x1b[0m " << message << std::endl;
-    printFile(line, col, file);
+    counts[static_cast<size_t>(Severity::INFO)]++;
+    report(Severity::INFO, message, offset, file, true);
 }
 
 void PrintGlobalState::info(const std::string &message) const
 {
-    std::cerr << "\x1b[36;1minfo:\x1b[0m " << message << std::endl;
+    counts[static_cast<size_t>(Severity::INFO)]++;
+    report(Severity::INFO, message, 0, 0, false);
 }
 
-void PrintGlobalState::printFile(int_t line, int_t col, const std::string &file) const {
-    if (line <= 0 || col <= 0 || static_cast<int_t>(line) > file.size()) {
-        std::cerr << "Invalid line or column number." << std::endl;
+void PrintGlobalState::report(Severity severity, const std::string &message, int_t offset, FileID file, bool located) const
+{
+    // Composed first and written at once, one write per diagnostic even to an unbuffered stream.
+    std::string text;
+    size_t index = static_cast<size_t>(severity);
+    if (format == DiagnosticFormat::TEXT)
+    {
+        text = TEXT_PREFIXES[index] + message + '\n';
+        if (located)
+        {
+            appendExcerpt(text, offset, file);
+        }
+        output->write(text.data(), text.size());
         return;
     }
 
-    int_t index = 0;
-    int_t current_line = 1;
-    int_t start_of_line = 0;
-
-    while (index < file.size()) {
-        if (current_line == line) {
-            start_of_line = index;
-            break;
+    // Messages may quote the source, which is not necessarily valid UTF-8.
+    auto utf8 = [](llvm::StringRef text)
+    {
+        return llvm::json::isUTF8(text) ? text.str() : llvm::json::fixUTF8(text);
+    };
+    located = located && sources && offset <= sources->getBuffer(file).size();
+    llvm::json::Object diagnostic;
+    if (format == DiagnosticFormat::JSON)
+    {
+        diagnostic = llvm::json::Object{{"severity", JSON_SEVERITIES[index]}, {"message", utf8(message)}};
+        if (located)
+        {
+            auto [line, column] = sources->getLineAndColumn(file, offset);
+            diagnostic["file"] = utf8(sources->getFileName(file));
+            diagnostic["line"] = static_cast<int64_t>(line);
+            diagnostic["column"] = static_cast<int64_t>(column);
         }
-
-        if (file[index] == '\n') {
-            current_line++;
+    }
+    else
+    {
+        diagnostic = llvm::json::Object{{"level", SARIF_LEVELS[index]}, {"message", llvm::json::Object{{"text", utf8(message)}}}};
+        if (located)
+        {
+            auto [line, column] = sources->getLineAndColumn(file, offset);
+            llvm::json::Object region{{"startLine", static_cast<int64_t>(line)}, {"startColumn", static_cast<int64_t>(column)}};
+            llvm::json::Object location{{"artifactLocation", llvm::json::Object{{"uri", utf8(sources->getFileName(file))}}},
+                                        {"region", std::move(region)}};
+            diagnostic["locations"] = llvm::json::Array{llvm::json::Object{{"physicalLocation", std::move(location)}}};
         }
-        index++;
     }
+    // A line per diagnostic, which is how the DiagnosticsWriter tells SARIF results apart.
+    llvm::raw_string_ostream stream(text);
+    stream << llvm::json::Value(std::move(diagnostic)) << '\n';
+    stream.flush();
+    output->write(text.data(), text.size());
+}
 
-    int_t end_of_line = file.find('\n', start_of_line);
-    if (end_of_line == std::string::npos) {
-        end_of_line = file.size();
+void PrintGlobalState::printFile(int_t offset, FileID file) const
+{
+    std::string text;
+    appendExcerpt(text, offset, file);
+    output->write(text.data(), text.size());
+}
+
+void PrintGlobalState::appendExcerpt(std::string &text, int_t offset, FileID file) const {
+    if (!sources || offset > sources->getBuffer(file).size()) {
+        text += "Invalid line or column number.\n";
+        return;
     }
 
-    std::string line_str = file.substr(start_of_line, end_of_line - start_of_line);
-    std::string marker(line_str.size(), ' ');
+    auto [line, col] = sources->getLineAndColumn(file, offset);
+    llvm::StringRef line_str = sources->getLine(file, line);
+
+    // Keep tabs so the marker lines up with the source line.
+    std::string marker;
+    for (int_t i = 0; i + 1 < col && i < line_str.size(); i++) {
+        marker.push_back(line_str[i] == '\t' ? '\t' : ' ');
+    }
+    marker.push_back('^');
 
-    if (col - start_of_line <= line_str.size()) {
-        marker[col - start_of_line - 1] = '^';
+    std::string line_num = std::to_string(line);
+    std::string padding(line_num.size(), ' ');
+
+    text += padding + "--> " + sources->getFileName(file).str() + ':' + line_num + ':' + std::to_string(col) + '\n';
+    text += line_num + " | " + line_str.str() + '\n';
+    text += padding + " | " + marker + "\n";
+}
+
+DiagnosticsWriter::DiagnosticsWriter(std::ostream &output, DiagnosticFormat format)
+    : output(output), format(format), next(0), empty(true), finished(false)
+{
+    if (format == DiagnosticFormat::SARIF)
+    {
+        output << "{\"version\":\"2.1.0\",\"$schema\":\"https://json.schemastore.org/sarif-2.1.0.json\","
+                  "\"runs\":[{\"tool\":{\"driver\":{\"name\":\"zx\",\"informationUri\":\"https://github.com/voidptrnull/zurox-lang\"}},"
+                  "\"results\":[";
     }
+}
 
-    int_t line_num_width = std::to_string(line).size();
+DiagnosticsWriter::~DiagnosticsWriter()
+{
+    finish();
+}
 
-    std::cout << line << " | " << line_str << '\n';
-    std::cout << std::string(line_num_width, ' ') << " | " << marker << "\n";
-}
\ No newline at end of file
+void DiagnosticsWriter::write(const std::string &diagnostics)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    append(diagnostics);
+}
+
+void DiagnosticsWriter::write(size_t index, std::string diagnostics)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (index != next)
+    {
+        pending.emplace(index, std::move(diagnostics));
+        return;
+    }
+    append(diagnostics);
+    // Every buffer waiting for this one can follow now.
+    for (next++; !pending.empty() && pending.begin()->first == next; next++)
+    {
+        append(pending.begin()->second);
+        pending.erase(pending.begin());
+    }
+}
+
+void DiagnosticsWriter::finish()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (finished)
+    {
+        return;
+    }
+    finished = true;
+    if (format == DiagnosticFormat::SARIF)
+    {
+        output << (empty ? "" : "\n") << "]}]}\n";
+    }
+    output.flush();
+}
+
+void DiagnosticsWriter::append(const std::string &diagnostics)
+{
+    if (finished || diagnostics.empty())
+    {
+        return;
+    }
+    if (format != DiagnosticFormat::SARIF)
+    {
+        output.write(diagnostics.data(), diagnostics.size());
+        return;
+    }
+    // Results are separated by commas, which only the writer can place between the buffers.
+    std::string results;
+    results.reserve(diagnostics.size() + diagnostics.size() / 64);
+    llvm::StringRef rest = diagnostics;
+    while (!rest.empty())
+    {
+        auto [line, next_lines] = rest.split('\n');
+        rest = next_lines;
+        if (line.empty())
+        {
+            continue;
+        }
+        results += empty ? "\n" : ",\n";
+        results.append(line.data(), line.size());
+        empty = false;
+    }
+    output.write(results.data(), results.size());
+}
@@ -0,0 +1,164 @@
+#include <scan.hh>
+#include <scan_kernels.hh>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+// Compiled separately with AVX2 enabled, see scan_avx2.cc.
+const ScanKernels &get_avx2_scan_kernels();
+#endif
+
+namespace
+{
+#if defined(__SSE2__)
+    struct SSE2Ops
+    {
+        typedef __m128i Vector;
+        static constexpr size_t WIDTH = 16;
+        static constexpr unsigned BITS = 1;
+        static constexpr uint64_t ALL = 0xffff;
+
+        static Vector load(const char *p)
+        {
+            return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        }
+
+        static uint64_t mask(Vector v)
+        {
+            return static_cast<uint32_t>(_mm_movemask_epi8(v));
+        }
+
+        static Vector eq(Vector v, char c)
+        {
+            return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+        }
+
+        // Signed compares, bytes outside of ASCII are negative and never in range.
+        static Vector range(Vector v, char lo, char hi)
+        {
+            return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+        }
+
+        static uint64_t equal(Vector v, char c)
+        {
+            return mask(eq(v, c));
+        }
+
+        static uint64_t whitespace(Vector v)
+        {
+            return mask(_mm_or_si128(eq(v, ' '), range(v, '\t', '\r')));
+        }
+
+        static uint64_t identifier(Vector v)
+        {
+            Vector lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+            return mask(_mm_or_si128(_mm_or_si128(range(lower, 'a', 'z'), range(v, '0', '9')), eq(v, '_')));
+        }
+
+        static uint64_t number(Vector v)
+        {
+            Vector signs = _mm_or_si128(eq(v, '+'), eq(v, '-'));
+            Vector letters = _mm_or_si128(_mm_or_si128(eq(v, 'x'), eq(v, 'e')), eq(v, 'E'));
+            return mask(_mm_or_si128(_mm_or_si128(range(v, '0', '9'), eq(v, '.')), _mm_or_si128(signs, letters)));
+        }
+    };
+
+    constexpr ScanKernels SSE2_KERNELS = make_vector_kernels<SSE2Ops>("sse2");
+#elif defined(__ARM_NEON)
+    struct NEONOps
+    {
+        typedef uint8x16_t Vector;
+        static constexpr size_t WIDTH = 16;
+        static constexpr unsigned BITS = 4;
+        static constexpr uint64_t ALL = ~0ULL;
+
+        static Vector load(const char *p)
+        {
+            return vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+        }
+
+        // NEON has no movemask, narrowing every byte to a nibble is the cheapest equivalent.
+        static uint64_t mask(Vector v)
+        {
+            return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(v), 4)), 0);
+        }
+
+        static Vector eq(Vector v, char c)
+        {
+            return vceqq_u8(v, vdupq_n_u8(c));
+        }
+
+        static Vector range(Vector v, char lo, char hi)
+        {
+            return vandq_u8(vcgeq_u8(v, vdupq_n_u8(lo)), vcleq_u8(v, vdupq_n_u8(hi)));
+        }
+
+        static uint64_t equal(Vector v, char c)
+        {
+            return mask(eq(v, c));
+        }
+
+        static uint64_t whitespace(Vector v)
+        {
+            return mask(vorrq_u8(eq(v, ' '), range(v, '\t', '\r')));
+        }
+
+        static uint64_t identifier(Vector v)
+        {
+            Vector lower = vorrq_u8(v, vdupq_n_u8(0x20));
+            return mask(vorrq_u8(vorrq_u8(range(lower, 'a', 'z'), range(v, '0', '9')), eq(v, '_')));
+        }
+
+        static uint64_t number(Vector v)
+        {
+            Vector signs = vorrq_u8(eq(v, '+'), eq(v, '-'));
+            Vector letters = vorrq_u8(vorrq_u8(eq(v, 'x'), eq(v, 'e')), eq(v, 'E'));
+            return mask(vorrq_u8(vorrq_u8(range(v, '0', '9'), eq(v, '.')), vorrq_u8(signs, letters)));
+        }
+    };
+
+    constexpr ScanKernels NEON_KERNELS = make_vector_kernels<NEONOps>("neon");
+#endif
+
+    constexpr ScanKernels SCALAR_KERNELS = {
+        "scalar",
+        scalar_skip_whitespace,
+        scalar_skip<CC_IDENT>,
+        scalar_skip<CC_NUMBER>,
+        scalar_find_string_end,
+        scalar_find_comment_end,
+    };
+
+    const ScanKernels &select_scan_kernels()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return get_avx2_scan_kernels();
+        }
+#endif
+#if defined(__SSE2__)
+        return SSE2_KERNELS;
+#elif defined(__ARM_NEON)
+        return NEON_KERNELS;
+#else
+        return SCALAR_KERNELS;
+#endif
+    }
+}
+
+const ScanKernels &get_scan_kernels()
+{
+    static const ScanKernels &kernels = select_scan_kernels();
+    return kernels;
+}
+
+const ScanKernels &get_scalar_scan_kernels()
+{
+    return SCALAR_KERNELS;
+}
@@ -0,0 +1,71 @@
+// This file is compiled with AVX2 enabled, its kernels are only used when
+// get_scan_kernels() finds AVX2 support at runtime.
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+#include <scan.hh>
+#include <scan_kernels.hh>
+
+namespace
+{
+    struct AVX2Ops
+    {
+        typedef __m256i Vector;
+        static constexpr size_t WIDTH = 32;
+        static constexpr unsigned BITS = 1;
+        static constexpr uint64_t ALL = 0xffffffff;
+
+        static Vector load(const char *p)
+        {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        }
+
+        static uint64_t mask(Vector v)
+        {
+            return static_cast<uint32_t>(_mm256_movemask_epi8(v));
+        }
+
+        static Vector eq(Vector v, char c)
+        {
+            return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+        }
+
+        // Signed compares, bytes outside of ASCII are negative and never in range.
+        static Vector range(Vector v, char lo, char hi)
+        {
+            return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+        }
+
+        static uint64_t equal(Vector v, char c)
+        {
+            return mask(eq(v, c));
+        }
+
+        static uint64_t whitespace(Vector v)
+        {
+            return mask(_mm256_or_si256(eq(v, ' '), range(v, '\t', '\r')));
+        }
+
+        static uint64_t identifier(Vector v)
+        {
+            Vector lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+            return mask(_mm256_or_si256(_mm256_or_si256(range(lower, 'a', 'z'), range(v, '0', '9')), eq(v, '_')));
+        }
+
+        static uint64_t number(Vector v)
+        {
+            Vector signs = _mm256_or_si256(eq(v, '+'), eq(v, '-'));
+            Vector letters = _mm256_or_si256(_mm256_or_si256(eq(v, 'x'), eq(v, 'e')), eq(v, 'E'));
+            return mask(_mm256_or_si256(_mm256_or_si256(range(v, '0', '9'), eq(v, '.')), _mm256_or_si256(signs, letters)));
+        }
+    };
+
+    constexpr ScanKernels AVX2_KERNELS = make_vector_kernels<AVX2Ops>("avx2");
+}
+
+const ScanKernels &get_avx2_scan_kernels()
+{
+    return AVX2_KERNELS;
+}
+
+#endif
@@ -0,0 +1,559 @@
+#include <sema.hh>
+#include <llvm/ADT/APInt.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SmallPtrSet.h>
+
+// Whether a value of the type holds a value of the struct, in its fields or the fields of their structs.
+static bool contains(const Type *type, const StructType *structure, llvm::SmallPtrSetImpl<const Type *> &visited)
+{
+    auto *inner = llvm::dyn_cast<StructType>(type);
+    if (!inner || !visited.insert(inner).second)
+    {
+        return false;
+    }
+    for (const StructType::Field &field : inner->fields)
+    {
+        if (field.type == structure || contains(field.type, structure, visited))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Whether the statement breaks out of the loop around it, a nested loop takes the breaks in its body.
+static bool breaks(const StatementNode *statement)
+{
+    switch (statement->getKind())
+    {
+    case ASTNode::NODE_BREAK_STATEMENT:
+        return true;
+    case ASTNode::NODE_BLOCK:
+        return llvm::any_of(llvm::cast<BlockNode>(statement)->statements, breaks);
+    case ASTNode::NODE_IF_STATEMENT:
+    {
+        auto *branch = llvm::cast<IfStatementNode>(statement);
+        return breaks(branch->then_block) || llvm::any_of(branch->elif_statements, breaks) || (branch->else_block && breaks(branch->else_block));
+    }
+    case ASTNode::NODE_MATCH_STATEMENT:
+    {
+        auto *match = llvm::cast<MatchStatementNode>(statement);
+        return llvm::any_of(match->cases, [](const CaseClauseNode *clause) { return breaks(clause->block); }) ||
+               (match->default_block && breaks(match->default_block));
+    }
+    default:
+        return false;
+    }
+}
+
+// Whether control can reach the end of the statement. Conditions are not evaluated, a branch may always be taken.
+static bool completes(const StatementNode *statement)
+{
+    switch (statement->getKind())
+    {
+    case ASTNode::NODE_RET_STATEMENT:
+    case ASTNode::NODE_BREAK_STATEMENT:
+    case ASTNode::NODE_CONTINUE_STATEMENT:
+        return false;
+    case ASTNode::NODE_BLOCK:
+        return llvm::all_of(llvm::cast<BlockNode>(statement)->statements, completes);
+    case ASTNode::NODE_IF_STATEMENT:
+    {
+        // Without an else, no branch is taken when every condition is false.
+        auto *branch = llvm::cast<IfStatementNode>(statement);
+        return !branch->else_block || completes(branch->then_block) || completes(branch->else_block) ||
+               llvm::any_of(branch->elif_statements, [](const IfStatementNode *elif) { return completes(elif->then_block); });
+    }
+    case ASTNode::NODE_LOOP_STATEMENT:
+        return breaks(llvm::cast<LoopStatementNode>(statement)->body);
+    case ASTNode::NODE_MATCH_STATEMENT:
+    {
+        auto *match = llvm::cast<MatchStatementNode>(statement);
+        return !match->default_block || completes(match->default_block) ||
+               llvm::any_of(match->cases, [](const CaseClauseNode *clause) { return completes(clause->block); });
+    }
+    default:
+        return true;
+    }
+}
+
+SemanticAnalyzer::SemanticAnalyzer(TypeContext &types, const StringInterner &names, PrintGlobalState &print)
+    : types(types), names(names), print(print), table(print, names), file(0), level(0), loops(0), return_type(nullptr), failed(false) {}
+
+bool SemanticAnalyzer::analyze(ProgramNode *program, FileID file)
+{
+    this->file = file;
+    failed = false;
+    enterScope();
+    declareTypes(program->declarations);
+    for (DeclarationNode *declaration : program->declarations)
+    {
+        visit(declaration);
+    }
+    exitScope();
+    return !failed;
+}
+
+void SemanticAnalyzer::error(const std::string &message, const ASTNode *node)
+{
+    print.error(message, node->offset, file);
+    failed = true;
+}
+
+std::string SemanticAnalyzer::getName(const Type *type) const
+{
+    return TypeContext::getName(type, names);
+}
+
+void SemanticAnalyzer::enterScope()
+{
+    table.enterScope();
+    level++;
+}
+
+void SemanticAnalyzer::exitScope()
+{
+    table.exitScope();
+    level--;
+}
+
+void SemanticAnalyzer::declare(NameID name, SymbolType kind, const Type *type, const ASTNode *node)
+{
+    Symbol symbol;
+    if (table.lookup(name, symbol) && symbol.level == level)
+    {
+        error("Redeclaration of '" + names.get(name).str() + "'.", node);
+        return;
+    }
+    table.insert(name, Symbol{name, kind, level, 0, type});
+}
+
+void SemanticAnalyzer::declareTypes(llvm::ArrayRef<DeclarationNode *> declarations)
+{
+    // Every struct is declared before the fields of any is resolved, so fields may be of a struct declared later.
+    for (DeclarationNode *declaration : declarations)
+    {
+        switch (declaration->getKind())
+        {
+        case ASTNode::NODE_FUNCTION_DECLARATION:
+            declare(llvm::cast<FunctionDeclarationNode>(declaration)->name, SymbolType::FUNCTION, nullptr, declaration);
+            break;
+        case ASTNode::NODE_ENUM_DECLARATION:
+        {
+            auto *enumeration = llvm::cast<EnumDeclarationNode>(declaration);
+            declare(enumeration->name, SymbolType::ENUM, types.createEnum(enumeration->name, enumeration->fields), enumeration);
+            break;
+        }
+        default:
+        {
+            auto *structure = llvm::cast<StructDeclarationNode>(declaration);
+            declare(structure->name, SymbolType::STRUCT, types.createStruct(structure->name), structure);
+            break;
+        }
+        }
+    }
+    llvm::SmallVector<std::pair<const StructType *, const StructDeclarationNode *>, 8> structs;
+    for (DeclarationNode *declaration : declarations)
+    {
+        auto *structure = llvm::dyn_cast<StructDeclarationNode>(declaration);
+        Symbol symbol;
+        if (!structure || !table.lookup(structure->name, symbol) || symbol.type != SymbolType::STRUCT)
+        {
+            continue;
+        }
+        // A redeclared struct shares the name but not the type of the first one, whose fields are kept.
+        auto *type = llvm::cast<StructType>(const_cast<Type *>(symbol.value_type));
+        if (!type->fields.empty())
+        {
+            continue;
+        }
+        llvm::SmallVector<StructType::Field, 8> fields;
+        for (const ParameterNode *field : structure->fields)
+        {
+            fields.push_back({field->name, resolveType(field->type)});
+        }
+        types.setFields(type, fields);
+        structs.push_back({type, structure});
+    }
+    // A struct holding itself would have no finite size.
+    for (auto [type, structure] : structs)
+    {
+        llvm::SmallPtrSet<const Type *, 8> visited;
+        if (contains(type, type, visited))
+        {
+            error("Struct '" + names.get(structure->name).str() + "' contains itself.", structure);
+        }
+    }
+}
+
+const Type *SemanticAnalyzer::resolveType(TypeNode *type)
+{
+    if (!type->reference)
+    {
+        type->resolved_type = types.getPrimitive(type->name);
+        if (!type->resolved_type)
+        {
+            error("Unknown type '" + type->name.str() + "'.", type);
+            type->resolved_type = types.getError();
+        }
+        return type->resolved_type;
+    }
+    SymbolType expected = type->name == "struct" ? SymbolType::STRUCT : SymbolType::ENUM;
+    Symbol symbol;
+    if (!table.lookup(type->reference, symbol) || symbol.type != expected)
+    {
+        error("Unknown type '" + type->name.str() + " " + names.get(type->reference).str() + "'.", type);
+        type->resolved_type = types.getError();
+        return type->resolved_type;
+    }
+    type->resolved_type = symbol.value_type;
+    return type->resolved_type;
+}
+
+void SemanticAnalyzer::visitFunctionDeclarationNode(FunctionDeclarationNode *function)
+{
+    return_type = function->return_type ? resolveType(function->return_type) : types.getVoid();
+    enterScope();
+    for (const ParameterNode *parameter : function->parameters)
+    {
+        declare(parameter->name, SymbolType::VARIABLE, resolveType(parameter->type), parameter);
+    }
+    visit(function->body);
+    exitScope();
+    if (!return_type->isVoid() && !return_type->isError() && completes(function->body))
+    {
+        error("Function '" + names.get(function->name).str() + "' can end without returning a value of type '" + getName(return_type) + "'.", function);
+    }
+}
+
+void SemanticAnalyzer::visitBlockNode(BlockNode *block)
+{
+    enterScope();
+    for (StatementNode *statement : block->statements)
+    {
+        visit(statement);
+    }
+    exitScope();
+}
+
+void SemanticAnalyzer::visitIfStatementNode(IfStatementNode *statement)
+{
+    checkCondition(statement->condition);
+    visit(statement->then_block);
+    for (IfStatementNode *elif : statement->elif_statements)
+    {
+        visit(elif);
+    }
+    if (statement->else_block)
+    {
+        visit(statement->else_block);
+    }
+}
+
+void SemanticAnalyzer::visitLoopStatementNode(LoopStatementNode *statement)
+{
+    loops++;
+    visit(statement->body);
+    loops--;
+}
+
+void SemanticAnalyzer::visitVarDeclarationNode(VarDeclarationNode *declaration)
+{
+    const Type *type = resolveType(declaration->type);
+    if (declaration->initializer)
+    {
+        checkConversion(checkExpression(declaration->initializer, type), type, declaration->initializer);
+    }
+    // Declared after the initializer, which still refers to any shadowed variable.
+    declare(declaration->name, SymbolType::VARIABLE, type, declaration);
+}
+
+void SemanticAnalyzer::visitExpressionStatementNode(ExpressionStatementNode *statement)
+{
+    checkExpression(statement->expression, nullptr);
+}
+
+void SemanticAnalyzer::visitMatchStatementNode(MatchStatementNode *statement)
+{
+    const Type *type = checkExpression(statement->subject, nullptr);
+    // Strings are the only arrays an expression can have, a string literal.
+    bool is_string = llvm::isa<ArrayType>(type);
+    if (!type->isError() && !type->isInteger() && !is_string)
+    {
+        error("Cannot match on a value of type '" + getName(type) + "'.", statement->subject);
+        type = types.getError();
+    }
+    for (CaseClauseNode *clause : statement->cases)
+    {
+        // Cases take the type of the subject, which they are compared in.
+        const Type *case_type = checkExpression(clause->literal, is_string ? nullptr : type);
+        bool valid = type->isError() || case_type->isError() || (is_string == llvm::isa<ArrayType>(case_type) && !case_type->isFloat());
+        if (!valid)
+        {
+            error("Cannot convert '" + getName(case_type) + "' to '" + getName(type) + "'.", clause->literal);
+        }
+        else if (!is_string)
+        {
+            clause->literal->value_type = type;
+        }
+        visit(clause->block);
+    }
+    if (statement->default_block)
+    {
+        visit(statement->default_block);
+    }
+}
+
+void SemanticAnalyzer::visitBreakStatementNode(BreakStatementNode *statement)
+{
+    if (!loops)
+    {
+        error("'break' is only allowed inside of a loop.", statement);
+    }
+}
+
+void SemanticAnalyzer::visitContinueStatementNode(ContinueStatementNode *statement)
+{
+    if (!loops)
+    {
+        error("'continue' is only allowed inside of a loop.", statement);
+    }
+}
+
+void SemanticAnalyzer::visitRetStatementNode(RetStatementNode *statement)
+{
+    if (!statement->value)
+    {
+        if (!return_type->isVoid() && !return_type->isError())
+        {
+            error("Missing return value of type '" + getName(return_type) + "'.", statement);
+        }
+        return;
+    }
+    const Type *type = checkExpression(statement->value, return_type->isVoid() ? nullptr : return_type);
+    if (return_type->isVoid())
+    {
+        error("Function has no return type but returns a value.", statement->value);
+        return;
+    }
+    checkConversion(type, return_type, statement->value);
+}
+
+const Type *SemanticAnalyzer::checkExpression(ExpressionNode *expression, const Type *expected)
+{
+    const Type *type;
+    switch (expression->getKind())
+    {
+    case ASTNode::NODE_LITERAL:
+        type = checkLiteral(llvm::cast<LiteralNode>(expression), expected);
+        break;
+    case ASTNode::NODE_IDENTIFIER:
+        type = checkIdentifier(llvm::cast<IdentifierNode>(expression));
+        break;
+    case ASTNode::NODE_UNARY_EXPR:
+        type = checkUnary(llvm::cast<UnaryExprNode>(expression), expected);
+        break;
+    case ASTNode::NODE_BINARY_EXPR:
+        type = checkBinary(llvm::cast<BinaryExprNode>(expression), expected);
+        break;
+    default:
+        error("Unsupported expression.", expression);
+        type = types.getError();
+        break;
+    }
+    expression->value_type = type;
+    return type;
+}
+
+const Type *SemanticAnalyzer::checkLiteral(const LiteralNode *literal, const Type *expected)
+{
+    switch (literal->type)
+    {
+    case TokenType::TKL_INT:
+    {
+        if (expected && (expected->isInteger() || expected->isFloat()))
+        {
+            return expected;
+        }
+        llvm::APInt value;
+        if (literal->value.getAsInteger(0, value))
+        {
+            error("Invalid integer literal '" + literal->value.str() + "'.", literal);
+            return types.getError();
+        }
+        return types.getPrimitive(value.getActiveBits() < 32 ? "i32" : "i64");
+    }
+    case TokenType::TKL_FLOAT:
+        return expected && expected->isFloat() ? expected : types.getPrimitive("f64");
+    case TokenType::TKL_CHAR:
+        return types.getPrimitive("char");
+    case TokenType::TKL_STR:
+        return types.getArray(types.getPrimitive("char"), literal->value.size());
+    case TokenType::TK_KEYWORD:
+        if (literal->value != "null")
+        {
+            return types.getPrimitive("bool");
+        }
+        // The zero of whichever scalar it initializes or is compared to.
+        if (expected && expected->isScalar())
+        {
+            return expected;
+        }
+        error("Cannot infer the type of 'null'.", literal);
+        return types.getError();
+    default:
+        error("Invalid literal '" + literal->value.str() + "'.", literal);
+        return types.getError();
+    }
+}
+
+const Type *SemanticAnalyzer::checkIdentifier(const IdentifierNode *identifier)
+{
+    Symbol symbol;
+    if (!table.lookup(identifier->name, symbol))
+    {
+        error("Unknown identifier '" + names.get(identifier->name).str() + "'.", identifier);
+        return types.getError();
+    }
+    if (symbol.type != SymbolType::VARIABLE)
+    {
+        error("'" + names.get(identifier->name).str() + "' is not a variable.", identifier);
+        return types.getError();
+    }
+    return symbol.value_type;
+}
+
+const Type *SemanticAnalyzer::checkVariable(ExpressionNode *expression, Operator op)
+{
+    if (!llvm::isa<IdentifierNode>(expression))
+    {
+        checkExpression(expression, nullptr);
+        error("Operand of '" + std::string(operator_info(op).spelling) + "' must be a variable.", expression);
+        return types.getError();
+    }
+    return checkExpression(expression, nullptr);
+}
+
+const Type *SemanticAnalyzer::checkUnary(UnaryExprNode *expression, const Type *expected)
+{
+    Operator op = expression->op;
+    const Type *type;
+    if (op == Operator::INCREMENT || op == Operator::DECREMENT)
+    {
+        type = checkVariable(expression->operand, op);
+    }
+    else
+    {
+        type = checkExpression(expression->operand, op == Operator::NOT ? nullptr : expected);
+    }
+    if (type->isError())
+    {
+        return type;
+    }
+    if (op == Operator::NOT && type->isScalar())
+    {
+        return types.getPrimitive("bool");
+    }
+    if ((op == Operator::BIT_NOT && type->isInteger()) || (op != Operator::NOT && op != Operator::BIT_NOT && type->isScalar()))
+    {
+        return type;
+    }
+    error("Invalid operand of type '" + getName(type) + "' to unary operator '" + std::string(operator_info(op).spelling) + "'.", expression);
+    return types.getError();
+}
+
+const Type *SemanticAnalyzer::checkBinary(BinaryExprNode *expression, const Type *expected)
+{
+    Operator op = expression->op;
+    const OperatorInfo &info = operator_info(op);
+    if (info.precedence == PREC_ASSIGN)
+    {
+        const Type *type = checkVariable(expression->left, op);
+        const Type *value = checkExpression(expression->right, type->isError() ? nullptr : type);
+        if (info.compound != Operator::NONE)
+        {
+            value = checkOperation(info.compound, type, value, expression);
+        }
+        checkConversion(value, type, expression);
+        return type;
+    }
+    if (op == Operator::LOGICAL_AND || op == Operator::LOGICAL_OR)
+    {
+        checkCondition(expression->left);
+        checkCondition(expression->right);
+        return types.getPrimitive("bool");
+    }
+    // Comparisons produce a bool, what their operands are typed as does not depend on it.
+    if (info.precedence == PREC_EQUALITY || info.precedence == PREC_RELATIONAL)
+    {
+        expected = nullptr;
+    }
+    const Type *left = checkExpression(expression->left, expected);
+    const Type *right = checkExpression(expression->right, expected);
+    return checkOperation(op, left, right, expression);
+}
+
+const Type *SemanticAnalyzer::checkOperation(Operator op, const Type *left, const Type *right, const ExpressionNode *expression)
+{
+    if (left->isError() || right->isError())
+    {
+        return types.getError();
+    }
+    std::string spelling(operator_info(op).spelling);
+    if (!left->isScalar() || !right->isScalar())
+    {
+        error("Invalid operands of types '" + getName(left) + "' and '" + getName(right) + "' to binary operator '" + spelling + "'.", expression);
+        return types.getError();
+    }
+    const OperatorInfo &info = operator_info(op);
+    if (info.precedence == PREC_EQUALITY || info.precedence == PREC_RELATIONAL)
+    {
+        return types.getPrimitive("bool");
+    }
+
+    const PrimitiveType *type = types.getArithmeticType(left, right);
+    bool is_float = type->isFloat();
+    switch (op)
+    {
+    case Operator::ADD:
+    case Operator::SUB:
+    case Operator::MUL:
+    case Operator::DIV:
+    case Operator::MOD:
+    case Operator::POW:
+        break;
+    case Operator::BIT_AND:
+    case Operator::BIT_OR:
+    case Operator::SHIFT_LEFT:
+    case Operator::SHIFT_RIGHT:
+        if (is_float)
+        {
+            error("Invalid floating point operands to binary operator '" + spelling + "'.", expression);
+            return types.getError();
+        }
+        break;
+    default:
+        error("Unsupported binary operator '" + spelling + "'.", expression);
+        return types.getError();
+    }
+    return type;
+}
+
+void SemanticAnalyzer::checkCondition(ExpressionNode *condition)
+{
+    const Type *type = checkExpression(condition, nullptr);
+    if (!type->isError() && !type->isScalar())
+    {
+        error("Invalid condition of type '" + getName(type) + "'.", condition);
+    }
+}
+
+void SemanticAnalyzer::checkConversion(const Type *from, const Type *to, const ASTNode *node)
+{
+    // Canonical types are equal exactly when their pointers are.
+    if (from == to || from->isError() || to->isError() || (from->isScalar() && to->isScalar()))
+    {
+        return;
+    }
+    error("Cannot convert '" + getName(from) + "' to '" + getName(to) + "'.", node);
+}
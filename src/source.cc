@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <source.hh>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/// Append the offset following every newline of the buffer, 16 bytes at a time where possible.
+static void scanLineOffsets(llvm::StringRef buffer, std::vector<int_t> &offsets)
+{
+    const char *start = buffer.data();
+    size_t size = buffer.size();
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(start + i));
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+        while (mask)
+        {
+            offsets.push_back(i + __builtin_ctz(mask) + 1);
+            mask &= mask - 1;
+        }
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t newline = vdupq_n_u8('\n');
+    for (; i + 16 <= size; i += 16)
+    {
+        uint8x16_t matches = vceqq_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(start + i)), newline);
+        // Narrow every byte of the comparison to a nibble of a 64 bit mask.
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+        while (mask)
+        {
+            int_t bit = __builtin_ctzll(mask);
+            offsets.push_back(i + (bit >> 2) + 1);
+            mask &= ~(0xfULL << (bit & ~3ULL));
+        }
+    }
+#endif
+    for (; i < size; ++i)
+    {
+        if (start[i] == '\n')
+        {
+            offsets.push_back(i + 1);
+        }
+    }
+}
+
+std::optional<FileID> SourceManager::loadFile(const std::string &file_name)
+{
+    // MemoryBuffer maps the file instead of reading it whenever that is possible.
+    auto buffer = llvm::MemoryBuffer::getFile(file_name);
+    if (!buffer)
+    {
+        return std::nullopt;
+    }
+    return addFile(std::move(*buffer), file_name);
+}
+
+FileID SourceManager::addBuffer(llvm::StringRef content, const std::string &file_name)
+{
+    return addFile(llvm::MemoryBuffer::getMemBufferCopy(content, file_name), file_name);
+}
+
+FileID SourceManager::addFile(std::unique_ptr<llvm::MemoryBuffer> buffer, const std::string &file_name)
+{
+    SourceFile &file = files.emplace_back();
+    file.name = file_name;
+    file.buffer = std::move(buffer);
+
+    file.line_offsets.push_back(0);
+    scanLineOffsets(file.buffer->getBuffer(), file.line_offsets);
+    return static_cast<FileID>(files.size() - 1);
+}
+
+void SourceManager::applyEdit(FileID id, const TextEdit &edit)
+{
+    SourceFile &file = files[id];
+    llvm::StringRef old = file.buffer->getBuffer();
+    int_t removed_end = edit.offset + edit.length;
+
+    auto buffer = llvm::WritableMemoryBuffer::getNewUninitMemBuffer(old.size() - edit.length + edit.text.size(), file.name);
+    char *content = buffer->getBufferStart();
+    std::copy(old.begin(), old.begin() + edit.offset, content);
+    std::copy(edit.text.begin(), edit.text.end(), content + edit.offset);
+    std::copy(old.begin() + removed_end, old.end(), content + edit.offset + edit.text.size());
+
+    // Only the lines within the edit change, every following line moves by the same amount.
+    std::vector<int_t> &offsets = file.line_offsets;
+    auto first = std::upper_bound(offsets.begin(), offsets.end(), edit.offset);
+    auto last = std::upper_bound(first, offsets.end(), removed_end);
+    for (auto it = last; it != offsets.end(); ++it)
+    {
+        *it = *it - edit.length + edit.text.size();
+    }
+    std::vector<int_t> inserted;
+    scanLineOffsets(edit.text, inserted);
+    for (int_t &offset : inserted)
+    {
+        offset += edit.offset;
+    }
+    offsets.insert(offsets.erase(first, last), inserted.begin(), inserted.end());
+
+    file.buffer = std::move(buffer);
+}
+
+llvm::StringRef SourceManager::getBuffer(FileID id) const
+{
+    return files[id].buffer->getBuffer();
+}
+
+llvm::StringRef SourceManager::getFileName(FileID id) const
+{
+    return files[id].name;
+}
+
+int_t SourceManager::getLineCount(FileID id) const
+{
+    return files[id].line_offsets.size();
+}
+
+int_t SourceManager::getLineOffset(FileID id, int_t line) const
+{
+    return files[id].line_offsets[line - 1];
+}
+
+std::pair<int_t, int_t> SourceManager::getLineAndColumn(FileID id, int_t offset) const
+{
+    const std::vector<int_t> &offsets = files[id].line_offsets;
+    int_t line = std::upper_bound(offsets.begin(), offsets.end(), offset) - offsets.begin();
+    return {line, offset - offsets[line - 1] + 1};
+}
+
+llvm::StringRef SourceManager::getLine(FileID id, int_t line) const
+{
+    const SourceFile &file = files[id];
+    if (line == 0 || line > file.line_offsets.size())
+    {
+        return {};
+    }
+    llvm::StringRef buffer = file.buffer->getBuffer();
+    int_t start = file.line_offsets[line - 1];
+    int_t end = line < file.line_offsets.size() ? file.line_offsets[line] - 1 : buffer.size();
+    return buffer.slice(start, end).rtrim('\r');
+}
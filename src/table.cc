@@ -1,96 +1,144 @@
 #include <table.hh>
 
-SymbolTable::SymbolTable(PrintGlobalState &state)
+// Fibonacci hashing, NameIDs are dense so the multiplication by 2^64 / golden ratio spreads
+// them over the table, the high bits of the product are the best mixed.
+static size_t hashName(NameID name, unsigned shift)
 {
-    this->state = state;
+    return static_cast<size_t>((static_cast<uint64_t>(name) * 0x9e3779b97f4a7c15ull) >> shift);
 }
 
-void SymbolTable::insert(const std::string &name, const Symbol &symbol)
+SymbolTable::SymbolTable(PrintGlobalState &state, const StringInterner &names)
+    : slots(64, Slot{0, NONE}), hash_shift(64 - 6), used_slots(0), state(state), names(names)
 {
-    if (!scopes.empty())
+}
+
+SymbolTable::Slot &SymbolTable::findSlot(NameID name)
+{
+    size_t mask = slots.size() - 1;
+    for (size_t i = hashName(name, hash_shift);; i = (i + 1) & mask)
     {
-        if (scopes.back().find(name) == scopes.back().end())
-        {
-            scopes.back()[name] = symbol;
-        }
-        else
+        if (slots[i].name == name || slots[i].name == 0)
         {
-            state.error("Redeclaration of identifier: " + name);
+            return slots[i];
         }
     }
-    else
-    {
-        state.error("No scope to insert into");
-    }
 }
 
-bool SymbolTable::lookup(const std::string &name, Symbol &symbol) const
+const SymbolTable::Entry *SymbolTable::find(NameID name) const
 {
-    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+    size_t mask = slots.size() - 1;
+    for (size_t i = hashName(name, hash_shift);; i = (i + 1) & mask)
     {
-        auto found = it->find(name);
-        if (found != it->end())
+        if (slots[i].name == name)
+        {
+            return slots[i].entry == NONE ? nullptr : &entries[slots[i].entry];
+        }
+        if (slots[i].name == 0)
         {
-            symbol = found->second;
-            return true;
+            return nullptr;
         }
     }
-    return false;
 }
 
-SymbolType SymbolTable::getType(const std::string &name) const
+void SymbolTable::grow()
 {
-    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+    std::vector<Slot> old(slots.size() * 2, Slot{0, NONE});
+    old.swap(slots);
+    hash_shift--;
+    for (const Slot &slot : old)
     {
-        auto found = it->find(name);
-        if (found != it->end())
+        if (slot.name != 0)
         {
-            return found->second.type;
+            findSlot(slot.name) = slot;
         }
     }
-    this->state.error("Symbol not found: " + name);
-    return SymbolType::ERR;
 }
 
-Symbol SymbolTable::get(const std::string &name) const
+void SymbolTable::insert(NameID name, const Symbol &symbol)
 {
-    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+    if (!scope_starts.empty())
     {
-        auto found = it->find(name);
-        if (found != it->end())
+        // Names stay in their slot once seen, keep the load factor at most one half.
+        if ((used_slots + 1) * 2 > slots.size())
+        {
+            grow();
+        }
+        Slot &slot = findSlot(name);
+        uint32_t depth = scope_starts.size();
+        if (slot.name == 0)
         {
-            return found->second;
+            slot.name = name;
+            used_slots++;
         }
+        else if (slot.entry != NONE && entries[slot.entry].depth == depth)
+        {
+            state.error("Redeclaration of identifier: " + names.get(name).str());
+            return;
+        }
+        entries.push_back(Entry{symbol, name, slot.entry, depth});
+        slot.entry = entries.size() - 1;
+    }
+    else
+    {
+        state.error("No scope to insert into");
     }
-    this->state.error("Symbol not found: " + name);
-    return {"", SymbolType::ERR, 0};
 }
 
-bool SymbolTable::check(const std::string &name) const
+bool SymbolTable::lookup(NameID name, Symbol &symbol) const
 {
-    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+    if (const Entry *entry = find(name))
     {
-        if (it->find(name) != it->end())
-        {
-            return true;
-        }
+        symbol = entry->symbol;
+        return true;
     }
     return false;
 }
 
+SymbolType SymbolTable::getType(NameID name) const
+{
+    if (const Entry *entry = find(name))
+    {
+        return entry->symbol.type;
+    }
+    this->state.error("Symbol not found: " + names.get(name).str());
+    return SymbolType::ERR;
+}
+
+Symbol SymbolTable::get(NameID name) const
+{
+    if (const Entry *entry = find(name))
+    {
+        return entry->symbol;
+    }
+    this->state.error("Symbol not found: " + names.get(name).str());
+    return Symbol{0, SymbolType::ERR, 0, 0, nullptr};
+}
+
+bool SymbolTable::check(NameID name) const
+{
+    return find(name) != nullptr;
+}
+
 void SymbolTable::enterScope()
 {
-    scopes.push_back({});
+    scope_starts.push_back(entries.size());
 }
 
 void SymbolTable::exitScope()
 {
-    if (!scopes.empty())
+    if (!scope_starts.empty())
     {
-        scopes.pop_back();
+        // Undo the declarations of the scope, innermost first.
+        for (size_t i = entries.size(); i > scope_starts.back(); i--)
+        {
+            const Entry &entry = entries[i - 1];
+            findSlot(entry.name).entry = entry.shadowed;
+        }
+        entries.resize(scope_starts.back());
+        scope_starts.pop_back();
     }
     else
     {
         state.error("No scope to exit from");
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,165 @@
+#include <threadpool.hh>
+
+// Worker the current thread belongs to, so jobs submitted by jobs stay local.
+static thread_local const ThreadPool *current_pool = nullptr;
+static thread_local unsigned current_worker = 0;
+
+ThreadPool::ThreadPool(unsigned threads)
+    : queued(0), pending(0), next(0), stopping(false)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < threads; i++)
+    {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (unsigned i = 0; i < threads; i++)
+    {
+        this->threads.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> job)
+{
+    unsigned target;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        target = current_pool == this ? current_worker : next++ % workers.size();
+        pending++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(workers[target]->mutex);
+        workers[target]->jobs.push_back(std::move(job));
+    }
+    {
+        // Counted under the lock so a worker about to sleep cannot miss it.
+        std::lock_guard<std::mutex> lock(mutex);
+        queued++;
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]()
+              { return pending == 0; });
+}
+
+void ThreadPool::runAll(size_t count, const std::function<void(size_t)> &job)
+{
+    size_t remaining = count; // Guarded by mutex, like pending.
+    for (size_t i = 0; i < count; i++)
+    {
+        submit([&, i]()
+               {
+            job(i);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--remaining == 0)
+            {
+                wake.notify_all();
+            } });
+    }
+    // From a job the own queue holds the jobs just submitted, from outside any queue is as good.
+    unsigned self = current_pool == this ? current_worker : 0;
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (remaining == 0)
+            {
+                return;
+            }
+        }
+        std::function<void()> next;
+        if (take(self, next))
+        {
+            execute(next);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&]()
+                  { return remaining == 0 || queued > 0; });
+    }
+}
+
+unsigned ThreadPool::size() const
+{
+    return workers.size();
+}
+
+bool ThreadPool::take(unsigned self, std::function<void()> &job)
+{
+    {
+        Worker &own = *workers[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty())
+        {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            queued--;
+            return true;
+        }
+    }
+    for (unsigned i = 1; i < workers.size(); i++)
+    {
+        Worker &victim = *workers[(self + i) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty())
+        {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::execute(std::function<void()> &job)
+{
+    job();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--pending == 0)
+    {
+        idle.notify_all();
+    }
+}
+
+void ThreadPool::run(unsigned self)
+{
+    current_pool = this;
+    current_worker = self;
+    while (true)
+    {
+        std::function<void()> job;
+        if (take(self, job))
+        {
+            execute(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [this]()
+                  { return stopping || queued > 0; });
+        if (stopping && queued == 0)
+        {
+            return;
+        }
+    }
+}
@@ -0,0 +1,168 @@
+#include <iomanip>
+#include <timing.hh>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/raw_ostream.h>
+#include <sys/resource.h>
+#include <time.h>
+
+static constexpr std::array<const char *, TimeReport::PHASE_COUNT> PHASE_NAMES = {
+    "Read files", "Lex", "Lex+Parse", "Parse", "AST cache", "Semantic analysis", "IR generation", "Optimization", "Code emission", "JIT and run"};
+
+static std::chrono::nanoseconds thread_cpu_time()
+{
+    timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+}
+
+static int64_t peak_rss_kb()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+TimeReport::Scope::Scope(TimeReport *report, Phase phase, llvm::StringRef detail)
+    : report(report), phase(phase)
+{
+    if (report)
+    {
+        this->detail = detail.str();
+        rss_start = peak_rss_kb();
+        cpu_start = thread_cpu_time();
+        wall_start = std::chrono::steady_clock::now();
+    }
+}
+
+TimeReport::Scope::~Scope()
+{
+    if (!report)
+    {
+        return;
+    }
+    auto wall = std::chrono::steady_clock::now() - wall_start;
+    auto cpu = thread_cpu_time() - cpu_start;
+    int64_t rss = peak_rss_kb() - rss_start;
+
+    std::lock_guard<std::mutex> lock(report->mutex);
+    Totals &totals = report->totals[phase];
+    totals.wall += wall;
+    totals.cpu += cpu;
+    totals.rss += rss;
+    totals.samples++;
+    report->events.push_back({phase, std::move(detail), llvm::get_threadid(), wall_start - report->start, wall});
+}
+
+TimeReport::TimeReport() : start(std::chrono::steady_clock::now()) {}
+
+void TimeReport::count(Phase phase, uint64_t items)
+{
+    if (phase == LEX)
+    {
+        count(phase, items, 0);
+    }
+    else
+    {
+        count(phase, 0, items);
+    }
+}
+
+void TimeReport::count(Phase phase, uint64_t tokens, uint64_t nodes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    totals[phase].tokens += tokens;
+    totals[phase].nodes += nodes;
+}
+
+void TimeReport::print(std::ostream &out) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto ms = [](std::chrono::nanoseconds time)
+    { return std::chrono::duration<double, std::milli>(time).count(); };
+
+    out << "===----------------------------------------------------------------------===\n"
+        << "                         Zurox Compilation Time Report\n"
+        << "===----------------------------------------------------------------------===\n"
+        << "  Total elapsed: " << std::fixed << std::setprecision(3) << ms(std::chrono::steady_clock::now() - start) << " ms\n\n"
+        << "  " << std::left << std::setw(20) << "Phase" << std::right << std::setw(12) << "Wall (ms)" << std::setw(12) << "CPU (ms)"
+        << std::setw(14) << "Peak RSS +KB" << std::setw(36) << "Throughput" << '\n';
+
+    Totals sum;
+    for (size_t phase = 0; phase < PHASE_COUNT; phase++)
+    {
+        const Totals &totals = this->totals[phase];
+        if (totals.samples == 0)
+        {
+            continue;
+        }
+        sum.wall += totals.wall;
+        sum.cpu += totals.cpu;
+        sum.rss += totals.rss;
+
+        std::string throughput;
+        auto rate = [&](uint64_t items, const char *unit)
+        {
+            if (!items || !totals.wall.count())
+            {
+                return;
+            }
+            double per_second = items / std::chrono::duration<double>(totals.wall).count();
+            throughput += (throughput.empty() ? "" : ", ") + std::to_string(static_cast<uint64_t>(per_second)) + unit;
+        };
+        rate(totals.tokens, " tokens/s");
+        rate(totals.nodes, " nodes/s");
+        out << "  " << std::left << std::setw(20) << PHASE_NAMES[phase] << std::right << std::setw(12) << ms(totals.wall) << std::setw(12)
+            << ms(totals.cpu) << std::setw(14) << totals.rss << std::setw(36) << throughput << '\n';
+    }
+    out << "  " << std::left << std::setw(20) << "Total" << std::right << std::setw(12) << ms(sum.wall) << std::setw(12) << ms(sum.cpu)
+        << std::setw(14) << sum.rss << '\n';
+    // Trees loaded from the AST cache count as nodes as well.
+    uint64_t tokens = totals[LEX].tokens + totals[LEX_PARSE].tokens;
+    uint64_t nodes = totals[LEX_PARSE].nodes + totals[PARSE].nodes + totals[CACHE].nodes;
+    if (tokens || nodes)
+    {
+        out << "\n  " << tokens << " tokens, " << nodes << " AST nodes\n";
+    }
+    out << std::defaultfloat << std::flush;
+}
+
+bool TimeReport::writeTrace(const std::string &path, std::string &error) const
+{
+    std::error_code code;
+    llvm::raw_fd_ostream out(path, code, llvm::sys::fs::OF_Text);
+    if (code)
+    {
+        error = "Unable to open '" + path + "': " + code.message();
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto us = [](std::chrono::nanoseconds time)
+    { return std::chrono::duration_cast<std::chrono::microseconds>(time).count(); };
+    llvm::json::OStream json(out);
+    json.object([&]()
+                {
+        json.attributeArray("traceEvents", [&]()
+                            {
+            for (const Event &event : events)
+            {
+                json.object([&]()
+                            {
+                    json.attribute("name", PHASE_NAMES[event.phase]);
+                    json.attribute("ph", "X");
+                    json.attribute("pid", 1);
+                    json.attribute("tid", static_cast<int64_t>(event.thread));
+                    json.attribute("ts", us(event.start));
+                    json.attribute("dur", us(event.duration));
+                    json.attributeObject("args", [&]()
+                                         { json.attribute("detail", event.detail); }); });
+            } });
+        json.attribute("displayTimeUnit", "ms"); });
+    return true;
+}
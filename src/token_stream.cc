@@ -0,0 +1,29 @@
+#include <token_stream.hh>
+#include <cassert>
+
+TokenStream::TokenStream(const std::vector<Token> &tokens)
+    : tokens(&tokens), lexer(nullptr), index(0), pulled(0), eof(TokenType::__EOF, 0, 0, std::string_view()) {}
+
+TokenStream::TokenStream(Lexer &lexer)
+    : tokens(nullptr), lexer(&lexer), index(0), pulled(0), eof(TokenType::__EOF, 0, 0, std::string_view()) {}
+
+void TokenStream::seek(int_t position)
+{
+    assert(!lexer && "Pulled tokens can not be revisited");
+    index = position;
+}
+
+int_t TokenStream::size() const
+{
+    return lexer ? pulled : tokens->size();
+}
+
+void TokenStream::pull(int_t position)
+{
+    assert(position - index < RING_SIZE && "Looking further ahead than the ring buffer holds");
+    while (pulled <= position)
+    {
+        ring[pulled & (RING_SIZE - 1)] = lexer->next();
+        pulled++;
+    }
+}
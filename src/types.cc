@@ -0,0 +1,106 @@
+#include <memory>
+#include <types.hh>
+
+TypeContext::TypeContext()
+    : error(Type::TYPE_ERROR, "<error>", 0, false), void_type(Type::TYPE_VOID, "void", 0, false)
+{
+    for (size_t i = 0; i < DATA_TYPES.size(); i++)
+    {
+        llvm::StringRef name(DATA_TYPES[i].data(), DATA_TYPES[i].size());
+        if (name == "bool")
+        {
+            primitives[i] = create<PrimitiveType>(Type::TYPE_BOOL, name, 1, false);
+        }
+        else if (name == "char")
+        {
+            primitives[i] = create<PrimitiveType>(Type::TYPE_CHAR, name, 8, false);
+        }
+        else
+        {
+            // Every other data type is spelled as its class followed by its width.
+            unsigned bits = 0;
+            name.drop_front().getAsInteger(10, bits);
+            Type::Kind kind = name[0] == 'f' ? Type::TYPE_FLOAT : Type::TYPE_INTEGER;
+            primitives[i] = create<PrimitiveType>(kind, name, bits, name[0] != 'u');
+        }
+    }
+}
+
+const PrimitiveType *TypeContext::getPrimitive(llvm::StringRef name) const
+{
+    std::optional<int_t> index = find_dt(std::string_view(name.data(), name.size()));
+    return index ? primitives[*index] : nullptr;
+}
+
+const PrimitiveType *TypeContext::getInteger(unsigned bits, bool is_signed) const
+{
+    if (bits == 1)
+    {
+        return getPrimitive("bool");
+    }
+    return getPrimitive((is_signed ? "i" : "u") + std::to_string(bits));
+}
+
+const PrimitiveType *TypeContext::getArithmeticType(const Type *left, const Type *right) const
+{
+    const PrimitiveType *i32 = getPrimitive("i32");
+    auto *lhs = llvm::isa<EnumType>(left) ? i32 : llvm::cast<PrimitiveType>(left);
+    auto *rhs = llvm::isa<EnumType>(right) ? i32 : llvm::cast<PrimitiveType>(right);
+    if (lhs->isFloat() != rhs->isFloat())
+    {
+        return lhs->isFloat() ? lhs : rhs;
+    }
+    const PrimitiveType *wider = lhs->bits >= rhs->bits ? lhs : rhs;
+    if (wider->isFloat() || (lhs->is_signed && rhs->is_signed) || !wider->is_signed)
+    {
+        return wider;
+    }
+    return getInteger(wider->bits, false);
+}
+
+const ArrayType *TypeContext::getArray(const Type *element, uint64_t size)
+{
+    const ArrayType *&array = arrays[{element, size}];
+    if (!array)
+    {
+        array = create<ArrayType>(element, size);
+    }
+    return array;
+}
+
+EnumType *TypeContext::createEnum(NameID name, llvm::ArrayRef<NameID> fields)
+{
+    NameID *data = allocator.Allocate<NameID>(fields.size());
+    std::uninitialized_copy(fields.begin(), fields.end(), data);
+    return create<EnumType>(name, llvm::ArrayRef<NameID>(data, fields.size()));
+}
+
+StructType *TypeContext::createStruct(NameID name)
+{
+    return create<StructType>(name);
+}
+
+void TypeContext::setFields(StructType *structure, llvm::ArrayRef<StructType::Field> fields)
+{
+    auto *data = allocator.Allocate<StructType::Field>(fields.size());
+    std::uninitialized_copy(fields.begin(), fields.end(), data);
+    structure->fields = llvm::ArrayRef<StructType::Field>(data, fields.size());
+}
+
+std::string TypeContext::getName(const Type *type, const StringInterner &names)
+{
+    switch (type->getKind())
+    {
+    case Type::TYPE_ENUM:
+        return "enum " + names.get(llvm::cast<EnumType>(type)->name).str();
+    case Type::TYPE_STRUCT:
+        return "struct " + names.get(llvm::cast<StructType>(type)->name).str();
+    case Type::TYPE_ARRAY:
+    {
+        auto *array = llvm::cast<ArrayType>(type);
+        return getName(array->element, names) + "[" + std::to_string(array->size) + "]";
+    }
+    default:
+        return llvm::cast<PrimitiveType>(type)->name.str();
+    }
+}
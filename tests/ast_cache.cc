@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <ast_cache.hh>
+#include <lexer.hh>
+#include <parser.hh>
+#include <llvm/Support/FileSystem.h>
+
+static const char *SOURCE = "enum Color { RED, GREEN }\n"
+                            "struct Point { i32 x, f64 y }\n"
+                            "fn add(i32 a, i32 b) -> i32 {\n"
+                            "    i32 sum = a + b * -a ^ 2;\n"
+                            "    i32 unset;\n"
+                            "    loop {\n"
+                            "        if (sum >= 10 && !(sum == 3)) { break; } elif (sum < 0) { continue; } else { sum += 1; }\n"
+                            "    }\n"
+                            "    match (sum) { 1: { ret 1; } _: { sum = 2; } }\n"
+                            "    { f64 inner = 1.5; }\n"
+                            "    ret sum;\n"
+                            "}\n"
+                            "fn nothing() {\n"
+                            "    ret;\n"
+                            "}\n";
+
+static ProgramNode *parse(SourceManager &sources, FileID file, ASTContext &context, StringInterner &names)
+{
+    PrintGlobalState print(sources);
+    std::ostringstream diagnostics;
+    print.setOutput(diagnostics);
+    Lexer lexer(sources, file, names, print);
+    Parser parser(lexer, context, file, print);
+    ProgramNode *program = parser.parse();
+    EXPECT_FALSE(print.hasEncounteredError()) << diagnostics.str();
+    return program;
+}
+
+TEST(AST_CACHE, ROUND_TRIP_)
+{
+    SourceManager sources;
+    FileID file = sources.addBuffer(SOURCE, "cache.zx");
+    ASTContext context;
+    StringInterner names;
+    ProgramNode *program = parse(sources, file, context, names);
+    std::string data = ASTCache::serialize(SOURCE, program, names);
+
+    // Loaded into an interner which already holds other names, so every NameID changes.
+    ASTContext loaded_context;
+    StringInterner loaded_names;
+    loaded_names.intern("unrelated");
+    ProgramNode *loaded = ASTCache::deserialize(data, SOURCE, loaded_context, loaded_names);
+    ASSERT_NE(loaded, nullptr);
+    ASSERT_EQ(loaded->declarations.size(), 4u);
+    auto *add = llvm::dyn_cast<FunctionDeclarationNode>(loaded->declarations[2]);
+    ASSERT_NE(add, nullptr);
+    EXPECT_EQ(loaded_names.get(add->name), "add");
+    EXPECT_EQ(add->return_type->name, "i32");
+    // Nodes keep the offsets diagnostics are reported at.
+    EXPECT_EQ(add->offset, llvm::StringRef(SOURCE).find("fn add"));
+    auto *sum = llvm::cast<VarDeclarationNode>(add->body->statements[0]);
+    EXPECT_EQ(sum->offset, llvm::StringRef(SOURCE).find("i32 sum"));
+    EXPECT_EQ(sum->initializer->offset, llvm::StringRef(SOURCE).find("+ b"));
+    EXPECT_EQ(loaded_context.getNodeCount(), context.getNodeCount());
+    // Written again, the tree gives the same bytes, so no node or name was lost.
+    EXPECT_EQ(ASTCache::serialize(SOURCE, loaded, loaded_names), data);
+}
+
+TEST(AST_CACHE, REJECTS_)
+{
+    SourceManager sources;
+    FileID file = sources.addBuffer(SOURCE, "cache.zx");
+    ASTContext context;
+    StringInterner names;
+    std::string data = ASTCache::serialize(SOURCE, parse(sources, file, context, names), names);
+
+    ASTContext loaded_context;
+    EXPECT_EQ(ASTCache::deserialize(data, std::string(SOURCE) + " ", loaded_context, names), nullptr);
+    for (size_t size = 0; size < data.size(); size++)
+    {
+        EXPECT_EQ(ASTCache::deserialize(llvm::StringRef(data).take_front(size), SOURCE, loaded_context, names), nullptr) << size;
+    }
+    // Damaged bytes must never crash the reader, whether or not they are noticed.
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        std::string damaged = data;
+        damaged[i] ^= 0x5a;
+        ASTCache::deserialize(damaged, SOURCE, loaded_context, names);
+    }
+}
+
+TEST(AST_CACHE, STORE_LOAD_)
+{
+    std::string directory = ::testing::TempDir() + "zurox-ast-cache";
+    llvm::sys::fs::remove_directories(directory);
+    ASTCache cache(directory);
+
+    SourceManager sources;
+    FileID file = sources.addBuffer(SOURCE, "cache.zx");
+    ASTContext context;
+    StringInterner names;
+    EXPECT_EQ(cache.load(SOURCE, context, names), nullptr);
+    std::string error;
+    ASSERT_TRUE(cache.store(SOURCE, parse(sources, file, context, names), names, error)) << error;
+
+    ASTContext loaded_context;
+    StringInterner loaded_names;
+    ProgramNode *loaded = cache.load(SOURCE, loaded_context, loaded_names);
+    ASSERT_NE(loaded, nullptr);
+    EXPECT_EQ(loaded->declarations.size(), 4u);
+    EXPECT_EQ(cache.load("fn changed() {}", loaded_context, loaded_names), nullptr);
+    llvm::sys::fs::remove_directories(directory);
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <ast_visitor.hh>
+
+TEST(AST_VISITOR, CASTS_)
+{
+    ASTContext context;
+    ExpressionNode *identifier = context.create<IdentifierNode>(1);
+    ExpressionNode *binary = context.create<BinaryExprNode>(identifier, Operator::ADD, identifier);
+    StatementNode *block = context.create<BlockNode>(llvm::ArrayRef<StatementNode *>());
+    ASTNode *type = context.create<TypeNode>("i32");
+
+    EXPECT_TRUE(llvm::isa<IdentifierNode>(identifier));
+    EXPECT_TRUE(llvm::isa<ExpressionNode>(binary));
+    EXPECT_FALSE(llvm::isa<StatementNode>(static_cast<ASTNode *>(binary)));
+    EXPECT_TRUE(llvm::isa<StatementNode>(block));
+    EXPECT_FALSE(llvm::isa<ExpressionNode>(type));
+    EXPECT_FALSE(llvm::isa<DeclarationNode>(type));
+    EXPECT_EQ(llvm::dyn_cast<BinaryExprNode>(identifier), nullptr);
+    EXPECT_EQ(llvm::cast<BinaryExprNode>(binary)->left, identifier);
+}
+
+// Names the function a node was dispatched to, handling only some classes itself.
+class Describe : public ConstASTVisitor<Describe, std::string>
+{
+public:
+    std::string visitBinaryExprNode(const BinaryExprNode *) { return "binary"; }
+    std::string visitExpressionNode(const ExpressionNode *) { return "expression"; }
+    std::string visitDeclarationNode(const DeclarationNode *) { return "declaration"; }
+    std::string visitNode(const ASTNode *) { return "node"; }
+};
+
+TEST(AST_VISITOR, DISPATCH_)
+{
+    ASTContext context;
+    ExpressionNode *identifier = context.create<IdentifierNode>(1);
+    Describe describe;
+    EXPECT_EQ(describe.visit(context.create<BinaryExprNode>(identifier, Operator::ADD, identifier)), "binary");
+    EXPECT_EQ(describe.visit(identifier), "expression");
+    EXPECT_EQ(describe.visit(context.create<EnumDeclarationNode>(2, llvm::ArrayRef<NameID>())), "declaration");
+    EXPECT_EQ(describe.visit(context.create<BreakStatementNode>()), "node");
+    EXPECT_EQ(describe.visit(context.create<TypeNode>("i32")), "node");
+}
+
+// Renames every identifier of an expression in place.
+class Rename : public ASTVisitor<Rename>
+{
+public:
+    void visitIdentifierNode(IdentifierNode *identifier) { identifier->name = 7; }
+    void visitBinaryExprNode(BinaryExprNode *binary)
+    {
+        visit(binary->left);
+        visit(binary->right);
+    }
+    void visitUnaryExprNode(UnaryExprNode *unary) { visit(unary->operand); }
+};
+
+TEST(AST_VISITOR, REWRITE_)
+{
+    ASTContext context;
+    auto *left = context.create<IdentifierNode>(1);
+    auto *right = context.create<IdentifierNode>(2);
+    auto *expression = context.create<BinaryExprNode>(left, Operator::MUL, context.create<UnaryExprNode>(Operator::SUB, right));
+    Rename().visit(expression);
+    EXPECT_EQ(left->name, 7u);
+    EXPECT_EQ(right->name, 7u);
+}
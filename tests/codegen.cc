@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <llvm/IR/Instructions.h>
+#include "helpers.hh"
+
+// The single instruction of a function the optimizer reduced to returning a constant.
+static llvm::Constant *returned_constant(llvm::Module &module, llvm::StringRef name)
+{
+    llvm::Function *function = module.getFunction(name);
+    EXPECT_TRUE(function);
+    auto *ret = llvm::dyn_cast<llvm::ReturnInst>(function->getEntryBlock().getTerminator());
+    return ret ? llvm::dyn_cast<llvm::Constant>(ret->getReturnValue()) : nullptr;
+}
+
+TEST(CODEGEN, FUNCTIONS_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend, "fn add(i32 a, i64 b) -> i64 {\n    ret a + b;\n}\nfn nothing() {\n    ret;\n}\n", "codegen.zx", ANALYZE | GENERATE, O0);
+    ASSERT_TRUE(result.module);
+    llvm::Function *add = result.module->getFunction("add");
+    ASSERT_TRUE(add);
+    EXPECT_TRUE(add->getReturnType()->isIntegerTy(64));
+    EXPECT_TRUE(add->getArg(0)->getType()->isIntegerTy(32));
+    EXPECT_TRUE(result.module->getFunction("nothing")->getReturnType()->isVoidTy());
+    EXPECT_EQ(result.module->getDataLayout(), result.target->createDataLayout());
+
+    // The end of a function with a return type, which semantic analysis found unreachable, is marked so.
+    result = compile(frontend, "fn spin(i32 a) -> i32 {\n    loop {\n        if (a) { ret a; }\n    }\n}\n", "codegen.zx", ANALYZE | GENERATE, O0);
+    ASSERT_TRUE(result.module);
+    EXPECT_TRUE(llvm::isa<llvm::UnreachableInst>(result.module->getFunction("spin")->back().getTerminator()));
+}
+
+TEST(CODEGEN, OPTIMIZED_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend,
+                              "fn main() -> i32 {\n"
+                              "    i32 x = 7;\n"
+                              "    u8 y = 250 + 10;\n"
+                              "    loop {\n"
+                              "        if (x - 7) {\n"
+                              "            continue;\n"
+                              "        } elif (y) {\n"
+                              "            break;\n"
+                              "        }\n"
+                              "    }\n"
+                              "    ret -x % 4 * y;\n"
+                              "}\n"
+                              "fn half() -> f32 {\n"
+                              "    ret 1 / 2.0;\n"
+                              "}\n",
+                              "codegen.zx", ANALYZE | GENERATE, O2);
+    ASSERT_TRUE(result.module);
+    auto *value = llvm::dyn_cast_or_null<llvm::ConstantInt>(returned_constant(*result.module, "main"));
+    ASSERT_TRUE(value);
+    EXPECT_EQ(value->getSExtValue(), -3 * 4);
+    auto *half = llvm::dyn_cast_or_null<llvm::ConstantFP>(returned_constant(*result.module, "half"));
+    ASSERT_TRUE(half);
+    EXPECT_EQ(half->getValueAPF().convertToFloat(), 0.5f);
+}
+
+TEST(CODEGEN, OPERATORS_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend,
+                              "fn power() -> i32 {\n"
+                              "    ret -2 ^ 3 ^ 2 + 3 ^ -1 + (-1) ^ -3;\n"
+                              "}\n"
+                              "fn assign() -> i32 {\n"
+                              "    i32 x = 5;\n"
+                              "    x += 3;\n"
+                              "    x = x * 2 | 1;\n"
+                              "    ++x;\n"
+                              "    ret x << 1 >> 2;\n"
+                              "}\n"
+                              "fn compare() -> bool {\n"
+                              "    i32 x = 3;\n"
+                              "    ret x < 4 && x >= 3 && !(x == 4) || x != x;\n"
+                              "}\n",
+                              "codegen.zx", ANALYZE | GENERATE, O2);
+    ASSERT_TRUE(result.module);
+    auto *power = llvm::dyn_cast_or_null<llvm::ConstantInt>(returned_constant(*result.module, "power"));
+    ASSERT_TRUE(power);
+    EXPECT_EQ(power->getSExtValue(), -513);
+    auto *assign = llvm::dyn_cast_or_null<llvm::ConstantInt>(returned_constant(*result.module, "assign"));
+    ASSERT_TRUE(assign);
+    EXPECT_EQ(assign->getSExtValue(), 9);
+    auto *compare = llvm::dyn_cast_or_null<llvm::ConstantInt>(returned_constant(*result.module, "compare"));
+    ASSERT_TRUE(compare);
+    EXPECT_TRUE(compare->isOne());
+}
+
+TEST(CODEGEN, CONVERSIONS_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend,
+                              "fn to_unsigned(f64 x) -> u32 {\n"
+                              "    ret x;\n"
+                              "}\n"
+                              "fn to_signed(f64 x) -> i32 {\n"
+                              "    ret x;\n"
+                              "}\n"
+                              "fn to_bool(f64 x) -> bool {\n"
+                              "    ret x;\n"
+                              "}\n",
+                              "codegen.zx", ANALYZE | GENERATE, O0);
+    ASSERT_TRUE(result.module);
+    auto converted = [&](llvm::StringRef name)
+    {
+        return llvm::cast<llvm::ReturnInst>(result.module->getFunction(name)->getEntryBlock().getTerminator())->getReturnValue();
+    };
+    EXPECT_TRUE(llvm::isa<llvm::FPToUIInst>(converted("to_unsigned")));
+    EXPECT_TRUE(llvm::isa<llvm::FPToSIInst>(converted("to_signed")));
+    // NaN is true, as it is for the constant evaluator.
+    auto *truth = llvm::dyn_cast<llvm::FCmpInst>(converted("to_bool"));
+    ASSERT_TRUE(truth);
+    EXPECT_EQ(truth->getPredicate(), llvm::FCmpInst::FCMP_UNE);
+
+    // Values past the signed maximum still fit an unsigned integer.
+    result = compile(frontend,
+                     "fn big() -> u32 {\n"
+                     "    f64 x = 3000000000.5;\n"
+                     "    u32 y = x;\n"
+                     "    ret y;\n"
+                     "}\n",
+                     "codegen.zx", ANALYZE | GENERATE, O2);
+    ASSERT_TRUE(result.module);
+    auto *big = llvm::dyn_cast_or_null<llvm::ConstantInt>(returned_constant(*result.module, "big"));
+    ASSERT_TRUE(big);
+    EXPECT_EQ(big->getZExtValue(), 3000000000u);
+}
+
+TEST(CODEGEN, KEYWORD_LITERALS_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend,
+                              "fn yes() -> bool {\n"
+                              "    ret true && !false;\n"
+                              "}\n"
+                              "fn none() -> i64 {\n"
+                              "    i64 x = null;\n"
+                              "    ret x + 1;\n"
+                              "}\n",
+                              "codegen.zx", ANALYZE | GENERATE, O2);
+    ASSERT_TRUE(result.module);
+    auto *yes = llvm::dyn_cast_or_null<llvm::ConstantInt>(returned_constant(*result.module, "yes"));
+    ASSERT_TRUE(yes);
+    EXPECT_TRUE(yes->isOne());
+    auto *none = llvm::dyn_cast_or_null<llvm::ConstantInt>(returned_constant(*result.module, "none"));
+    ASSERT_TRUE(none);
+    EXPECT_EQ(none->getSExtValue(), 1);
+}
+
+TEST(CODEGEN, STRUCTS_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend,
+                              "struct Point { i32 x, struct Size size }\n"
+                              "struct Size { i64 width, f64 height }\n"
+                              "fn copy(struct Point p) -> struct Point {\n"
+                              "    struct Point q = p;\n"
+                              "    struct Point r;\n"
+                              "    r = q;\n"
+                              "    ret r;\n"
+                              "}\n",
+                              "codegen.zx", ANALYZE | GENERATE, O0);
+    ASSERT_TRUE(result.module);
+    // Structs are lowered to LLVM structs of their fields, the same type wherever they are used.
+    llvm::Function *copy = result.module->getFunction("copy");
+    ASSERT_TRUE(copy);
+    auto *point = llvm::dyn_cast<llvm::StructType>(copy->getReturnType());
+    ASSERT_TRUE(point);
+    EXPECT_EQ(copy->getArg(0)->getType(), point);
+    ASSERT_EQ(point->getNumElements(), 2u);
+    EXPECT_TRUE(point->getElementType(0)->isIntegerTy(32));
+    auto *size = llvm::dyn_cast<llvm::StructType>(point->getElementType(1));
+    ASSERT_TRUE(size);
+    EXPECT_TRUE(size->getElementType(0)->isIntegerTy(64));
+    EXPECT_TRUE(size->getElementType(1)->isDoubleTy());
+}
+
+TEST(CODEGEN, ERRORS_)
+{
+    Frontend frontend;
+    EXPECT_FALSE(compile(frontend, "fn f() -> i32 {\n    ret x;\n}\n", "codegen.zx", ANALYZE | GENERATE, O0).errors.empty());
+    EXPECT_FALSE(compile(frontend, "fn f() {\n    ret 1;\n}\n", "codegen.zx", ANALYZE | GENERATE, O0).errors.empty());
+    EXPECT_FALSE(compile(frontend, "fn f() {\n    break;\n}\n", "codegen.zx", ANALYZE | GENERATE, O0).errors.empty());
+    EXPECT_FALSE(compile(frontend, "fn f() {\n}\nfn f() {\n}\n", "codegen.zx", ANALYZE | GENERATE, O0).errors.empty());
+    EXPECT_FALSE(compile(frontend, "fn f() {\n    1 = 2;\n}\n", "codegen.zx", ANALYZE | GENERATE, O0).errors.empty());
+    EXPECT_FALSE(compile(frontend, "fn f() {\n    f64 x = 1.5 << 2;\n}\n", "codegen.zx", ANALYZE | GENERATE, O0).errors.empty());
+
+    // Errors point at the offending identifier and operator.
+    Compiled result = compile(frontend, "fn f() {\n    i32 a = 1;\n    a = a + missing;\n    f64 x = 1.5 << a;\n}\n", "codegen.zx", ANALYZE | GENERATE, O0);
+    std::vector<std::pair<int64_t, int64_t>> expected = {{3, 13}, {4, 17}};
+    EXPECT_EQ(diagnostic_locations(result.diagnostics), expected);
+}
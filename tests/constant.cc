@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+#include <llvm/IR/Instructions.h>
+#include "helpers.hh"
+
+static ExpressionNode *initializer(const ProgramNode *program, size_t index)
+{
+    auto *function = llvm::cast<FunctionDeclarationNode>(program->declarations[0]);
+    return llvm::cast<VarDeclarationNode>(function->body->statements[index])->initializer;
+}
+
+TEST(CONSTANT, FOLD_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend, "fn f(i32 x) {\n"
+                              "    i32 a = 2 * 3 + 4;\n"
+                              "    i8 b = -128;\n"
+                              "    f64 c = 1 / 4.0;\n"
+                              "    bool d = 3 < 4 && !(2.5 > 1);\n"
+                              "    u64 e = 1 << 40;\n"
+                              "    i32 g = x + 2 * 3;\n"
+                              "    i128 h = 2 ^ 100;\n"
+                              "    i32 i = 7 % -3 + (-1) ^ -3;\n"
+                              "}\n",
+                              "constant.zx", ANALYZE | FOLD);
+    EXPECT_TRUE(result.errors.empty());
+    auto literal = [&](size_t index)
+    {
+        return llvm::dyn_cast<LiteralNode>(initializer(result.program, index));
+    };
+    ASSERT_TRUE(literal(0));
+    EXPECT_EQ(literal(0)->value, "10");
+    EXPECT_EQ(literal(0)->value_type, frontend.types.getPrimitive("i32"));
+    // Negative constants are written as their bits, in the width of their type.
+    ASSERT_TRUE(literal(1));
+    EXPECT_EQ(literal(1)->value, "128");
+    EXPECT_EQ(literal(1)->value_type, frontend.types.getPrimitive("i8"));
+    ASSERT_TRUE(literal(2));
+    EXPECT_EQ(literal(2)->type, TokenType::TKL_FLOAT);
+    EXPECT_EQ(literal(2)->value_type, frontend.types.getPrimitive("f64"));
+    ASSERT_TRUE(literal(3));
+    EXPECT_EQ(literal(3)->value, "0");
+    EXPECT_EQ(literal(3)->value_type, frontend.types.getPrimitive("bool"));
+    ASSERT_TRUE(literal(4));
+    EXPECT_EQ(literal(4)->value, "1099511627776");
+    // Only the constant operand of an expression which is not constant is folded.
+    auto *sum = llvm::cast<BinaryExprNode>(initializer(result.program, 5));
+    EXPECT_TRUE(llvm::isa<IdentifierNode>(sum->left));
+    ASSERT_TRUE(llvm::isa<LiteralNode>(sum->right));
+    EXPECT_EQ(llvm::cast<LiteralNode>(sum->right)->value, "6");
+    ASSERT_TRUE(literal(6));
+    EXPECT_EQ(literal(6)->value, "1267650600228229401496703205376");
+    // The remainder takes the sign of the dividend, and a negative power of -1 is not truncated to 0.
+    ASSERT_TRUE(literal(7));
+    EXPECT_EQ(literal(7)->value, "0");
+}
+
+TEST(CONSTANT, ERRORS_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend, "fn f(i32 x) {\n"
+                              "    u8 a = 250 + 10;\n"
+                              "    i8 b = 200;\n"
+                              "    u32 c = -1;\n"
+                              "    i32 d = 1 / (2 - 2);\n"
+                              "    i32 e = 1 << 40;\n"
+                              "    i64 g = 10 ^ 30;\n"
+                              "    i32 h = x % 0;\n"
+                              "    i32 i = 2147483647 + 1;\n"
+                              "}\n",
+                              "constant.zx", ANALYZE | FOLD);
+    std::vector<std::string> expected = {
+        "Constant expression overflows 'u8'.",
+        "Constant '200' overflows 'i8'.",
+        "Constant '-1' overflows 'u32'.",
+        "Division by zero in constant expression.",
+        "Shift by 40 is out of range for 'i32'.",
+        "Constant expression overflows 'i64'.",
+        "Constant expression overflows 'i32'.",
+    };
+    EXPECT_EQ(result.errors, expected);
+    // Literals are reported where they are written, operations at their operator.
+    std::vector<std::pair<int64_t, int64_t>> locations = {{2, 16}, {3, 12}, {4, 14}, {5, 15}, {6, 15}, {7, 16}, {9, 24}};
+    EXPECT_EQ(diagnostic_locations(result.diagnostics), locations);
+}
+
+TEST(CONSTANT, LIMITS_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend, "fn f() {\n"
+                              "    u64 a = 18446744073709551615;\n"
+                              "    i128 b = 170141183460469231731687303715884105727;\n"
+                              "    i128 c = -170141183460469231731687303715884105728;\n"
+                              "    u64 d = 18446744073709551616;\n"
+                              "    i128 e = 170141183460469231731687303715884105728;\n"
+                              "}\n",
+                              "constant.zx", ANALYZE | FOLD);
+    // Literals are lexed whatever their size, only the type they are given limits them.
+    std::vector<std::string> expected = {
+        "Constant '18446744073709551616' overflows 'u64'.",
+        "Constant '170141183460469231731687303715884105728' overflows 'i128'.",
+    };
+    EXPECT_EQ(result.errors, expected);
+    auto *a = llvm::dyn_cast<LiteralNode>(initializer(result.program, 0));
+    ASSERT_TRUE(a);
+    EXPECT_EQ(a->value, "18446744073709551615");
+    auto *b = llvm::dyn_cast<LiteralNode>(initializer(result.program, 1));
+    ASSERT_TRUE(b);
+    EXPECT_EQ(b->value, "170141183460469231731687303715884105727");
+    // Written as its bits, 2^127 is the minimum of i128.
+    auto *c = llvm::dyn_cast<LiteralNode>(initializer(result.program, 2));
+    ASSERT_TRUE(c);
+    EXPECT_EQ(c->value, "170141183460469231731687303715884105728");
+}
+
+TEST(CONSTANT, SHORT_CIRCUIT_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend, "fn f(i32 x) {\n"
+                              "    bool a = 1 > 2 && 1 / 0 == 0;\n"
+                              "    bool b = 1 < 2 || 1 << 40 == 0;\n"
+                              "    bool c = 1 < 2 && 1 / 0 == 0;\n"
+                              "}\n",
+                              "constant.zx", ANALYZE | FOLD);
+    // The right operand is only evaluated when the left one does not decide.
+    std::vector<std::string> expected = {"Division by zero in constant expression."};
+    EXPECT_EQ(result.errors, expected);
+    auto *a = llvm::dyn_cast<LiteralNode>(initializer(result.program, 0));
+    ASSERT_TRUE(a);
+    EXPECT_EQ(a->value, "0");
+    auto *b = llvm::dyn_cast<LiteralNode>(initializer(result.program, 1));
+    ASSERT_TRUE(b);
+    EXPECT_EQ(b->value, "1");
+}
+
+TEST(CONSTANT, EVALUATE_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend, "fn f() {\n"
+                              "    f32 a = 0.1 + 0.2;\n"
+                              "    char b = 'A' + 1;\n"
+                              "}\n",
+                              "constant.zx", ANALYZE | FOLD);
+    PrintGlobalState print;
+    ConstantEvaluator evaluator(frontend.context, frontend.types, print, FileID());
+    std::optional<ConstantValue> sum = evaluator.evaluate(initializer(result.program, 0));
+    ASSERT_TRUE(sum);
+    // Computed in single precision, as code generation would.
+    EXPECT_EQ(sum->type, frontend.types.getPrimitive("f32"));
+    EXPECT_EQ(sum->real.convertToFloat(), 0.1f + 0.2f);
+    std::optional<ConstantValue> letter = evaluator.evaluate(initializer(result.program, 1));
+    ASSERT_TRUE(letter);
+    EXPECT_EQ(letter->type, frontend.types.getPrimitive("char"));
+    EXPECT_EQ(letter->integer, 'B');
+}
+
+TEST(CONSTANT, CODEGEN_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend, "fn main() -> i64 {\n"
+                              "    ret (1 << 40) - 3 * 5;\n"
+                              "}\n",
+                              "constant.zx", ANALYZE | FOLD | GENERATE);
+    ASSERT_TRUE(result.errors.empty());
+    ASSERT_TRUE(result.module);
+    // Without optimizations the function still returns a single constant.
+    llvm::Function *main = result.module->getFunction("main");
+    auto *ret = llvm::cast<llvm::ReturnInst>(main->getEntryBlock().getTerminator());
+    auto *value = llvm::dyn_cast<llvm::ConstantInt>(ret->getReturnValue());
+    ASSERT_TRUE(value);
+    EXPECT_EQ(value->getSExtValue(), (int64_t(1) << 40) - 15);
+}
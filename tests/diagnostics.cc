@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <driver.hh>
+#include <print.hh>
+#include <llvm/Support/JSON.h>
+
+static int64_t integer(const llvm::json::Object *object, llvm::StringRef key)
+{
+    auto value = object->getInteger(key);
+    return value ? *value : -1;
+}
+
+TEST(DIAGNOSTICS, COUNTS_)
+{
+    std::ostringstream output;
+    PrintGlobalState print;
+    print.setOutput(output);
+    print.setErrorLimit(2);
+    print.warn("first");
+    print.info("second");
+    for (int i = 0; i < 4; i++)
+    {
+        print.error("error " + std::to_string(i));
+    }
+    EXPECT_EQ(print.getCount(Severity::WARNING), 1);
+    EXPECT_EQ(print.getCount(Severity::INFO), 1);
+    // Errors beyond the limit are counted, but not written.
+    EXPECT_EQ(print.getCount(Severity::ERROR), 4);
+    EXPECT_TRUE(print.errorLimitReached());
+    EXPECT_EQ(output.str().find("error 2"), std::string::npos);
+    EXPECT_NE(output.str().find("too many errors"), std::string::npos);
+    print.reset();
+    EXPECT_EQ(print.getCount(Severity::ERROR), 0);
+}
+
+TEST(DIAGNOSTICS, JSON_)
+{
+    SourceManager sources;
+    FileID file = sources.addBuffer("fn f() {\n    ret \xff;\n}\n", "diagnostics.zx");
+    std::ostringstream output;
+    PrintGlobalState print(sources);
+    print.setOutput(output);
+    print.setFormat(DiagnosticFormat::JSON);
+    print.error("Unexpected '\xff'.", 17, file);
+    print.warn("Unlocated.");
+
+    std::istringstream lines(output.str());
+    std::string line;
+    ASSERT_TRUE(std::getline(lines, line));
+    llvm::Expected<llvm::json::Value> error = llvm::json::parse(line);
+    ASSERT_TRUE(bool(error)) << llvm::toString(error.takeError());
+    const llvm::json::Object *object = error->getAsObject();
+    EXPECT_EQ(object->getString("severity"), llvm::StringRef("error"));
+    EXPECT_EQ(object->getString("file"), llvm::StringRef("diagnostics.zx"));
+    EXPECT_EQ(integer(object, "line"), 2);
+    EXPECT_EQ(integer(object, "column"), 9);
+    // Invalid UTF-8 of the source is replaced, the line is still valid JSON.
+    EXPECT_TRUE(object->getString("message"));
+
+    ASSERT_TRUE(std::getline(lines, line));
+    llvm::Expected<llvm::json::Value> warning = llvm::json::parse(line);
+    ASSERT_TRUE(bool(warning)) << llvm::toString(warning.takeError());
+    EXPECT_EQ(warning->getAsObject()->getString("severity"), llvm::StringRef("warning"));
+    EXPECT_FALSE(warning->getAsObject()->get("line"));
+    EXPECT_FALSE(std::getline(lines, line));
+}
+
+TEST(DIAGNOSTICS, WRITER_ORDER_)
+{
+    std::ostringstream output;
+    {
+        DiagnosticsWriter writer(output, DiagnosticFormat::TEXT);
+        std::vector<std::thread> threads;
+        // Handed over in reverse, written in order.
+        for (size_t i = 0; i < 8; i++)
+        {
+            threads.emplace_back([&writer, i]()
+                                 {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5 * (8 - i)));
+                writer.write(i, std::to_string(i) + "\n"); });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+    }
+    EXPECT_EQ(output.str(), "0\n1\n2\n3\n4\n5\n6\n7\n");
+}
+
+TEST(DIAGNOSTICS, SARIF_)
+{
+    std::vector<std::string> files;
+    for (int i = 0; i < 3; i++)
+    {
+        std::string name = "sarif_" + std::to_string(i) + ".zx";
+        std::ofstream out(name);
+        out << (i == 1 ? "fn f() {\n}\n" : "fn f() {\n    i32 x = ;\n}\n");
+        files.push_back(name);
+    }
+
+    DriverOptions options;
+    options.stage = C;
+    options.jobs = 3;
+    options.diagnostics_format = DiagnosticFormat::SARIF;
+    std::ostringstream diagnostics;
+    Driver driver(options, diagnostics);
+    EXPECT_EQ(driver.run(files), 1);
+
+    // The results of every file form a single valid log.
+    llvm::Expected<llvm::json::Value> log = llvm::json::parse(diagnostics.str());
+    ASSERT_TRUE(bool(log)) << llvm::toString(log.takeError()) << diagnostics.str();
+    EXPECT_EQ(log->getAsObject()->getString("version"), llvm::StringRef("2.1.0"));
+    const llvm::json::Array *results = log->getAsObject()->getArray("runs")->front().getAsObject()->getArray("results");
+    ASSERT_TRUE(results);
+    ASSERT_EQ(results->size(), 2u);
+    const llvm::json::Object *result = (*results)[1].getAsObject();
+    EXPECT_EQ(result->getString("level"), llvm::StringRef("error"));
+    const llvm::json::Object *location = result->getArray("locations")->front().getAsObject()->getObject("physicalLocation");
+    EXPECT_EQ(location->getObject("artifactLocation")->getString("uri"), llvm::StringRef("sarif_2.zx"));
+    EXPECT_EQ(integer(location->getObject("region"), "startLine"), 2);
+
+    for (const std::string &name : files)
+    {
+        std::remove(name.c_str());
+    }
+}
+
+TEST(DIAGNOSTICS, SARIF_TIME_REPORT_)
+{
+    DriverOptions options;
+    options.stage = C;
+    options.time_report = true;
+    options.diagnostics_format = DiagnosticFormat::SARIF;
+    std::ostringstream diagnostics;
+    Driver driver(options, diagnostics);
+    EXPECT_EQ(driver.run({"sarif_time.zx"}), 1);
+
+    // Rejected instead of printing a table after the log.
+    llvm::Expected<llvm::json::Value> log = llvm::json::parse(diagnostics.str());
+    ASSERT_TRUE(bool(log)) << llvm::toString(log.takeError()) << diagnostics.str();
+    const llvm::json::Array *results = log->getAsObject()->getArray("runs")->front().getAsObject()->getArray("results");
+    ASSERT_TRUE(results);
+    ASSERT_EQ(results->size(), 1u);
+    EXPECT_EQ((*results)[0].getAsObject()->getString("level"), llvm::StringRef("error"));
+}
@@ -0,0 +1,165 @@
+#ifndef TESTS_HELPERS_HH
+#define TESTS_HELPERS_HH
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <ast.hh>
+#include <backend.hh>
+#include <codegen.hh>
+#include <constant.hh>
+#include <lexer.hh>
+#include <parser.hh>
+#include <sema.hh>
+#include <llvm/Support/JSON.h>
+
+// A file of the number of functions, each followed by an enum and a struct, with comments in between.
+inline std::string make_source(int functions)
+{
+    std::string source;
+    for (int i = 0; i < functions; i++)
+    {
+        std::string n = std::to_string(i);
+        source += "/* function " + n + " */\nfn fn_" + n + "(i32 a, i32 b) {\n    i32 x = a + b * " + n + ";\n"
+                  "    loop { if (x > 0) { break; } }\n    ret x;\n}\n\nenum E" + n + " { A, B }\n// \"comment\"\n"
+                  "struct S" + n + " { i32 a, f32 b }\n";
+    }
+    return source;
+}
+
+inline NameID declaration_name(const DeclarationNode *declaration)
+{
+    if (auto *function = llvm::dyn_cast<FunctionDeclarationNode>(declaration))
+    {
+        return function->name;
+    }
+    if (auto *enumeration = llvm::dyn_cast<EnumDeclarationNode>(declaration))
+    {
+        return enumeration->name;
+    }
+    return llvm::cast<StructDeclarationNode>(declaration)->name;
+}
+
+// The messages of the errors among diagnostics written as DiagnosticFormat::JSON, in order.
+inline std::vector<std::string> error_messages(const std::string &diagnostics)
+{
+    std::vector<std::string> errors;
+    std::istringstream lines(diagnostics);
+    for (std::string line; std::getline(lines, line);)
+    {
+        llvm::Expected<llvm::json::Value> diagnostic = llvm::json::parse(line);
+        if (!diagnostic)
+        {
+            ADD_FAILURE() << llvm::toString(diagnostic.takeError()) << ": " << line;
+            continue;
+        }
+        const llvm::json::Object *object = diagnostic->getAsObject();
+        if (object && object->getString("severity") == llvm::StringRef("error"))
+        {
+            auto message = object->getString("message");
+            errors.push_back(message ? message->str() : std::string());
+        }
+    }
+    return errors;
+}
+
+// The line and column of every located diagnostic written as DiagnosticFormat::JSON, in order.
+inline std::vector<std::pair<int64_t, int64_t>> diagnostic_locations(const std::string &diagnostics)
+{
+    std::vector<std::pair<int64_t, int64_t>> locations;
+    std::istringstream lines(diagnostics);
+    for (std::string line; std::getline(lines, line);)
+    {
+        llvm::Expected<llvm::json::Value> diagnostic = llvm::json::parse(line);
+        if (!diagnostic)
+        {
+            ADD_FAILURE() << llvm::toString(diagnostic.takeError()) << ": " << line;
+            continue;
+        }
+        const llvm::json::Object *object = diagnostic->getAsObject();
+        if (!object)
+        {
+            continue;
+        }
+        auto line_number = object->getInteger("line");
+        auto column = object->getInteger("column");
+        if (line_number && column)
+        {
+            locations.emplace_back(*line_number, *column);
+        }
+    }
+    return locations;
+}
+
+// Phases compile() runs after parsing, each only once no phase before it reported an error.
+enum CompilePhase
+{
+    ANALYZE = 1 << 0,
+    FOLD = 1 << 1,
+    GENERATE = 1 << 2,
+};
+
+// What a compiled program lives in, it must outlive the results of compile().
+struct Frontend
+{
+    ASTContext context;
+    TypeContext types;
+    StringInterner names;
+    std::unique_ptr<llvm::LLVMContext> llvm_context = std::make_unique<llvm::LLVMContext>();
+};
+
+struct Compiled
+{
+    ProgramNode *program;
+    std::unique_ptr<llvm::TargetMachine> target; ///< Only created to GENERATE.
+    std::unique_ptr<llvm::Module> module;        ///< Generated and optimized, if no phase reported an error.
+    std::vector<std::string> errors;
+    std::string diagnostics; ///< Every diagnostic as a line of JSON.
+};
+
+// Parse a source, run it through the phases and collect the errors they report.
+inline Compiled compile(Frontend &frontend, const std::string &source, const std::string &file_name, unsigned phases, OptimizationLevel level = O0)
+{
+    SourceManager sources;
+    PrintGlobalState print(sources);
+    std::ostringstream diagnostics;
+    print.setOutput(diagnostics);
+    print.setFormat(DiagnosticFormat::JSON);
+    FileID file = sources.addBuffer(source, file_name);
+    Lexer lexer(sources, file, frontend.names, print);
+    Parser parser(lexer, frontend.context, file, print);
+
+    Compiled result;
+    result.program = parser.parse();
+    EXPECT_FALSE(print.hasEncounteredError()) << diagnostics.str();
+    if ((phases & ANALYZE) && !print.hasEncounteredError())
+    {
+        bool clean = SemanticAnalyzer(frontend.types, frontend.names, print).analyze(result.program, file);
+        EXPECT_EQ(clean, !print.hasEncounteredError());
+    }
+    if ((phases & FOLD) && !print.hasEncounteredError())
+    {
+        bool clean = ConstantEvaluator(frontend.context, frontend.types, print, file).fold(result.program);
+        EXPECT_EQ(clean, !print.hasEncounteredError());
+    }
+    if ((phases & GENERATE) && !print.hasEncounteredError())
+    {
+        std::string error;
+        result.target = create_target_machine("", level, error);
+        EXPECT_TRUE(result.target) << error;
+        CodeGenerator generator(*frontend.llvm_context, frontend.names, print);
+        result.module = generator.generate(result.program, file, file_name, *result.target);
+        if (result.module)
+        {
+            optimize_module(*result.module, *result.target, level);
+        }
+    }
+    result.diagnostics = diagnostics.str();
+    result.errors = error_messages(result.diagnostics);
+    return result;
+}
+
+#endif
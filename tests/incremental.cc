@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <incremental.hh>
+#include <lexer.hh>
+#include <parser.hh>
+#include "helpers.hh"
+
+// Compare the session against lexing and parsing its current content from scratch.
+static void expect_fresh(const IncrementalSession &session, llvm::StringRef content, StringInterner &names)
+{
+    SourceManager sources;
+    PrintGlobalState print(sources);
+    FileID file = sources.addBuffer(content, "fresh.zx");
+    Lexer lexer(sources, file, names, print);
+    const auto &tokens = lexer.lex();
+    ASTContext context;
+    Parser parser(tokens, context, file, print);
+    ProgramNode *program = parser.parse();
+
+    const auto &incremental = session.getTokens();
+    ASSERT_EQ(incremental.size(), tokens.size());
+    for (size_t i = 0; i < tokens.size(); i++)
+    {
+        ASSERT_EQ(incremental[i].type, tokens[i].type) << i;
+        ASSERT_EQ(incremental[i].line, tokens[i].line) << i;
+        ASSERT_EQ(incremental[i].col, tokens[i].col) << i;
+        ASSERT_EQ(incremental[i].name, tokens[i].name) << i;
+        ASSERT_EQ(incremental[i].lexeme, tokens[i].lexeme) << i;
+    }
+    ASSERT_EQ(session.getProgram()->declarations.size(), program->declarations.size());
+    for (size_t i = 0; i < program->declarations.size(); i++)
+    {
+        ASSERT_EQ(declaration_name(session.getProgram()->declarations[i]), declaration_name(program->declarations[i]));
+    }
+}
+
+TEST(INCREMENTAL, LOCAL_EDIT_)
+{
+    SourceManager sources;
+    PrintGlobalState print(sources);
+    StringInterner names;
+    FileID file = sources.addBuffer(make_source(200), "incremental.zx");
+    IncrementalSession session(sources, file, names, print);
+    session.parse();
+    ASSERT_EQ(session.getProgram()->declarations.size(), 600u);
+
+    // Rename a variable in the middle of the file.
+    int_t offset = sources.getBuffer(file).find("i32 x = a + b * 100;") + 4;
+    session.applyEdit(TextEdit{offset, 1, "renamed"});
+    EXPECT_LE(session.getLastEditStats().relexed_tokens, 3u);
+    EXPECT_EQ(session.getLastEditStats().reparsed_declarations, 1u);
+    expect_fresh(session, sources.getBuffer(file), names);
+
+    // Add a declaration.
+    offset = sources.getBuffer(file).find("fn fn_150");
+    session.applyEdit(TextEdit{offset, 0, "enum Added { C }\n"});
+    EXPECT_LE(session.getLastEditStats().reparsed_declarations, 3u);
+    EXPECT_EQ(session.getProgram()->declarations.size(), 601u);
+    expect_fresh(session, sources.getBuffer(file), names);
+
+    // Open a comment swallowing the rest of the file, then close it again.
+    session.applyEdit(TextEdit{offset, 0, "/*"});
+    expect_fresh(session, sources.getBuffer(file), names);
+    session.applyEdit(TextEdit{offset, 2, ""});
+    expect_fresh(session, sources.getBuffer(file), names);
+}
+
+TEST(INCREMENTAL, RANDOM_EDITS_)
+{
+    static const std::string pieces[] = {" ", "\n", "{", "}", "(", ")", ";", "/*", "*/", "//", "\"", "'", "\\n", "a", "fn", "i32",
+                                         "x", "1", "1.5", "=", "==", "+", "struct", "enum", "loop"};
+    SourceManager sources;
+    PrintGlobalState print(sources);
+    print.setErrorLimit(1);
+    StringInterner names;
+    FileID file = sources.addBuffer(make_source(8), "incremental.zx");
+    IncrementalSession session(sources, file, names, print);
+    session.parse();
+
+    std::mt19937 random(42);
+    for (int i = 0; i < 2000; i++)
+    {
+        int_t size = sources.getBuffer(file).size();
+        int_t offset = random() % (size + 1);
+        int_t length = std::min<int_t>(random() % 4, size - offset);
+        std::string text = random() % 3 ? pieces[random() % std::size(pieces)] : "";
+        session.applyEdit(TextEdit{offset, length, text});
+        expect_fresh(session, sources.getBuffer(file), names);
+        if (HasFatalFailure())
+        {
+            FAIL() << "after edit " << i;
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include <backend.hh>
+#include <codegen.hh>
+#include <jit.hh>
+#include <lexer.hh>
+#include <parser.hh>
+#include <sema.hh>
+
+static llvm::orc::ThreadSafeModule generate(const std::string &source)
+{
+    SourceManager sources;
+    PrintGlobalState print(sources);
+    FileID file = sources.addBuffer(source, "jit.zx");
+    StringInterner names;
+    Lexer lexer(sources, file, names, print);
+    ASTContext context;
+    Parser parser(lexer.lex(), context, file, print);
+    ProgramNode *program = parser.parse();
+    TypeContext types;
+    EXPECT_TRUE(SemanticAnalyzer(types, names, print).analyze(program, file));
+
+    std::string error;
+    auto target = create_target_machine("", O0, error);
+    auto llvm_context = std::make_unique<llvm::LLVMContext>();
+    CodeGenerator generator(*llvm_context, names, print);
+    auto module = generator.generate(program, file, "jit.zx", *target);
+    EXPECT_TRUE(module);
+    EXPECT_FALSE(print.hasEncounteredError());
+    return llvm::orc::ThreadSafeModule(std::move(module), std::move(llvm_context));
+}
+
+TEST(JIT, RUN_MAIN_)
+{
+    std::vector<llvm::orc::ThreadSafeModule> modules;
+    modules.push_back(generate("fn unused(i64 a) -> i64 {\n    ret a / 3;\n}\n"
+                               "fn main() -> u8 {\n    i32 x = 40;\n    loop {\n        break;\n    }\n    ret x + 2;\n}\n"));
+    int exit_code = -1;
+    std::string error;
+    ASSERT_TRUE(run_main(std::move(modules), O0, exit_code, error)) << error;
+    EXPECT_EQ(exit_code, 42);
+}
+
+TEST(JIT, VOID_MAIN_)
+{
+    std::vector<llvm::orc::ThreadSafeModule> modules;
+    modules.push_back(generate("fn main() {\n    i32 x = 1;\n}\n"));
+    int exit_code = -1;
+    std::string error;
+    ASSERT_TRUE(run_main(std::move(modules), O2, exit_code, error)) << error;
+    EXPECT_EQ(exit_code, 0);
+}
+
+TEST(JIT, NO_MAIN_)
+{
+    std::vector<llvm::orc::ThreadSafeModule> modules;
+    modules.push_back(generate("fn f() {\n}\n"));
+    int exit_code = -1;
+    std::string error;
+    EXPECT_FALSE(run_main(std::move(modules), O0, exit_code, error));
+    EXPECT_FALSE(error.empty());
+}
@@ -0,0 +1,26 @@
+#include <gtest/gtest.h>
+#include <definitions.hh>
+
+TEST(LEXER_CLASSIFY, LEXER_CLASSIFY_DATATYPES) {
+    for (size_t i = 0; i < DATA_TYPES.size(); i++) {
+        WordInfo info = classify_word(DATA_TYPES[i]);
+        EXPECT_EQ(info.word_class, WordClass::DATATYPE);
+        EXPECT_EQ(info.index, i);
+    }
+    EXPECT_EQ(find_archdt("f80"), 2u);
+    EXPECT_EQ(find_archdt("u64"), std::nullopt);
+}
+
+TEST(LEXER_CLASSIFY, LEXER_CLASSIFY_KEYWORDS) {
+    for (size_t i = 0; i < KEYWORDS.size(); i++) {
+        WordInfo info = classify_word(KEYWORDS[i]);
+        EXPECT_EQ(info.word_class, WordClass::KEYWORD);
+        EXPECT_EQ(info.index, i);
+    }
+}
+
+TEST(LEXER_CLASSIFY, LEXER_CLASSIFY_IDENTIFIERS) {
+    for (auto word : {"", "i", "u9", "elf", "els", "matches", "continues", "Fn", "i32x", "volatilE"}) {
+        EXPECT_EQ(classify_word(word).word_class, WordClass::IDENTIFIER);
+    }
+}
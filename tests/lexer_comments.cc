@@ -2,8 +2,10 @@
 #include <lexer.hh>
 
 static const std::string file = "// This is a comment;\n/// Another comment\nfn";
-static PrintGlobalState print;
-static Lexer lex(file, "lexer_comments.zx", print);
+static SourceManager sources;
+static StringInterner names;
+static PrintGlobalState print(sources);
+static Lexer lex(sources, sources.addBuffer(file, "lexer_comments.zx"), names, print);
 static auto tokens = lex.lex();
 
 TEST(LEXER_COMMENT, LEXER_COMMENT_IGNORE_TEST) {
@@ -3,8 +3,10 @@
 
 static const std::string file = "if elif else loop fn ret true false ref deref struct sync enum void volatile null import break continue match"
                                 " IF ELIF ELSE LOOP FN RET TRUE FALSE REF DEREF STRUCT SYNC ENUM VOID VOLATILE NULL IMPORT BREAK CONTINUE MATCH";
-static PrintGlobalState print;
-static Lexer lex(file, "lexer_keywords.zx", print);
+static SourceManager sources;
+static StringInterner names;
+static PrintGlobalState print(sources);
+static Lexer lex(sources, sources.addBuffer(file, "lexer_keywords.zx"), names, print);
 static const auto tokens = lex.lex();
 
 TEST(LEXER_KEYWORDS, LEXER_KEYWORD_) {
@@ -13,6 +15,13 @@ TEST(LEXER_KEYWORDS, LEXER_KEYWORD_) {
     }
 }
 
+TEST(LEXER_KEYWORDS, LEXER_KEYWORD_KIND_) {
+    EXPECT_EQ(tokens[0].keyword(), KW_IF);
+    EXPECT_EQ(tokens[4].keyword(), KW_FN);
+    EXPECT_EQ(tokens[19].keyword(), KW_MATCH);
+    EXPECT_EQ(tokens[20].keyword(), KW_NONE);
+}
+
 TEST(LEXER_KEYWORDS, LEXER_ID_) {
     for (int i = 20;i < tokens.size() - 1;i++) {
         EXPECT_EQ(tokens[i].type, TK_ID);
@@ -0,0 +1,27 @@
+#include <gtest/gtest.h>
+#include <lexer.hh>
+
+static const std::string file = "; , : { } [ ] ( ) = += -= *= /= %= ^= &= |= || && == != < > <= >= | & << >> + - * / % ^ ! ~ ++ -- ->";
+static SourceManager sources;
+static StringInterner names;
+static PrintGlobalState print(sources);
+static Lexer lex(sources, sources.addBuffer(file, "lexer_kinds.zx"), names, print);
+static const auto tokens = lex.lex();
+
+TEST(LEXER_KINDS, LEXER_SEPARATOR_KIND_) {
+    for (int i = 0; i < 9; i++) {
+        EXPECT_EQ(tokens[i].type, TK_SEPARATOR);
+        EXPECT_EQ(tokens[i].separator(), static_cast<Separator>(SEP_SEMICOLON + i));
+        EXPECT_EQ(tokens[i].op(), Operator::NONE);
+    }
+}
+
+TEST(LEXER_KINDS, LEXER_OPERATOR_KIND_) {
+    for (size_t i = 9; i < tokens.size() - 1; i++) {
+        EXPECT_EQ(tokens[i].type, TK_OPERATOR);
+        EXPECT_EQ(tokens[i].op(), static_cast<Operator>(static_cast<int>(Operator::ASSIGN) + i - 9)) << tokens[i].lexeme;
+        EXPECT_EQ(tokens[i].separator(), SEP_NONE);
+    }
+    EXPECT_EQ(tokens.size() - 1, 9 + static_cast<size_t>(Operator::COUNT) - 1);
+    EXPECT_FALSE(print.hasEncounteredError());
+}
@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <scan.hh>
+
+// Every kernel has to agree with the scalar one, no matter where a run ends.
+TEST(LEXER_SCAN, LEXER_SCAN_MATCHES_SCALAR) {
+    const ScanKernels &fast = get_scan_kernels();
+    const ScanKernels &scalar = get_scalar_scan_kernels();
+    const std::string alphabet = " \t\n\r_azAZ09.xeE+-\"\\*/;{\x80\xff";
+
+    std::mt19937 rng(42);
+    for (int run = 0; run < 2000; run++) {
+        std::string text(rng() % 200, ' ');
+        // Long runs of one character class, sprinkled with others.
+        char fill = alphabet[rng() % alphabet.size()];
+        for (auto &c : text) {
+            c = rng() % 8 ? fill : alphabet[rng() % alphabet.size()];
+        }
+        const char *begin = text.data();
+        const char *end = text.data() + text.size();
+
+        for (size_t start = 0; start < text.size(); start += 1 + rng() % 40) {
+            const char *p = begin + start;
+            size_t fast_lines = 0, scalar_lines = 0;
+            EXPECT_EQ(fast.skip_whitespace(p, end, fast_lines), scalar.skip_whitespace(p, end, scalar_lines));
+            EXPECT_EQ(fast_lines, scalar_lines);
+            EXPECT_EQ(fast.scan_identifier(p, end), scalar.scan_identifier(p, end));
+            EXPECT_EQ(fast.scan_number(p, end), scalar.scan_number(p, end));
+            EXPECT_EQ(fast.find_string_end(p, end), scalar.find_string_end(p, end));
+            fast_lines = scalar_lines = 0;
+            EXPECT_EQ(fast.find_comment_end(p, end, fast_lines), scalar.find_comment_end(p, end, scalar_lines));
+            EXPECT_EQ(fast_lines, scalar_lines);
+        }
+    }
+}
+
+TEST(LEXER_SCAN, LEXER_SCAN_CHAR_CLASSES) {
+    for (int c = 0; c < 256; c++) {
+        EXPECT_EQ(has_char_class(c, CC_SPACE), bool(isspace(c)));
+        EXPECT_EQ(has_char_class(c, CC_IDENT), bool(isalnum(c) || c == '_'));
+        EXPECT_EQ(has_char_class(c, CC_DIGIT), bool(isdigit(c)));
+    }
+}
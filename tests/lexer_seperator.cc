@@ -4,13 +4,17 @@
 static const std::string file = "({[;]}),:";
 
 TEST(LEXER_SEPERATOR,LEXER_SEPERATOR) {
-    PrintGlobalState print;
-    Lexer lex(file,"lexer_seperator.zx",print);
-    auto tokens = lex.lex();
-    int i = 0;
-    for (;i < file.length() - 1;i++) {
-        EXPECT_EQ(tokens[i].type, TK_SEPERATOR);
+    SourceManager sources;
+    StringInterner names;
+    PrintGlobalState print(sources);
+    Lexer lex(sources, sources.addBuffer(file, "lexer_seperator.zx"), names, print);
+    const auto &tokens = lex.lex();
+    ASSERT_EQ(tokens.size(), file.length() + 1);
+    size_t i = 0;
+    for (; i < file.length(); i++) {
+        EXPECT_EQ(tokens[i].type, TK_SEPARATOR);
+        EXPECT_EQ(tokens[i].separator(), classify_separator(file[i]));
     }
-    EXPECT_EQ(tokens[++i].type, TK_ERR);
-    
-}
\ No newline at end of file
+    EXPECT_EQ(tokens[i].type, __EOF);
+    EXPECT_FALSE(print.hasEncounteredError());
+}
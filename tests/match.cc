@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <jit.hh>
+#include <lexer.hh>
+#include <parser.hh>
+#include <llvm/IR/Instructions.h>
+#include "helpers.hh"
+
+// Run every phase of the frontend on a program, generate it without optimizations and run its main.
+static int run(const std::string &source)
+{
+    Frontend frontend;
+    Compiled compiled = compile(frontend, source, "match.zx", ANALYZE | FOLD | GENERATE);
+    EXPECT_TRUE(compiled.module) << (compiled.errors.empty() ? "" : compiled.errors[0]);
+    std::vector<llvm::orc::ThreadSafeModule> modules;
+    modules.emplace_back(std::move(compiled.module), std::move(frontend.llvm_context));
+    int exit_code = -1;
+    std::string error;
+    EXPECT_TRUE(run_main(std::move(modules), O0, exit_code, error)) << error;
+    return exit_code;
+}
+
+template <typename T>
+static std::vector<T *> instructions(llvm::Function *function)
+{
+    std::vector<T *> found;
+    for (llvm::BasicBlock &block : *function)
+    {
+        for (llvm::Instruction &instruction : block)
+        {
+            if (auto *match = llvm::dyn_cast<T>(&instruction))
+            {
+                found.push_back(match);
+            }
+        }
+    }
+    return found;
+}
+
+TEST(MATCH, PARSE_)
+{
+    SourceManager sources;
+    PrintGlobalState print(sources);
+    FileID file = sources.addBuffer("fn f(i32 x) {\n    match (x + 1) { 1: { } 'a': { } _: { ret; } }\n}\n", "match.zx");
+    StringInterner names;
+    Lexer lexer(sources, file, names, print);
+    ASTContext context;
+    Parser parser(lexer, context, file, print);
+    ProgramNode *program = parser.parse();
+    ASSERT_FALSE(print.hasEncounteredError());
+    auto *function = llvm::cast<FunctionDeclarationNode>(program->declarations[0]);
+    auto *match = llvm::cast<MatchStatementNode>(function->body->statements[0]);
+    EXPECT_TRUE(llvm::isa<BinaryExprNode>(match->subject));
+    ASSERT_EQ(match->cases.size(), 2u);
+    EXPECT_EQ(match->cases[1]->literal->type, TokenType::TKL_CHAR);
+    // The default case is not mistaken for a case, although '_' is an identifier.
+    ASSERT_TRUE(match->default_block);
+    EXPECT_EQ(match->default_block->statements.size(), 1u);
+}
+
+TEST(MATCH, LOWERING_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend, "fn dense(i32 x) -> i32 {\n"
+                              "    match (x) { 3: { ret 30; } 1: { ret 10; } 2: { ret 20; } 4: { ret 40; } 6: { ret 60; } }\n"
+                              "    ret 0;\n"
+                              "}\n"
+                              "fn sparse(u64 x) -> i32 {\n"
+                              "    match (x) { 10: { ret 1; } 1000: { ret 2; } 100000: { ret 3; } 10000000: { ret 4; } _: { ret 5; } }\n"
+                              "}\n"
+                              "fn mixed(char c) -> i32 {\n"
+                              "    match (c) { 'a': { ret 1; } 'b': { ret 2; } 'c': { ret 3; } 'd': { ret 4; } 200: { ret 5; } }\n"
+                              "    ret 0;\n"
+                              "}\n",
+                              "match.zx", ANALYZE | FOLD | GENERATE);
+    ASSERT_TRUE(result.module) << (result.errors.empty() ? "" : result.errors[0]);
+
+    // Dense cases become a single switch, which the backend lowers to a jump table.
+    llvm::Function *dense = result.module->getFunction("dense");
+    auto *table = llvm::dyn_cast<llvm::SwitchInst>(dense->getEntryBlock().getTerminator());
+    ASSERT_TRUE(table);
+    EXPECT_EQ(table->getNumCases(), 5u);
+    EXPECT_TRUE(instructions<llvm::ICmpInst>(dense).empty());
+
+    // Sparse cases become a balanced tree: one compare splits them, one more finds each case.
+    llvm::Function *sparse = result.module->getFunction("sparse");
+    EXPECT_TRUE(instructions<llvm::SwitchInst>(sparse).empty());
+    auto *root = llvm::dyn_cast<llvm::ICmpInst>(llvm::cast<llvm::BranchInst>(sparse->getEntryBlock().getTerminator())->getCondition());
+    ASSERT_TRUE(root);
+    EXPECT_EQ(root->getPredicate(), llvm::ICmpInst::ICMP_ULT);
+    EXPECT_EQ(llvm::cast<llvm::ConstantInt>(root->getOperand(1))->getZExtValue(), 100000u);
+    EXPECT_EQ(instructions<llvm::ICmpInst>(sparse).size(), 1u + 2u + 4u);
+
+    // A dense run of cases is a switch next to the cases outside of it.
+    std::vector<llvm::SwitchInst *> tables = instructions<llvm::SwitchInst>(result.module->getFunction("mixed"));
+    ASSERT_EQ(tables.size(), 1u);
+    EXPECT_EQ(tables[0]->getNumCases(), 4u);
+}
+
+TEST(MATCH, RUN_)
+{
+    // Every case of a state machine is taken once, other values take the default case.
+    EXPECT_EQ(run("fn main() -> i32 {\n"
+                  "    i32 i = 0;\n"
+                  "    i32 taken = 0;\n"
+                  "    i32 other = 0;\n"
+                  "    loop {\n"
+                  "        if (i == 300) { break; }\n"
+                  "        match (i) {\n"
+                  "            0: { taken += 1; } 1: { taken += 2; } 2: { taken += 4; } 3: { taken += 8; }\n"
+                  "            100: { taken += 16; } 'A': { taken += 32; } 250: { taken += 64; }\n"
+                  "            _: { other += 1; }\n"
+                  "        }\n"
+                  "        ++i;\n"
+                  "    }\n"
+                  "    ret taken + (other - 293) * 1000;\n"
+                  "}\n"),
+              127);
+    // Unsigned subjects are ordered unsigned, values past the signed maximum still find their case.
+    EXPECT_EQ(run("fn main() -> i32 {\n"
+                  "    u8 x = 250;\n"
+                  "    match (x) { 1: { ret 1; } 2: { ret 2; } 130: { ret 3; } 250: { ret 4; } 255: { ret 5; } }\n"
+                  "    ret 0;\n"
+                  "}\n"),
+              4);
+    // A string is a literal, the case it takes is chosen at compile time.
+    EXPECT_EQ(run("fn main() -> i32 {\n"
+                  "    match (\"ab\") { \"a\": { ret 1; } \"ab\": { ret 2; } _: { ret 3; } }\n"
+                  "}\n"),
+              2);
+}
+
+TEST(MATCH, ERRORS_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend, "fn f(i32 x, u8 small, f64 real) {\n"
+                              "    match (x) { 1: { } 2: { } 0x1: { } 'A': { } 65: { } }\n"
+                              "    match (\"on\") { \"on\": { } \"off\": { } \"on\": { } }\n"
+                              "    match (small) { 255: { } 256: { } }\n"
+                              "    match (x) { 1.5: { } \"one\": { } }\n"
+                              "    match (real) { 1: { } }\n"
+                              "}\n",
+                              "match.zx", ANALYZE | FOLD | GENERATE);
+    EXPECT_FALSE(result.module);
+    // Semantic errors are reported first, evaluating the cases is only tried on a valid program.
+    std::vector<std::string> expected = {
+        "Cannot convert 'f64' to 'i32'.",
+        "Cannot convert 'char[3]' to 'i32'.",
+        "Cannot match on a value of type 'f64'.",
+    };
+    EXPECT_EQ(result.errors, expected);
+
+    result = compile(frontend, "fn f(i32 x, u8 small) {\n"
+                     "    match (x) { 1: { } 2: { } 0x1: { } 'A': { } 65: { } }\n"
+                     "    match (\"on\") { \"on\": { } \"off\": { } \"on\": { } }\n"
+                     "    match (small) { 255: { } 256: { } }\n"
+                     "}\n",
+                     "match.zx", ANALYZE | FOLD | GENERATE);
+    EXPECT_FALSE(result.module);
+    expected = {
+        "Duplicate case 1 in match statement.",
+        "Duplicate case 65 in match statement.",
+        "Duplicate case \"on\" in match statement.",
+        "Constant '256' overflows 'u8'.",
+    };
+    EXPECT_EQ(result.errors, expected);
+}
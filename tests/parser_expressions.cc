@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <functional>
+#include <sstream>
+#include <lexer.hh>
+#include <parser.hh>
+
+// Parenthesizes every operation of the expression statement in `source`.
+static std::string parse_expression(const std::string &source)
+{
+    SourceManager sources;
+    PrintGlobalState print(sources);
+    std::ostringstream diagnostics;
+    print.setOutput(diagnostics);
+    FileID file = sources.addBuffer("fn f() {\n    " + source + ";\n}\n", "expressions.zx");
+    StringInterner names;
+    Lexer lexer(sources, file, names, print);
+    ASTContext context;
+    Parser parser(lexer.lex(), context, file, print);
+    ProgramNode *program = parser.parse();
+    EXPECT_FALSE(print.hasEncounteredError()) << diagnostics.str();
+
+    auto *function = llvm::dyn_cast<FunctionDeclarationNode>(program->declarations[0]);
+    auto *statement = llvm::dyn_cast<ExpressionStatementNode>(function->body->statements[0]);
+    std::function<std::string(const ExpressionNode *)> render = [&](const ExpressionNode *expression) -> std::string
+    {
+        if (auto *binary = llvm::dyn_cast<BinaryExprNode>(expression))
+        {
+            return "(" + render(binary->left) + " " + std::string(operator_info(binary->op).spelling) + " " + render(binary->right) + ")";
+        }
+        if (auto *unary = llvm::dyn_cast<UnaryExprNode>(expression))
+        {
+            return "(" + std::string(operator_info(unary->op).spelling) + render(unary->operand) + ")";
+        }
+        if (auto *identifier = llvm::dyn_cast<IdentifierNode>(expression))
+        {
+            return names.get(identifier->name).str();
+        }
+        return static_cast<const LiteralNode *>(expression)->value.str();
+    };
+    return render(statement->expression);
+}
+
+TEST(PARSER_EXPRESSIONS, PRECEDENCE_)
+{
+    EXPECT_EQ(parse_expression("a + b * c"), "(a + (b * c))");
+    EXPECT_EQ(parse_expression("a * b ^ c"), "(a * (b ^ c))");
+    EXPECT_EQ(parse_expression("a << b + c"), "(a << (b + c))");
+    EXPECT_EQ(parse_expression("a & b << c"), "(a & (b << c))");
+    EXPECT_EQ(parse_expression("a | b & c"), "(a | (b & c))");
+    EXPECT_EQ(parse_expression("a < b | c"), "(a < (b | c))");
+    EXPECT_EQ(parse_expression("a == b < c"), "(a == (b < c))");
+    EXPECT_EQ(parse_expression("a && b != c"), "(a && (b != c))");
+    EXPECT_EQ(parse_expression("a || b && c"), "(a || (b && c))");
+    EXPECT_EQ(parse_expression("a = b || c"), "(a = (b || c))");
+    EXPECT_EQ(parse_expression("(a + b) * c"), "((a + b) * c)");
+}
+
+TEST(PARSER_EXPRESSIONS, ASSOCIATIVITY_)
+{
+    EXPECT_EQ(parse_expression("a - b - c"), "((a - b) - c)");
+    EXPECT_EQ(parse_expression("a / b % c"), "((a / b) % c)");
+    EXPECT_EQ(parse_expression("a >= b <= c"), "((a >= b) <= c)");
+    EXPECT_EQ(parse_expression("a ^ b ^ c"), "(a ^ (b ^ c))");
+    EXPECT_EQ(parse_expression("a = b += c"), "(a = (b += c))");
+}
+
+TEST(PARSER_EXPRESSIONS, UNARY_)
+{
+    EXPECT_EQ(parse_expression("-a ^ 2"), "((-a) ^ 2)");
+    EXPECT_EQ(parse_expression("a ^ -b"), "(a ^ (-b))");
+    EXPECT_EQ(parse_expression("~a * !b"), "((~a) * (!b))");
+    EXPECT_EQ(parse_expression("++a + -(-b)"), "((++a) + (-(-b)))");
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <lexer.hh>
+#include <parser.hh>
+#include "helpers.hh"
+
+struct Parsed
+{
+    std::vector<NameID> names;
+    size_t nodes;
+    std::string diagnostics;
+};
+
+// Parse the source on the pool, or on the calling thread without one.
+static Parsed parse(const std::string &source, ThreadPool *pool)
+{
+    SourceManager sources;
+    PrintGlobalState print(sources);
+    std::ostringstream diagnostics;
+    print.setOutput(diagnostics);
+    FileID file = sources.addBuffer(source, "parallel.zx");
+    StringInterner names;
+    Lexer lexer(sources, file, names, print);
+    const auto &tokens = lexer.lex();
+
+    ASTContext context;
+    Parser parser(tokens, context, file, print);
+    ProgramNode *program = pool ? parser.parse(*pool) : parser.parse();
+    Parsed result{{}, context.getNodeCount(), diagnostics.str()};
+    for (DeclarationNode *declaration : program->declarations)
+    {
+        result.names.push_back(declaration_name(declaration));
+    }
+    return result;
+}
+
+static void expect_same(const std::string &source)
+{
+    ThreadPool pool(4);
+    Parsed sequential = parse(source, nullptr);
+    Parsed parallel = parse(source, &pool);
+    EXPECT_EQ(parallel.names, sequential.names);
+    EXPECT_EQ(parallel.nodes, sequential.nodes);
+    EXPECT_EQ(parallel.diagnostics, sequential.diagnostics);
+}
+
+TEST(PARSER_PARALLEL, SAME_TREE_)
+{
+    std::string source = make_source(2000);
+    Parsed sequential = parse(source, nullptr);
+    ASSERT_EQ(sequential.names.size(), 6000u);
+    EXPECT_TRUE(sequential.diagnostics.empty());
+    expect_same(source);
+}
+
+TEST(PARSER_PARALLEL, ERRORS_IN_ORDER_)
+{
+    std::string source = make_source(2000);
+    source.replace(source.find("b * 10;"), 7, "b * ;");
+    source.replace(source.find("b * 1900;"), 9, "b * 1900");
+    expect_same(source);
+}
+
+TEST(PARSER_PARALLEL, UNBALANCED_BRACES_)
+{
+    std::string source = make_source(2000);
+    source.replace(source.find("ret x;\n}", source.find("fn_500(")), 8, "ret x;\n");
+    expect_same(source);
+    source = make_source(2000);
+    source.insert(source.find("fn fn_1500("), "}\n");
+    expect_same(source);
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+#include <lexer.hh>
+#include <parser.hh>
+#include "helpers.hh"
+
+struct Parsed
+{
+    ProgramNode *program;
+    std::vector<std::string> errors;
+};
+
+static Parsed parse(const std::string &source, ASTContext &context, int_t error_limit = 20)
+{
+    SourceManager sources;
+    PrintGlobalState print(sources);
+    print.setErrorLimit(error_limit);
+    std::ostringstream diagnostics;
+    print.setOutput(diagnostics);
+    print.setFormat(DiagnosticFormat::JSON);
+    FileID file = sources.addBuffer(source, "recovery.zx");
+    StringInterner names;
+    Lexer lexer(sources, file, names, print);
+    Parser parser(lexer, context, file, print);
+
+    Parsed result;
+    result.program = parser.parse();
+    result.errors = error_messages(diagnostics.str());
+    return result;
+}
+
+TEST(PARSER_RECOVERY, STATEMENT_)
+{
+    ASTContext context;
+    Parsed result = parse("fn f() {\n"
+                          "    i32 x = 1 + ) * 2;\n"
+                          "    i32 y = 2;\n"
+                          "    ret y;\n"
+                          "}\n"
+                          "fn g() {\n"
+                          "}\n",
+                          context);
+    ASSERT_EQ(result.errors.size(), 1u);
+    EXPECT_EQ(result.errors[0], "Expected an expression but found ')'.");
+    ASSERT_EQ(result.program->declarations.size(), 2u);
+    auto *f = static_cast<FunctionDeclarationNode *>(result.program->declarations[0]);
+    EXPECT_EQ(f->body->statements.size(), 2u);
+}
+
+TEST(PARSER_RECOVERY, MISSING_BRACE_)
+{
+    ASTContext context;
+    Parsed result = parse("fn f() {\n"
+                          "    if (1) {\n"
+                          "        ret;\n"
+                          "}\n"
+                          "fn g() {\n"
+                          "    ret;\n"
+                          "}\n",
+                          context);
+    ASSERT_EQ(result.errors.size(), 1u);
+    EXPECT_EQ(result.errors[0], "Expected '}' but found 'fn'.");
+    ASSERT_EQ(result.program->declarations.size(), 1u);
+}
+
+TEST(PARSER_RECOVERY, DECLARATION_)
+{
+    ASTContext context;
+    Parsed result = parse("i32 x = 1;\n"
+                          "struct S { i32 a, f64 b }\n"
+                          "enum E { A B }\n"
+                          "fn f(i32 a i32 b) {\n"
+                          "}\n",
+                          context);
+    ASSERT_EQ(result.errors.size(), 2u);
+    EXPECT_EQ(result.errors[0], "Expected 'fn', 'struct' or 'enum' but found 'i32'.");
+    EXPECT_EQ(result.errors[1], "Expected ')' but found 'i32'.");
+    EXPECT_EQ(result.program->declarations.size(), 2u);
+}
+
+TEST(PARSER_RECOVERY, ERROR_LIMIT_)
+{
+    std::string source = "fn f() {\n";
+    for (int i = 0; i < 10000; i++)
+    {
+        source += "    i32 = ;\n";
+    }
+    source += "}\n";
+    ASTContext context;
+    Parsed result = parse(source, context, 5);
+    ASSERT_EQ(result.errors.size(), 6u);
+    EXPECT_EQ(result.errors.back(), "too many errors emitted, stopping now.");
+}
+
+TEST(PARSER_RECOVERY, TERMINATES_)
+{
+    // Random token soup must neither hang nor crash the parser.
+    const char *pieces[] = {"fn", "struct", "enum", "if", "elif", "else", "loop", "match", "ret", "break", "continue", "i32",
+                            "x", "1", "'c'", "\"s\"", "(", ")", "{", "}", "[", "]", ";", ",", ":", "=", "+", "->", "_"};
+    std::mt19937 random(7);
+    for (int round = 0; round < 200; round++)
+    {
+        std::string source;
+        for (int i = 0; i < 200; i++)
+        {
+            source += pieces[random() % std::size(pieces)];
+            source += ' ';
+        }
+        ASTContext context;
+        parse(source, context, 0);
+    }
+}
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+#include "helpers.hh"
+
+TEST(SEMA, TYPES_)
+{
+    TypeContext types;
+    StringInterner names;
+    const PrimitiveType *i32 = types.getPrimitive("i32");
+    ASSERT_NE(i32, nullptr);
+    EXPECT_EQ(types.getPrimitive("i32"), i32);
+    EXPECT_EQ(i32->bits, 32u);
+    EXPECT_TRUE(i32->is_signed);
+    EXPECT_FALSE(types.getPrimitive("u8")->is_signed);
+    EXPECT_TRUE(types.getPrimitive("f80")->isFloat());
+    EXPECT_EQ(types.getPrimitive("bool")->getKind(), Type::TYPE_BOOL);
+    EXPECT_EQ(types.getPrimitive("point"), nullptr);
+
+    // Arithmetic takes the wider operand, unsigned if either is, and integers become floats.
+    EXPECT_EQ(types.getArithmeticType(types.getPrimitive("u8"), types.getPrimitive("i64")), types.getPrimitive("u64"));
+    EXPECT_EQ(types.getArithmeticType(i32, types.getPrimitive("i16")), i32);
+    EXPECT_EQ(types.getArithmeticType(types.getPrimitive("i64"), types.getPrimitive("f32")), types.getPrimitive("f32"));
+
+    EXPECT_EQ(types.getArray(i32, 4), types.getArray(types.getPrimitive("i32"), 4));
+    EXPECT_NE(types.getArray(i32, 4), types.getArray(i32, 5));
+    // Structs are nominal, equal fields do not make equal types.
+    NameID point = names.intern("Point");
+    EXPECT_NE(types.createStruct(point), types.createStruct(point));
+    EXPECT_EQ(TypeContext::getName(types.getArray(types.createStruct(point), 3), names), "struct Point[3]");
+}
+
+TEST(SEMA, EXPRESSIONS_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend, "struct Point { i32 x, struct Size size }\n"
+                              "struct Size { i32 width }\n"
+                              "fn f(i8 small, f32 real, struct Point p) -> i64 {\n"
+                              "    i64 wide = small + 1;\n"
+                              "    f32 mixed = small * real;\n"
+                              "    struct Point q = p;\n"
+                              "    loop { if (!(wide < 2) && mixed) { break; } }\n"
+                              "    ret wide << 2;\n"
+                              "}\n",
+                              "sema.zx", ANALYZE);
+    EXPECT_TRUE(result.errors.empty());
+
+    auto *f = llvm::cast<FunctionDeclarationNode>(result.program->declarations[2]);
+    llvm::ArrayRef<StatementNode *> body = f->body->statements;
+    // The literal takes the type expected by the variable, the sum the wider one of its operands.
+    auto *wide = llvm::cast<VarDeclarationNode>(body[0])->initializer;
+    EXPECT_EQ(wide->value_type, frontend.types.getPrimitive("i64"));
+    EXPECT_EQ(llvm::cast<BinaryExprNode>(wide)->left->value_type, frontend.types.getPrimitive("i8"));
+    EXPECT_EQ(llvm::cast<VarDeclarationNode>(body[1])->initializer->value_type, frontend.types.getPrimitive("f32"));
+    auto *copy = llvm::cast<VarDeclarationNode>(body[2])->initializer;
+    ASSERT_TRUE(llvm::isa<StructType>(copy->value_type));
+    auto *structure = llvm::cast<StructType>(copy->value_type);
+    ASSERT_EQ(structure->fields.size(), 2u);
+    // Fields may be of a struct declared later, and declared types are resolved on their nodes.
+    ASSERT_TRUE(llvm::isa<StructType>(structure->fields[1].type));
+    EXPECT_EQ(frontend.names.get(llvm::cast<StructType>(structure->fields[1].type)->name), "Size");
+    EXPECT_EQ(f->parameters[2]->type->resolved_type, structure);
+    EXPECT_EQ(f->return_type->resolved_type, frontend.types.getPrimitive("i64"));
+    auto *condition = llvm::cast<IfStatementNode>(llvm::cast<LoopStatementNode>(body[3])->body->statements[0])->condition;
+    EXPECT_EQ(condition->value_type, frontend.types.getPrimitive("bool"));
+}
+
+TEST(SEMA, KEYWORD_LITERALS_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend, "fn f() -> bool {\n"
+                              "    bool yes = true;\n"
+                              "    i64 none = null;\n"
+                              "    f32 zero = null;\n"
+                              "    ret false;\n"
+                              "}\n",
+                              "sema.zx", ANALYZE);
+    EXPECT_TRUE(result.errors.empty());
+
+    // 'true' and 'false' are bools, 'null' is the zero of the scalar it initializes.
+    llvm::ArrayRef<StatementNode *> body = llvm::cast<FunctionDeclarationNode>(result.program->declarations[0])->body->statements;
+    EXPECT_EQ(llvm::cast<VarDeclarationNode>(body[0])->initializer->value_type, frontend.types.getPrimitive("bool"));
+    EXPECT_EQ(llvm::cast<VarDeclarationNode>(body[1])->initializer->value_type, frontend.types.getPrimitive("i64"));
+    EXPECT_EQ(llvm::cast<VarDeclarationNode>(body[2])->initializer->value_type, frontend.types.getPrimitive("f32"));
+    EXPECT_EQ(llvm::cast<RetStatementNode>(body[3])->value->value_type, frontend.types.getPrimitive("bool"));
+
+    std::vector<std::string> expected = {"Cannot infer the type of 'null'."};
+    EXPECT_EQ(compile(frontend, "fn g() {\n    null;\n}\n", "sema.zx", ANALYZE).errors, expected);
+}
+
+TEST(SEMA, ERRORS_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend, "struct Point { i32 x }\n"
+                              "enum Color { RED, GREEN }\n"
+                              "fn f(i32 a) -> i32 {\n"
+                              "    i32 b = missing + a * 2;\n"
+                              "    i32 b = 1;\n"
+                              "    struct Point p = a;\n"
+                              "    enum Point q;\n"
+                              "    f32 x = 1.5 | a;\n"
+                              "    a = f;\n"
+                              "    3 = a;\n"
+                              "    break;\n"
+                              "    ret;\n"
+                              "}\n"
+                              "fn g() {\n"
+                              "    enum Color c = 1;\n"
+                              "    loop { continue; }\n"
+                              "    ret c;\n"
+                              "}\n",
+                              "sema.zx", ANALYZE);
+    std::vector<std::string> expected = {
+        "Unknown identifier 'missing'.",
+        "Redeclaration of 'b'.",
+        "Cannot convert 'i32' to 'struct Point'.",
+        "Unknown type 'enum Point'.",
+        "Invalid floating point operands to binary operator '|'.",
+        "'f' is not a variable.",
+        "Operand of '=' must be a variable.",
+        "'break' is only allowed inside of a loop.",
+        "Missing return value of type 'i32'.",
+        "Function has no return type but returns a value.",
+    };
+    EXPECT_EQ(result.errors, expected);
+
+    // A struct holding itself, directly or through another struct, has no finite size.
+    expected = {"Struct 'Node' contains itself.", "Struct 'Pair' contains itself.", "Struct 'Other' contains itself."};
+    EXPECT_EQ(compile(frontend, "struct Node { i32 x, struct Node next }\n"
+                      "struct Pair { struct Other other }\n"
+                      "struct Other { struct Pair pair }\n",
+                      "sema.zx", ANALYZE).errors, expected);
+}
+
+TEST(SEMA, MISSING_RETURN_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend, "fn none() -> i32 {\n    i32 x = 1;\n}\n"
+                              "fn some(i32 a) -> i32 {\n    if (a) { ret 1; } elif (a > 2) { ret 2; }\n}\n"
+                              "fn every(i32 a) -> i32 {\n    if (a) { ret 1; } elif (a > 2) { ret 2; } else { ret 3; }\n}\n"
+                              "fn forever() -> i32 {\n    loop { }\n}\n"
+                              "fn escapes(i32 a) -> i32 {\n    loop { match (a) { 1: { break; } _: { ret 2; } } }\n}\n"
+                              "fn cases(i32 a) -> i32 {\n    match (a) { 1: { ret 1; } _: { loop { continue; } } }\n}\n"
+                              "fn nothing() {\n}\n",
+                              "sema.zx", ANALYZE);
+    // Control reaching the end of a function with a return type is an error, the function is blamed.
+    std::vector<std::string> expected = {
+        "Function 'none' can end without returning a value of type 'i32'.",
+        "Function 'some' can end without returning a value of type 'i32'.",
+        "Function 'escapes' can end without returning a value of type 'i32'.",
+    };
+    EXPECT_EQ(result.errors, expected);
+    std::vector<std::pair<int64_t, int64_t>> locations = {{1, 1}, {4, 1}, {13, 1}};
+    EXPECT_EQ(diagnostic_locations(result.diagnostics), locations);
+}
+
+TEST(SEMA, LOCATIONS_)
+{
+    Frontend frontend;
+    Compiled result = compile(frontend, "fn f(i32 a) {\n"
+                              "    i32 b = a + missing;\n"
+                              "    f32 x = 1.5 | a;\n"
+                              "    break;\n"
+                              "}\n",
+                              "sema.zx", ANALYZE);
+    // Errors point at the offending identifier, the operator and the statement.
+    std::vector<std::pair<int64_t, int64_t>> expected = {{2, 17}, {3, 17}, {4, 5}};
+    EXPECT_EQ(diagnostic_locations(result.diagnostics), expected);
+}
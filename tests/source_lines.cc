@@ -0,0 +1,38 @@
+#include <gtest/gtest.h>
+#include <source.hh>
+
+static const std::string file = "fn main() {\n    ret 0;\r\n}";
+
+TEST(SOURCE_MANAGER, SOURCE_MANAGER_LINES) {
+    SourceManager sources;
+    FileID id = sources.addBuffer(file, "source_lines.zx");
+    EXPECT_EQ(sources.getLineCount(id), 3u);
+    EXPECT_EQ(sources.getLineOffset(id, 2), 12u);
+    EXPECT_EQ(sources.getLine(id, 1), "fn main() {");
+    EXPECT_EQ(sources.getLine(id, 2), "    ret 0;");
+    EXPECT_EQ(sources.getLine(id, 3), "}");
+    EXPECT_TRUE(sources.getLine(id, 4).empty());
+}
+
+TEST(SOURCE_MANAGER, SOURCE_MANAGER_MISSING_FILE) {
+    SourceManager sources;
+    EXPECT_FALSE(sources.loadFile("does_not_exist.zx").has_value());
+}
+
+TEST(SOURCE_MANAGER, SOURCE_MANAGER_LINE_AND_COLUMN) {
+    SourceManager sources;
+    std::string content;
+    for (int i = 0; i < 100; i++) {
+        content += "fn f() {}\n";
+    }
+    FileID id = sources.addBuffer(content, "source_lines_long.zx");
+    EXPECT_EQ(sources.getLineCount(id), 101u);
+    EXPECT_EQ(sources.getLineAndColumn(id, 0).first, 1u);
+    EXPECT_EQ(sources.getLineAndColumn(id, 0).second, 1u);
+    EXPECT_EQ(sources.getLineAndColumn(id, 9).first, 1u);
+    EXPECT_EQ(sources.getLineAndColumn(id, 9).second, 10u);
+    EXPECT_EQ(sources.getLineAndColumn(id, 10).first, 2u);
+    EXPECT_EQ(sources.getLineAndColumn(id, 10).second, 1u);
+    EXPECT_EQ(sources.getLineAndColumn(id, 995).first, 100u);
+    EXPECT_EQ(sources.getLineAndColumn(id, 995).second, 6u);
+}
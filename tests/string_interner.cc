@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+#include <interner.hh>
+#include <lexer.hh>
+
+TEST(STRING_INTERNER, INTERN_)
+{
+    StringInterner names;
+    NameID a = names.intern("alpha");
+    NameID b = names.intern("beta");
+    EXPECT_NE(a, b);
+    EXPECT_NE(a, 0u);
+    EXPECT_EQ(names.intern(std::string("alpha")), a);
+    EXPECT_EQ(names.get(a), "alpha");
+    EXPECT_EQ(names.get(b), "beta");
+    EXPECT_EQ(names.intern(""), 0u);
+}
+
+TEST(STRING_INTERNER, STABLE_)
+{
+    StringInterner names;
+    std::vector<NameID> ids;
+    for (int i = 0; i < 10000; i++)
+    {
+        ids.push_back(names.intern("name" + std::to_string(i)));
+    }
+    for (int i = 0; i < 10000; i++)
+    {
+        EXPECT_EQ(names.get(ids[i]), "name" + std::to_string(i));
+    }
+    EXPECT_EQ(names.size(), 10001u);
+}
+
+TEST(STRING_INTERNER, LEXER_IDS_)
+{
+    SourceManager sources;
+    StringInterner names;
+    PrintGlobalState print(sources);
+    Lexer lex(sources, sources.addBuffer("count total count i32 total", "string_interner.zx"), names, print);
+    const auto &tokens = lex.lex();
+    ASSERT_EQ(tokens.size(), 6u);
+    EXPECT_EQ(tokens[0].name, tokens[2].name);
+    EXPECT_EQ(tokens[1].name, tokens[4].name);
+    EXPECT_NE(tokens[0].name, tokens[1].name);
+    EXPECT_EQ(tokens[3].name, 0u); // Only identifiers are interned.
+    EXPECT_EQ(names.get(tokens[1].name), "total");
+}
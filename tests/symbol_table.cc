@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <table.hh>
+
+static SourceManager sources;
+static PrintGlobalState print(sources);
+static StringInterner names;
+
+static Symbol make_symbol(NameID name, int_t level)
+{
+    return Symbol{name, SymbolType::VARIABLE, level, 0};
+}
+
+TEST(SYMBOL_TABLE, SHADOWING_)
+{
+    SymbolTable table(print, names);
+    NameID x = names.intern("x"), y = names.intern("y");
+    table.enterScope();
+    table.insert(x, make_symbol(x, 1));
+    table.enterScope();
+    table.insert(x, make_symbol(x, 2));
+    table.insert(y, make_symbol(y, 2));
+    EXPECT_EQ(table.get(x).level, 2);
+    EXPECT_TRUE(table.check(y));
+    table.exitScope();
+    EXPECT_EQ(table.get(x).level, 1);
+    EXPECT_FALSE(table.check(y));
+    table.exitScope();
+    EXPECT_FALSE(table.check(x));
+}
+
+TEST(SYMBOL_TABLE, REDECLARATION_)
+{
+    SymbolTable table(print, names);
+    NameID x = names.intern("x");
+    table.enterScope();
+    table.insert(x, make_symbol(x, 1));
+    table.insert(x, make_symbol(x, 2));
+    EXPECT_EQ(table.get(x).level, 1);
+    table.exitScope();
+}
+
+TEST(SYMBOL_TABLE, MANY_NAMES_)
+{
+    SymbolTable table(print, names);
+    std::vector<NameID> ids;
+    for (int i = 0; i < 5000; i++)
+    {
+        ids.push_back(names.intern("local" + std::to_string(i)));
+    }
+    table.enterScope();
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        if (i % 100 == 0)
+        {
+            table.enterScope();
+        }
+        table.insert(ids[i], make_symbol(ids[i], i));
+    }
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        Symbol symbol;
+        ASSERT_TRUE(table.lookup(ids[i], symbol));
+        EXPECT_EQ(symbol.level, i);
+    }
+    for (int i = 0; i < 50; i++)
+    {
+        table.exitScope();
+    }
+    EXPECT_FALSE(table.check(ids[0]));
+    EXPECT_FALSE(table.check(ids.back()));
+    table.exitScope();
+}
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <driver.hh>
+#include <threadpool.hh>
+
+TEST(THREAD_POOL, RUN_ALL_)
+{
+    std::atomic<int> count(0);
+    ThreadPool pool(4);
+    for (int i = 0; i < 1000; i++)
+    {
+        pool.submit([&count]()
+                    { count++; });
+    }
+    pool.wait();
+    EXPECT_EQ(count, 1000);
+}
+
+TEST(THREAD_POOL, NESTED_SUBMIT_)
+{
+    std::atomic<int> count(0);
+    ThreadPool pool(3);
+    for (int i = 0; i < 50; i++)
+    {
+        pool.submit([&pool, &count]()
+                    {
+            for (int j = 0; j < 20; j++)
+            {
+                pool.submit([&count]()
+                            { count++; });
+            } });
+    }
+    pool.wait();
+    EXPECT_EQ(count, 1000);
+
+    // The pool can be reused once it is idle.
+    pool.submit([&count]()
+                { count++; });
+    pool.wait();
+    EXPECT_EQ(count, 1001);
+}
+
+TEST(THREAD_POOL, RUN_ALL_FROM_JOBS_)
+{
+    // Every worker waits on jobs of its own, which only finish because waiting workers run them.
+    std::atomic<int> count(0);
+    ThreadPool pool(2);
+    for (int i = 0; i < 8; i++)
+    {
+        pool.submit([&pool, &count]()
+                    {
+            std::vector<int> parts(16);
+            pool.runAll(parts.size(), [&](size_t j)
+                        { parts[j] = 1; });
+            for (int part : parts)
+            {
+                count += part;
+            } });
+    }
+    pool.wait();
+    EXPECT_EQ(count, 8 * 16);
+}
+
+TEST(DRIVER, DETERMINISTIC_DIAGNOSTICS_)
+{
+    std::vector<std::string> files;
+    for (int i = 0; i < 16; i++)
+    {
+        std::string name = ::testing::TempDir() + "driver_" + std::to_string(i) + ".zx";
+        std::ofstream out(name);
+        out << "fn f" << i << "(i32 a) {\n    i32 x = a * " << i << ";\n}\nenum E" << i << " { A, B }\n";
+        if (i % 3 == 0)
+        {
+            out << "} error " << i << "\n";
+        }
+        files.push_back(name);
+    }
+
+    std::string expected;
+    for (unsigned jobs : {1u, 2u, 4u, 8u})
+    {
+        DriverOptions options;
+        options.stage = C;
+        options.jobs = jobs;
+        std::ostringstream diagnostics;
+        Driver driver(options, diagnostics);
+        EXPECT_EQ(driver.run(files), 1);
+        if (jobs == 1)
+        {
+            expected = diagnostics.str();
+            EXPECT_NE(expected.find("driver_0.zx"), std::string::npos);
+            EXPECT_EQ(expected.find("driver_1.zx"), std::string::npos);
+            EXPECT_LT(expected.find("driver_3.zx"), expected.find("driver_15.zx"));
+        }
+        EXPECT_EQ(diagnostics.str(), expected);
+    }
+
+    for (const std::string &name : files)
+    {
+        std::remove(name.c_str());
+    }
+}
+
+TEST(DRIVER, MISSING_FILE_)
+{
+    DriverOptions options;
+    std::ostringstream diagnostics;
+    Driver driver(options, diagnostics);
+    EXPECT_EQ(driver.run({"does_not_exist.zx"}), 127);
+    EXPECT_NE(diagnostics.str().find("does_not_exist.zx"), std::string::npos);
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
+#include <timing.hh>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+TEST(TIME_REPORT, TABLE_)
+{
+    TimeReport report;
+    {
+        TimeReport::Scope lex(&report, TimeReport::LEX, "a.zx");
+    }
+    {
+        TimeReport::Scope parse(&report, TimeReport::PARSE, "a.zx");
+    }
+    report.count(TimeReport::LEX, 100);
+
+    std::ostringstream out;
+    report.print(out);
+    EXPECT_NE(out.str().find("Lex"), std::string::npos);
+    EXPECT_NE(out.str().find("Parse"), std::string::npos);
+    EXPECT_NE(out.str().find("100 tokens"), std::string::npos);
+    // Phases which never ran are left out.
+    EXPECT_EQ(out.str().find("Optimization"), std::string::npos);
+
+    // Lexing while parsing reports the rates of both.
+    {
+        TimeReport::Scope lex_parse(&report, TimeReport::LEX_PARSE, "b.zx");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    report.count(TimeReport::LEX_PARSE, 50, 20);
+    out.str("");
+    report.print(out);
+    std::string table = out.str();
+    size_t row = table.find("Lex+Parse");
+    ASSERT_NE(row, std::string::npos);
+    std::string line = table.substr(row, table.find('\n', row) - row);
+    EXPECT_NE(line.find("tokens/s"), std::string::npos) << line;
+    EXPECT_NE(line.find("nodes/s"), std::string::npos) << line;
+    EXPECT_NE(table.find("150 tokens, 20 AST nodes"), std::string::npos) << table;
+
+    // Without a report a scope does nothing.
+    TimeReport::Scope ignored(nullptr, TimeReport::EMIT, "a.zx");
+}
+
+TEST(TIME_REPORT, TRACE_)
+{
+    TimeReport report;
+    for (int i = 0; i < 3; i++)
+    {
+        TimeReport::Scope timer(&report, TimeReport::CODEGEN, "file" + std::to_string(i));
+    }
+    std::string path = ::testing::TempDir() + "trace.json";
+    std::string error;
+    ASSERT_TRUE(report.writeTrace(path, error)) << error;
+
+    auto buffer = llvm::MemoryBuffer::getFile(path);
+    ASSERT_TRUE(buffer);
+    auto trace = llvm::json::parse((*buffer)->getBuffer());
+    ASSERT_TRUE(bool(trace));
+    const llvm::json::Array *events = trace->getAsObject()->getArray("traceEvents");
+    ASSERT_TRUE(events);
+    ASSERT_EQ(events->size(), 3u);
+    EXPECT_EQ((*events)[0].getAsObject()->getString("ph"), llvm::StringRef("X"));
+    EXPECT_EQ((*events)[2].getAsObject()->getObject("args")->getString("detail"), llvm::StringRef("file2"));
+    std::remove(path.c_str());
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <lexer.hh>
+#include <parser.hh>
+
+static const std::string file = "fn main(i32 a, u8 b) -> i32 {\n"
+                                "    i32 x = a * (b + 1) ^ 2; // comment\n"
+                                "    loop {\n"
+                                "        if (x >= 10 && b != 'c') {\n"
+                                "            break;\n"
+                                "        }\n"
+                                "        x += 1;\n"
+                                "    }\n"
+                                "    ret x;\n"
+                                "}\n"
+                                "enum E { A, B }\n"
+                                "struct S { i32 a, f64 b }\n";
+
+TEST(TOKEN_STREAM, NEXT_)
+{
+    SourceManager sources;
+    PrintGlobalState print(sources);
+    StringInterner names;
+    FileID id = sources.addBuffer(file, "token_stream.zx");
+    Lexer whole(sources, id, names, print);
+    const std::vector<Token> &tokens = whole.lex();
+
+    Lexer streamed(sources, id, names, print);
+    for (const Token &expected : tokens)
+    {
+        Token token = streamed.next();
+        EXPECT_EQ(token.type, expected.type);
+        EXPECT_EQ(token.kind, expected.kind);
+        EXPECT_EQ(token.name, expected.name);
+        EXPECT_EQ(token.line, expected.line);
+        EXPECT_EQ(token.lexeme, expected.lexeme);
+    }
+    EXPECT_EQ(streamed.next().type, TokenType::__EOF);
+}
+
+TEST(TOKEN_STREAM, PARSE_)
+{
+    SourceManager sources;
+    PrintGlobalState print(sources);
+    std::ostringstream diagnostics;
+    print.setOutput(diagnostics);
+    StringInterner names;
+    FileID id = sources.addBuffer(file, "token_stream.zx");
+
+    Lexer whole(sources, id, names, print);
+    ASTContext whole_context;
+    Parser whole_parser(whole.lex(), whole_context, id, print);
+    ProgramNode *expected = whole_parser.parse();
+
+    Lexer streamed(sources, id, names, print);
+    ASTContext context;
+    Parser parser(streamed, context, id, print);
+    ProgramNode *program = parser.parse();
+
+    EXPECT_FALSE(print.hasEncounteredError()) << diagnostics.str();
+    EXPECT_EQ(program->declarations.size(), expected->declarations.size());
+    EXPECT_EQ(context.getNodeCount(), whole_context.getNodeCount());
+    EXPECT_EQ(parser.token_count(), whole.getTokens().size());
+    // Only the token lexed last is held by the lexer.
+    EXPECT_LE(streamed.getTokens().size(), 1u);
+}